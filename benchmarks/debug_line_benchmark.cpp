@@ -0,0 +1,81 @@
+// Measures the resolution of a 32-frame stack trace to source lines, with
+// the index of the line table already built (see roo_logging/debug_line.h):
+// with LookupDebugLine() alone, and with the full Symbolize(), which also
+// finds the object file and the symbol name for each frame.
+
+#include <execinfo.h>
+#include <fcntl.h>
+#include <link.h>
+#include <unistd.h>
+
+#include "benchmark/benchmark.h"
+#include "roo_logging.h"
+#include "roo_logging/debug_line.h"
+#include "roo_logging/symbolize.h"
+
+namespace {
+
+constexpr int kFrames = 32;
+
+__attribute__((noinline)) int CaptureTrace(void** trace, int depth) {
+  if (depth > 1) {
+    int frames = CaptureTrace(trace, depth - 1);
+    benchmark::DoNotOptimize(trace);
+    return frames;
+  }
+  return backtrace(trace, kFrames);
+}
+
+uintptr_t LoadBias() {
+  uintptr_t bias = 0;
+  dl_iterate_phdr(
+      [](dl_phdr_info* info, size_t, void* data) {
+        *static_cast<uintptr_t*>(data) = info->dlpi_addr;
+        return 1;
+      },
+      &bias);
+  return bias;
+}
+
+void BM_LookupTrace(benchmark::State& state) {
+  void* trace[kFrames];
+  int frames = CaptureTrace(trace, kFrames);
+  int fd = open("/proc/self/exe", O_RDONLY);
+  uintptr_t bias = LoadBias();
+  const char* file;
+  int line;
+  int found = 0;
+  for (int i = 0; i < frames; ++i) {
+    uintptr_t pc = reinterpret_cast<uintptr_t>(trace[i]) - 1;
+    found += roo_logging::LookupDebugLine(fd, pc - bias, &file, &line);
+  }
+  for (auto _ : state) {
+    for (int i = 0; i < frames; ++i) {
+      uintptr_t pc = reinterpret_cast<uintptr_t>(trace[i]) - 1;
+      benchmark::DoNotOptimize(
+          roo_logging::LookupDebugLine(fd, pc - bias, &file, &line));
+    }
+  }
+  close(fd);
+  state.SetItemsProcessed(state.iterations() * frames);
+  state.counters["resolved"] = found;
+}
+BENCHMARK(BM_LookupTrace);
+
+void BM_SymbolizeTrace(benchmark::State& state) {
+  void* trace[kFrames];
+  int frames = CaptureTrace(trace, kFrames);
+  char out[1024];
+  for (auto _ : state) {
+    for (int i = 0; i < frames; ++i) {
+      benchmark::DoNotOptimize(roo_logging::Symbolize(
+          static_cast<char*>(trace[i]) - 1, out, sizeof(out)));
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * frames);
+}
+BENCHMARK(BM_SymbolizeTrace);
+
+}  // namespace
+
+BENCHMARK_MAIN();
@@ -0,0 +1,124 @@
+// Measures the throughput of the demangler on the regression corpus
+// (test/demangle_corpus.txt, or the file given as the first argument), with
+// and without the cache, with the bounded (explicit stack) parser, and on a
+// stack-trace-like workload, in which the same few dozen symbols repeat.
+
+#include <stdio.h>
+#include <string.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+#include "roo_logging.h"
+#include "roo_logging/demangle.h"
+
+namespace {
+
+std::vector<std::string>& Corpus() {
+  static std::vector<std::string> corpus;
+  return corpus;
+}
+
+bool ReadCorpus(const char* path) {
+  FILE* in = fopen(path, "r");
+  if (in == nullptr) {
+    perror(path);
+    return false;
+  }
+  char line[8192];
+  while (fgets(line, sizeof(line), in) != nullptr) {
+    if (line[0] == '#') continue;
+    line[strcspn(line, "\t\n")] = '\0';
+    if (line[0] != '\0') Corpus().push_back(line);
+  }
+  fclose(in);
+  return !Corpus().empty();
+}
+
+size_t CorpusBytes(const std::vector<std::string>& names) {
+  size_t bytes = 0;
+  for (const std::string& name : names) bytes += name.size();
+  return bytes;
+}
+
+void BM_Demangle(benchmark::State& state) {
+  const std::vector<std::string>& names = Corpus();
+  char out[256];
+  for (auto _ : state) {
+    for (const std::string& name : names) {
+      benchmark::DoNotOptimize(
+          roo_logging::Demangle(name.c_str(), out, sizeof(out)));
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * names.size());
+  state.SetBytesProcessed(state.iterations() * CorpusBytes(names));
+}
+BENCHMARK(BM_Demangle);
+
+void BM_DemangleCached(benchmark::State& state) {
+  const std::vector<std::string>& names = Corpus();
+  char out[256];
+  roo_logging::ClearDemangleCache();
+  for (auto _ : state) {
+    for (const std::string& name : names) {
+      benchmark::DoNotOptimize(
+          roo_logging::DemangleCached(name.c_str(), out, sizeof(out)));
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * names.size());
+  state.SetBytesProcessed(state.iterations() * CorpusBytes(names));
+}
+BENCHMARK(BM_DemangleCached);
+
+void BM_DemangleBounded(benchmark::State& state) {
+  const std::vector<std::string>& names = Corpus();
+  char out[256];
+  for (auto _ : state) {
+    for (const std::string& name : names) {
+      benchmark::DoNotOptimize(
+          roo_logging::DemangleBounded(name.c_str(), out, sizeof(out)));
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * names.size());
+  state.SetBytesProcessed(state.iterations() * CorpusBytes(names));
+}
+BENCHMARK(BM_DemangleBounded);
+
+// The 32 longest names, as in a deep stack trace that keeps recurring.
+std::vector<std::string> TraceNames() {
+  std::vector<std::string> names = Corpus();
+  std::sort(names.begin(), names.end(),
+            [](const std::string& a, const std::string& b) {
+              return a.size() > b.size();
+            });
+  if (names.size() > 32) names.resize(32);
+  return names;
+}
+
+void BM_DemangleTrace(benchmark::State& state) {
+  std::vector<std::string> names = TraceNames();
+  bool cached = state.range(0) != 0;
+  char out[256];
+  roo_logging::ClearDemangleCache();
+  for (auto _ : state) {
+    for (const std::string& name : names) {
+      benchmark::DoNotOptimize(
+          cached ? roo_logging::DemangleCached(name.c_str(), out, sizeof(out))
+                 : roo_logging::Demangle(name.c_str(), out, sizeof(out)));
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * names.size());
+  state.SetLabel(cached ? "cached" : "uncached");
+}
+BENCHMARK(BM_DemangleTrace)->Arg(0)->Arg(1);
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  benchmark::Initialize(&argc, argv);
+  if (!ReadCorpus(argc > 1 ? argv[1] : "test/demangle_corpus.txt")) return 1;
+  benchmark::RunSpecifiedBenchmarks();
+  return 0;
+}
@@ -0,0 +1,125 @@
+// Compares the printf-free floating-point formatting (FormatDouble,
+// FormatFloat) against the printf("%g") path previously used by the stream
+// operators, and against printf("%.17g"), which is what it takes for printf
+// to produce output that round-trips.
+
+#include <stdio.h>
+#include <string.h>
+
+#include <vector>
+
+#include "benchmark/benchmark.h"
+#include "roo_logging.h"
+#include "roo_logging/dtoa.h"
+
+namespace {
+
+// A mix of 'typical' sensor-like values, and random bit patterns.
+const std::vector<double>& Inputs() {
+  static std::vector<double>* inputs = [] {
+    std::vector<double>* v = new std::vector<double>();
+    uint64_t x = 88172645463325252ull;
+    for (int i = 0; i < 1024; ++i) {
+      x ^= x << 13;
+      x ^= x >> 7;
+      x ^= x << 17;
+      if (i % 2 == 0) {
+        v->push_back((double)(x % 100000) / 100.0);
+      } else {
+        double d;
+        memcpy(&d, &x, sizeof(d));
+        if (d != d) d = 1.0;
+        v->push_back(d);
+      }
+    }
+    return v;
+  }();
+  return *inputs;
+}
+
+void BM_FormatDouble(benchmark::State& state) {
+  const std::vector<double>& in = Inputs();
+  char buf[roo_logging::kMaxFloatChars];
+  size_t i = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(
+        roo_logging::FormatDouble(in[i++ % in.size()], buf));
+    benchmark::ClobberMemory();
+  }
+}
+BENCHMARK(BM_FormatDouble);
+
+void BM_FormatFloat(benchmark::State& state) {
+  const std::vector<double>& in = Inputs();
+  char buf[roo_logging::kMaxFloatChars];
+  size_t i = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(
+        roo_logging::FormatFloat((float)in[i++ % in.size()], buf));
+    benchmark::ClobberMemory();
+  }
+}
+BENCHMARK(BM_FormatFloat);
+
+void BM_FormatFixed2(benchmark::State& state) {
+  const std::vector<double>& in = Inputs();
+  char buf[roo_logging::kMaxFloatChars];
+  size_t i = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(
+        roo_logging::FormatFixed(in[i++ % in.size()], 2, buf));
+    benchmark::ClobberMemory();
+  }
+}
+BENCHMARK(BM_FormatFixed2);
+
+void BM_SnprintfG(benchmark::State& state) {
+  const std::vector<double>& in = Inputs();
+  char buf[roo_logging::kMaxFloatChars];
+  size_t i = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(
+        snprintf(buf, sizeof(buf), "%g", in[i++ % in.size()]));
+    benchmark::ClobberMemory();
+  }
+}
+BENCHMARK(BM_SnprintfG);
+
+void BM_SnprintfRoundTrip(benchmark::State& state) {
+  const std::vector<double>& in = Inputs();
+  char buf[roo_logging::kMaxFloatChars];
+  size_t i = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(
+        snprintf(buf, sizeof(buf), "%.17g", in[i++ % in.size()]));
+    benchmark::ClobberMemory();
+  }
+}
+BENCHMARK(BM_SnprintfRoundTrip);
+
+// End-to-end, through the log stream.
+void BM_StreamDouble(benchmark::State& state) {
+  const std::vector<double>& in = Inputs();
+  size_t i = 0;
+  for (auto _ : state) {
+    roo_logging::OStringStream s;
+    s << in[i++ % in.size()];
+    benchmark::DoNotOptimize(s.pcount());
+  }
+}
+BENCHMARK(BM_StreamDouble);
+
+void BM_StreamPrintfG(benchmark::State& state) {
+  const std::vector<double>& in = Inputs();
+  size_t i = 0;
+  for (auto _ : state) {
+    roo_logging::OStringStream s;
+    s.printf("%g", in[i++ % in.size()]);
+    benchmark::DoNotOptimize(s.pcount());
+  }
+}
+BENCHMARK(BM_StreamPrintfG);
+
+}  // namespace
+
+BENCHMARK_MAIN();
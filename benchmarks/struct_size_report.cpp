@@ -0,0 +1,27 @@
+// Reports the sizes of the per-message data structures, for the build
+// configuration (e.g. ROO_LOGGING_MAX_MESSAGE_LEN) that it is compiled with.
+// The 'metadata' is everything besides the message text buffer.
+
+#include <stdio.h>
+
+#include "roo_logging.h"
+#include "roo_logging/log_message_data.h"
+
+int main() {
+  using roo_logging::LogMessage;
+  const size_t text = roo_logging::kMaxLogMessageLen + 1;
+  printf("ROO_LOGGING_MAX_MESSAGE_LEN:  %u\n",
+         (unsigned)roo_logging::kMaxLogMessageLen);
+  printf("sizeof(void*):                %u\n", (unsigned)sizeof(void*));
+  printf("sizeof(Stream):               %u\n",
+         (unsigned)sizeof(roo_logging::Stream));
+  printf("sizeof(LogMessageData):       %u (metadata: %u)\n",
+         (unsigned)sizeof(LogMessage::LogMessageData),
+         (unsigned)(sizeof(LogMessage::LogMessageData) - text));
+  printf("sizeof(OStringStream):        %u\n",
+         (unsigned)sizeof(roo_logging::OStringStream));
+  printf("sizeof(LogMessage):           %u\n", (unsigned)sizeof(LogMessage));
+  printf("sizeof(ConfigSnapshot):       %u\n",
+         (unsigned)sizeof(roo_logging::ConfigSnapshot));
+  return 0;
+}
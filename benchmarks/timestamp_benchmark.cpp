@@ -0,0 +1,50 @@
+// Measures the per-message cost of taking timestamps, for each of the
+// timestamp sources (see roo_logging/timestamp.h): the uptime alone, and the
+// uptime plus the wall time, which is what each message takes (once, and
+// shares between the prefix and the sink).
+
+#include "benchmark/benchmark.h"
+#include "roo_logging.h"
+#include "roo_logging/timestamp.h"
+
+namespace {
+
+// A wall time clock that, like most real ones, reads a system clock on each
+// call.
+class BenchmarkClock : public roo_time::WallTimeClock {
+ public:
+  roo_time::WallTime now() const override {
+    return roo_time::WallTime(roo_time::Uptime::Now() -
+                              roo_time::Uptime::Start());
+  }
+};
+
+void SetLabel(benchmark::State& state) {
+  static const char* const kNames[] = {"precise", "coarse", "cycles"};
+  state.SetLabel(kNames[state.range(0)]);
+}
+
+void BM_Uptime(benchmark::State& state) {
+  auto source = (roo_logging::TimestampSource)state.range(0);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(roo_logging::TimestampNow(source));
+  }
+  SetLabel(state);
+}
+BENCHMARK(BM_Uptime)->DenseRange(0, 2);
+
+void BM_UptimeAndWallTime(benchmark::State& state) {
+  auto source = (roo_logging::TimestampSource)state.range(0);
+  BenchmarkClock clock;
+  for (auto _ : state) {
+    roo_time::Uptime uptime = roo_logging::TimestampNow(source);
+    benchmark::DoNotOptimize(
+        roo_logging::WallTimeAt(&clock, source, uptime));
+  }
+  SetLabel(state);
+}
+BENCHMARK(BM_UptimeAndWallTime)->DenseRange(0, 2);
+
+}  // namespace
+
+BENCHMARK_MAIN();
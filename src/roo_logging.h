@@ -85,6 +85,15 @@
 ///     // that can't be accomplished with just VLOG(2) << ...;
 ///   }
 ///
+/// If built with ROO_LOGGING_RUNTIME_VLOG=1, the verbosity levels can also be
+/// adjusted at run time, per file and per module (see roo_logging/vlog.h):
+///
+///   roo_logging::SetVLOGLevel("wifi_*", 2);
+///   roo_logging::SetMLOGLevel("my_module", 1);
+///
+/// In that mode, MLOG_IS_ON() can no longer be used in preprocessor
+/// conditionals.
+///
 /// There are also VLOG_IF, VLOG_EVERY_N and VLOG_IF_EVERY_N "verbose level"
 /// condition macros, as well as the corresponding MLOG_IF, MLOG_EVERY_N, and
 /// MLOG_IF_EVERY_N for per-module logging, for simple cases when some extra
@@ -137,6 +146,7 @@
 #include "roo_logging/log_message.h"
 #include "roo_logging/log_severity.h"
 #include "roo_logging/predict.h"
+#include "roo_logging/sampling.h"
 #include "roo_logging/stream.h"
 #include "roo_time.h"
 
@@ -243,6 +253,20 @@
   SOME_KIND_OF_LOG_IF_EVERY_N(severity, (condition), (n), \
                               ::roo_logging::LogMessage::SendToLog)
 
+/// Logs randomly, with the specified probability (e.g. 0.001 logs about one
+/// in a thousand executions). Unlike LOG_EVERY_N, it does not alias with
+/// periodic workloads. The decision uses a lock-free per-thread PRNG, so it
+/// is cheap enough for hot paths. Emitted messages carry the rate as the
+/// 'sample_rate' structured field, so that counts can be scaled back up.
+#define LOG_SAMPLED(severity, rate) LOG_IF_SAMPLED(severity, true, (rate))
+
+#define LOG_IF_SAMPLED(severity, condition, rate)                        \
+  LOG_IF(severity,                                                       \
+         (condition) && ::roo_logging::internal::ShouldSample(           \
+                            ::roo_logging::internal::SamplingThreshold(  \
+                                (rate))))                                \
+      .kv("sample_rate", (double)(rate))
+
 /// Plus some debug-logging macros that get compiled to nothing for production
 
 #if DCHECK_IS_ON()
@@ -345,12 +369,20 @@
 #define VLOG_IF_EVERY_N(verboselevel, condition, n) \
   LOG_IF_EVERY_N(INFO, (condition) && VLOG_IS_ON(verboselevel), n)
 
+#define VLOG_SAMPLED(verboselevel, rate) \
+  LOG_IF_SAMPLED(INFO, VLOG_IS_ON(verboselevel), rate)
+
 /// Verbose logging per-module (e.g. switch on/off for individual libraries).
 
 #define __ROO_LOGGING_CAT(a, b) a##b
 #define ROO_LOGGING_CAT(a, b) __ROO_LOGGING_CAT(a, b)
 
+#if ROO_LOGGING_RUNTIME_VLOG
+#define MLOG_IS_ON(module) \
+  (ROO_LOGGING_SITE_LEVEL(#module, ROO_LOGGING_CAT(MLOG_, module)) > 0)
+#else
 #define MLOG_IS_ON(module) (ROO_LOGGING_CAT(MLOG_, module) > 0)
+#endif
 #define MLOG(module) LOG_IF(INFO, MLOG_IS_ON(module))
 
 #define MLOG_IF(module, condition) \
@@ -0,0 +1,166 @@
+#include "roo_logging/async_sink.h"
+
+#include <stdio.h>
+
+#include <utility>
+
+namespace roo_logging {
+
+AsyncSink::AsyncSink(LogSink& target, size_t info_capacity,
+                     size_t warning_capacity, size_t error_capacity)
+    : target_(target), in_flight_(false), stop_(false), fatal_delivered_(0) {
+  lanes_[kInfoLane].capacity = info_capacity;
+  lanes_[kWarningLane].capacity = warning_capacity;
+  lanes_[kErrorLane].capacity = error_capacity;
+  thread_ = roo::thread([this] { run(); });
+}
+
+AsyncSink::~AsyncSink() {
+  {
+    roo::lock_guard<roo::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  nonempty_.notify_all();
+  thread_.join();
+}
+
+bool AsyncSink::empty() const {
+  for (const LaneState& lane : lanes_) {
+    if (!lane.queue.empty()) return false;
+  }
+  return true;
+}
+
+void AsyncSink::send(LogSeverity severity, const char* full_filename,
+                     const char* base_filename, int line,
+                     roo_time::Uptime uptime, roo_time::WallTime walltime,
+                     const char* message, size_t message_len) {
+  enqueue(LogRecord{0, severity, full_filename, base_filename, line, uptime,
+                    walltime, message, message_len, LogFields()});
+}
+
+void AsyncSink::sendRecord(const LogRecord& record) { enqueue(record); }
+
+void AsyncSink::enqueue(const LogRecord& record) {
+  if (record.severity >= ROO_LOGGING_FATAL) {
+    {
+      roo::lock_guard<roo::mutex> lock(deliver_mutex_);
+      // The errors and warnings leading up to the crash go first, in case
+      // the process dies before WaitTillSent() gets to deliver them.
+      drain(kWarningLane);
+      target_.sendRecord(record);
+      target_.WaitTillSent();
+    }
+    roo::lock_guard<roo::mutex> lock(mutex_);
+    ++fatal_delivered_;
+    return;
+  }
+  LaneState& lane = lanes_[record.severity < 0 ? kInfoLane : record.severity];
+  // The text rendering of the fields directly follows the message.
+  size_t message_len = record.message_len + record.fields.text_size();
+  {
+    roo::lock_guard<roo::mutex> lock(mutex_);
+    size_t cost = sizeof(Record) + message_len;
+    if (lane.bytes + cost > lane.capacity) {
+      ++lane.dropped;
+      ++lane.unreported_drops;
+      return;
+    }
+    lane.queue.push_back(Record{record.sequence, record.severity,
+                                record.full_filename, record.base_filename,
+                                record.line, record.uptime, record.walltime,
+                                std::string(record.message, message_len)});
+    lane.bytes += cost;
+  }
+  nonempty_.notify_one();
+}
+
+void AsyncSink::deliver(const Record& record, uint64_t dropped) {
+  if (dropped > 0) {
+    char note[48];
+    int note_len = snprintf(note, sizeof(note), "[%llu messages dropped]",
+                            (unsigned long long)dropped);
+    target_.sendRecord(LogRecord{0, record.severity, __FILE__,
+                                 "async_sink.cpp", __LINE__, record.uptime,
+                                 record.walltime, note, (size_t)note_len,
+                                 LogFields()});
+  }
+  target_.sendRecord(LogRecord{record.sequence, record.severity,
+                               record.full_filename, record.base_filename,
+                               record.line, record.uptime, record.walltime,
+                               record.message.data(), record.message.size(),
+                               LogFields()});
+}
+
+void AsyncSink::drain(Lane lowest) {
+  roo::unique_lock<roo::mutex> lock(mutex_);
+  for (int i = kNumLanes - 1; i >= lowest; --i) {
+    LaneState& lane = lanes_[i];
+    while (!lane.queue.empty()) {
+      Record record = std::move(lane.queue.front());
+      lane.queue.pop_front();
+      lane.bytes -= record.cost();
+      uint64_t dropped = lane.unreported_drops;
+      lane.unreported_drops = 0;
+      lock.unlock();
+      deliver(record, dropped);
+      lock.lock();
+      ++lane.delivered;
+    }
+  }
+  if (empty()) drained_.notify_all();
+}
+
+void AsyncSink::run() {
+  roo::unique_lock<roo::mutex> lock(mutex_);
+  while (true) {
+    nonempty_.wait(lock, [this] { return stop_ || !empty(); });
+    // Taken before the record is dequeued, so that whoever holds it (e.g.
+    // the FATAL path in enqueue()) sees all undelivered records in the lanes.
+    lock.unlock();
+    roo::lock_guard<roo::mutex> deliver_lock(deliver_mutex_);
+    lock.lock();
+    int i = kNumLanes - 1;
+    while (i >= 0 && lanes_[i].queue.empty()) --i;
+    if (i < 0) {
+      if (stop_) break;  // Stopped, with nothing left to deliver.
+      continue;          // Drained by a FATAL message in the meantime.
+    }
+    LaneState& lane = lanes_[i];
+    Record record = std::move(lane.queue.front());
+    lane.queue.pop_front();
+    lane.bytes -= record.cost();
+    uint64_t dropped = lane.unreported_drops;
+    lane.unreported_drops = 0;
+    in_flight_ = true;
+    lock.unlock();
+    deliver(record, dropped);
+    lock.lock();
+    in_flight_ = false;
+    ++lane.delivered;
+    if (empty()) drained_.notify_all();
+  }
+}
+
+void AsyncSink::WaitTillSent() {
+  {
+    roo::unique_lock<roo::mutex> lock(mutex_);
+    drained_.wait(lock, [this] { return empty() && !in_flight_; });
+  }
+  roo::lock_guard<roo::mutex> lock(deliver_mutex_);
+  target_.WaitTillSent();
+}
+
+AsyncSink::LaneStats AsyncSink::stats(Lane lane) const {
+  roo::lock_guard<roo::mutex> lock(mutex_);
+  const LaneState& state = lanes_[lane];
+  return LaneStats{state.queue.size(), state.bytes, state.capacity,
+                   state.delivered, state.dropped};
+}
+
+uint64_t AsyncSink::fatal_delivered() const {
+  roo::lock_guard<roo::mutex> lock(mutex_);
+  return fatal_delivered_;
+}
+
+}  // namespace roo_logging
@@ -0,0 +1,141 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <deque>
+#include <string>
+
+#include "roo_logging/sink.h"
+#include "roo_threads.h"
+#include "roo_threads/condition_variable.h"
+#include "roo_threads/mutex.h"
+#include "roo_threads/thread.h"
+#include "roo_time.h"
+
+namespace roo_logging {
+
+/// A LogSink that delivers messages to another (target) sink on a background
+/// thread, so that logging does not wait for slow output (e.g. a serial port,
+/// or a network).
+///
+/// Messages are queued in separate lanes by severity (INFO, WARNING, and
+/// ERROR), each with its own capacity, so that a burst of INFO messages can't
+/// take the space reserved for errors. The background thread always delivers
+/// from the most severe non-empty lane first; therefore, messages of
+/// different severities may be delivered out of order. When a lane is full,
+/// new messages of its severity are dropped, and the number of dropped
+/// messages is reported to the target with the next message delivered from
+/// that lane.
+///
+/// FATAL messages bypass the lanes: they are delivered synchronously, waiting
+/// for the delivery of the single message that may be in progress, and of the
+/// queued ERROR and WARNING messages, which go first. The remaining (INFO)
+/// messages are then delivered in WaitTillSent(), which LogMessage calls
+/// before the process dies.
+///
+/// The target does not need to be thread-safe: it is only ever called by one
+/// thread at a time.
+class AsyncSink : public LogSink {
+ public:
+  /// Lanes, in the order of priority.
+  enum Lane { kInfoLane = 0, kWarningLane = 1, kErrorLane = 2, kNumLanes = 3 };
+
+  struct LaneStats {
+    // Number of messages currently in the lane.
+    size_t depth;
+    // Number of bytes currently used by the lane, and its capacity.
+    size_t bytes;
+    size_t capacity;
+    // Number of messages delivered from the lane so far.
+    uint64_t delivered;
+    // Number of messages dropped because the lane was full.
+    uint64_t dropped;
+  };
+
+  /// Capacities are in bytes, and include a fixed per-message overhead (of
+  /// a few dozen bytes).
+  AsyncSink(LogSink& target, size_t info_capacity = 16 * 1024,
+            size_t warning_capacity = 4 * 1024,
+            size_t error_capacity = 4 * 1024);
+
+  /// Delivers the remaining queued messages, and stops the background thread.
+  ~AsyncSink();
+
+  void send(LogSeverity severity, const char* full_filename,
+            const char* base_filename, int line, roo_time::Uptime uptime,
+            roo_time::WallTime walltime, const char* message,
+            size_t message_len) override;
+
+  /// Keeps the sequence number, passing it along to the target's
+  /// sendRecord(). Structured fields of queued messages are passed in their
+  /// text rendering.
+  void sendRecord(const LogRecord& record) override;
+
+  /// Waits until all queued messages have been delivered, and then calls
+  /// WaitTillSent() on the target.
+  void WaitTillSent() override;
+
+  /// Returns the statistics of the specified lane.
+  LaneStats stats(Lane lane) const;
+
+  /// Returns the number of FATAL messages delivered synchronously so far.
+  uint64_t fatal_delivered() const;
+
+ private:
+  struct Record {
+    uint64_t sequence;
+    LogSeverity severity;
+    // Pointers to string literals (__FILE__), which outlive the queue.
+    const char* full_filename;
+    const char* base_filename;
+    int line;
+    roo_time::Uptime uptime;
+    roo_time::WallTime walltime;
+    std::string message;
+
+    size_t cost() const { return sizeof(Record) + message.size(); }
+  };
+
+  struct LaneState {
+    std::deque<Record> queue;
+    size_t bytes = 0;
+    size_t capacity = 0;
+    uint64_t delivered = 0;
+    uint64_t dropped = 0;
+    // Dropped messages not yet reported to the target.
+    uint64_t unreported_drops = 0;
+  };
+
+  void enqueue(const LogRecord& record);
+
+  void run();
+
+  // Returns true if all lanes are empty. Requires mutex_.
+  bool empty() const;
+
+  // Delivers the record to the target. Requires deliver_mutex_.
+  void deliver(const Record& record, uint64_t dropped);
+
+  // Delivers all queued records of the specified and more severe lanes, most
+  // severe first. Requires deliver_mutex_.
+  void drain(Lane lowest);
+
+  LogSink& target_;
+
+  mutable roo::mutex mutex_;
+  roo::condition_variable nonempty_;
+  roo::condition_variable drained_;
+  LaneState lanes_[kNumLanes];  // Guarded by mutex_.
+  bool in_flight_;              // Guarded by mutex_.
+  bool stop_;                   // Guarded by mutex_.
+  uint64_t fatal_delivered_;    // Guarded by mutex_.
+
+  // Serializes calls to the target. Acquired before mutex_, when both are
+  // needed.
+  roo::mutex deliver_mutex_;
+
+  roo::thread thread_;
+};
+
+}  // namespace roo_logging
@@ -36,6 +36,7 @@
 #include <cstring>
 
 #include "roo_logging/config.h"
+#include "roo_logging/log_site.h"
 #include "roo_logging/log_severity.h"
 #include "roo_logging/predict.h"
 #include "roo_logging/stream.h"
@@ -46,7 +47,9 @@
 // better to have compact code for these operations.
 
 #if ROO_STRIP_LOG == 0
-#define COMPACT_ROO_LOG_INFO ::roo_logging::LogMessage(__FILE__, __LINE__)
+#define COMPACT_ROO_LOG_INFO \
+  ::roo_logging::LogMessage( \
+      ROO_LOGGING_SITE(::roo_logging::ROO_LOGGING_INFO))
 #define LOG_TO_STRING_INFO(message)             \
   ::roo_logging::LogMessage(__FILE__, __LINE__, \
                             ::roo_logging::ROO_LOGGING_INFO, message)
@@ -56,9 +59,9 @@
 #endif
 
 #if ROO_STRIP_LOG <= 1
-#define COMPACT_ROO_LOG_WARNING                 \
-  ::roo_logging::LogMessage(__FILE__, __LINE__, \
-                            ::roo_logging::ROO_LOGGING_WARNING)
+#define COMPACT_ROO_LOG_WARNING \
+  ::roo_logging::LogMessage(    \
+      ROO_LOGGING_SITE(::roo_logging::ROO_LOGGING_WARNING))
 #define LOG_TO_STRING_WARNING(message)          \
   ::roo_logging::LogMessage(__FILE__, __LINE__, \
                             ::roo_logging::ROO_LOGGING_WARNING, message)
@@ -68,9 +71,9 @@
 #endif
 
 #if ROO_STRIP_LOG <= 2
-#define COMPACT_ROO_LOG_ERROR                   \
-  ::roo_logging::LogMessage(__FILE__, __LINE__, \
-                            ::roo_logging::ROO_LOGGING_ERROR)
+#define COMPACT_ROO_LOG_ERROR \
+  ::roo_logging::LogMessage(  \
+      ROO_LOGGING_SITE(::roo_logging::ROO_LOGGING_ERROR))
 #define LOG_TO_STRING_ERROR(message)            \
   ::roo_logging::LogMessage(__FILE__, __LINE__, \
                             ::roo_logging::ROO_LOGGING_ERROR, message)
@@ -80,7 +83,9 @@
 #endif
 
 #if ROO_STRIP_LOG <= 3
-#define COMPACT_ROO_LOG_FATAL ::roo_logging::LogMessageFatal(__FILE__, __LINE__)
+#define COMPACT_ROO_LOG_FATAL     \
+  ::roo_logging::LogMessageFatal( \
+      ROO_LOGGING_SITE(::roo_logging::ROO_LOGGING_FATAL))
 #define LOG_TO_STRING_FATAL(message)            \
   ::roo_logging::LogMessage(__FILE__, __LINE__, \
                             ::roo_logging::ROO_LOGINGG_FATAL, message)
@@ -94,9 +99,9 @@
 #if !DCHECK_IS_ON()
 #define COMPACT_ROO_LOG_DFATAL COMPACT_ROO_LOG_ERROR
 #elif ROO_STRIP_LOG <= 3
-#define COMPACT_ROO_LOG_DFATAL                  \
-  ::roo_logging::LogMessage(__FILE__, __LINE__, \
-                            ::roo_logging::ROO_LOGGING_FATAL)
+#define COMPACT_ROO_LOG_DFATAL \
+  ::roo_logging::LogMessage(   \
+      ROO_LOGGING_SITE(::roo_logging::ROO_LOGGING_FATAL))
 #else
 #define COMPACT_ROO_LOG_DFATAL ::roo_logging::NullStreamFatal()
 #endif
@@ -114,14 +119,14 @@
 #define LOG_OCCURRENCES LOG_EVERY_N_VARNAME(occurrences_, __LINE__)
 #define LOG_OCCURRENCES_MOD_N LOG_EVERY_N_VARNAME(occurrences_mod_n_, __LINE__)
 
-#define SOME_KIND_OF_LOG_EVERY_N(severity, n, what_to_do)          \
-  static int LOG_OCCURRENCES = 0, LOG_OCCURRENCES_MOD_N = 0;       \
-  ++LOG_OCCURRENCES;                                               \
-  if (++LOG_OCCURRENCES_MOD_N > n) LOG_OCCURRENCES_MOD_N -= n;     \
-  if (LOG_OCCURRENCES_MOD_N == 1)                                  \
-  ::roo_logging::LogMessage(__FILE__, __LINE__,                    \
-                            ::roo_logging::ROO_LOGGING_##severity, \
-                            LOG_OCCURRENCES, &what_to_do)          \
+#define SOME_KIND_OF_LOG_EVERY_N(severity, n, what_to_do)      \
+  static int LOG_OCCURRENCES = 0, LOG_OCCURRENCES_MOD_N = 0;   \
+  ++LOG_OCCURRENCES;                                           \
+  if (++LOG_OCCURRENCES_MOD_N > n) LOG_OCCURRENCES_MOD_N -= n; \
+  if (LOG_OCCURRENCES_MOD_N == 1)                              \
+  ::roo_logging::LogMessage(                                   \
+      ROO_LOGGING_SITE(::roo_logging::ROO_LOGGING_##severity), \
+      LOG_OCCURRENCES, &what_to_do)                            \
       .stream()
 
 #define SOME_KIND_OF_LOG_IF_EVERY_N(severity, condition, n, what_to_do)       \
@@ -129,18 +134,18 @@
   ++LOG_OCCURRENCES;                                                          \
   if (condition &&                                                            \
       ((LOG_OCCURRENCES_MOD_N = (LOG_OCCURRENCES_MOD_N + 1) % n) == (1 % n))) \
-  ::roo_logging::LogMessage(__FILE__, __LINE__,                               \
-                            ::roo_logging::ROO_LOGGING_##severity,            \
-                            LOG_OCCURRENCES, &what_to_do)                     \
+  ::roo_logging::LogMessage(                                                  \
+      ROO_LOGGING_SITE(::roo_logging::ROO_LOGGING_##severity),                \
+      LOG_OCCURRENCES, &what_to_do)                                           \
       .stream()
 
-#define SOME_KIND_OF_LOG_FIRST_N(severity, n, what_to_do)          \
-  static int LOG_OCCURRENCES = 0;                                  \
-  if (LOG_OCCURRENCES <= n) ++LOG_OCCURRENCES;                     \
-  if (LOG_OCCURRENCES <= n)                                        \
-  ::roo_logging::LogMessage(__FILE__, __LINE__,                    \
-                            ::roo_logging::ROO_LOGGING_##severity, \
-                            LOG_OCCURRENCES, &what_to_do)          \
+#define SOME_KIND_OF_LOG_FIRST_N(severity, n, what_to_do)      \
+  static int LOG_OCCURRENCES = 0;                              \
+  if (LOG_OCCURRENCES <= n) ++LOG_OCCURRENCES;                 \
+  if (LOG_OCCURRENCES <= n)                                    \
+  ::roo_logging::LogMessage(                                   \
+      ROO_LOGGING_SITE(::roo_logging::ROO_LOGGING_##severity), \
+      LOG_OCCURRENCES, &what_to_do)                            \
       .stream()
 
 #define SOME_KIND_OF_LOG_EVERY_T(severity, interval)                          \
@@ -151,8 +156,8 @@
   const auto LOG_TIME_DELTA = LOG_CURRENT_TIME - LOG_PREVIOUS_TIME;           \
   if (LOG_TIME_DELTA > LOG_TIME_PERIOD) LOG_PREVIOUS_TIME = LOG_CURRENT_TIME; \
   if (LOG_TIME_DELTA > LOG_TIME_PERIOD)                                       \
-  ::roo_logging::LogMessage(__FILE__, __LINE__,                               \
-                            ::roo_logging::ROO_LOGGING_##severity)            \
+  ::roo_logging::LogMessage(                                                  \
+      ROO_LOGGING_SITE(::roo_logging::ROO_LOGGING_##severity))                \
       .stream()
 
 namespace roo_logging {
@@ -31,6 +31,7 @@
 
 #pragma once
 
+#include "roo_logging/log_site.h"
 #include "roo_logging/stream.h"
 
 namespace roo_logging {
@@ -160,7 +161,9 @@ typedef StringType _Check_string;
                  ::roo_logging::GetReferenceableValue(val1), \
                  ::roo_logging::GetReferenceableValue(val2), \
                  #val1 " " #op " " #val2))                   \
-  log(__FILE__, __LINE__, roo_logging::CheckOpString(_result)).stream()
+  log(ROO_LOGGING_SITE(::roo_logging::ROO_LOGGING_FATAL),    \
+      roo_logging::CheckOpString(_result))                   \
+      .stream()
 #else
 // In optimized mode, use CheckOpString to hint to compiler that
 // the while condition is unlikely.
@@ -169,7 +172,7 @@ typedef StringType _Check_string;
              ::roo_logging::GetReferenceableValue(val1),                      \
              ::roo_logging::GetReferenceableValue(val2),                      \
              #val1 " " #op " " #val2))                                        \
-  log(__FILE__, __LINE__, _result).stream()
+  log(ROO_LOGGING_SITE(::roo_logging::ROO_LOGGING_FATAL), _result).stream()
 #endif  // STATIC_ANALYSIS, DCHECK_IS_ON()
 
 #if ROO_STRIP_LOG <= 3
@@ -0,0 +1,276 @@
+#if defined(__linux__)
+
+#include "roo_logging/compressed_file_sink.h"
+
+#include <string.h>
+
+#include <chrono>
+
+#include "roo_logging/log_line.h"
+
+static_assert(__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__,
+              "The compressed log format is written in the host byte order");
+
+namespace roo_logging {
+
+namespace compressed_log {
+
+// FNV-1a.
+uint32_t Checksum(const uint8_t* data, size_t len) {
+  uint32_t hash = 2166136261u;
+  for (size_t i = 0; i < len; ++i) {
+    hash ^= data[i];
+    hash *= 16777619u;
+  }
+  return hash;
+}
+
+namespace {
+
+bool IsPlausible(const BlockHeader& header) {
+  size_t stored_len = header.stored_len & ~kStoredRaw;
+  if (header.magic != kMagic || header.raw_len > lz::kMaxBlockSize) {
+    return false;
+  }
+  return (header.stored_len & kStoredRaw) != 0
+             ? stored_len == header.raw_len
+             : stored_len <= lz::MaxCompressedSize(header.raw_len);
+}
+
+}  // namespace
+
+Reader::Reader(FILE* in)
+    : in_(in),
+      buf_(2 * lz::MaxCompressedSize(lz::kMaxBlockSize)),
+      pos_(0),
+      end_(0),
+      damaged_(0),
+      truncated_(false) {}
+
+bool Reader::fill(size_t n) {
+  if (end_ - pos_ >= n) return true;
+  memmove(buf_.data(), buf_.data() + pos_, end_ - pos_);
+  end_ -= pos_;
+  pos_ = 0;
+  while (end_ < n) {
+    size_t read = fread(buf_.data() + end_, 1, buf_.size() - end_, in_);
+    if (read == 0) return false;
+    end_ += read;
+  }
+  return true;
+}
+
+bool Reader::next(std::string& text) {
+  // Set while searching for the next block header, after a damaged block.
+  bool skipping = false;
+  // Set if a block seemed to extend past the end of the file. If no intact
+  // block follows, the file was truncated; otherwise, the block was damaged.
+  bool incomplete = false;
+  while (true) {
+    BlockHeader header;
+    if (!fill(sizeof(header))) {
+      if (incomplete || (!skipping && end_ > pos_)) truncated_ = true;
+      pos_ = end_;
+      return false;
+    }
+    memcpy(&header, buf_.data() + pos_, sizeof(header));
+    bool ok = IsPlausible(header);
+    size_t stored_len = header.stored_len & ~kStoredRaw;
+    if (ok && !fill(sizeof(header) + stored_len)) {
+      incomplete = true;
+      skipping = true;
+      ++pos_;
+      continue;
+    }
+    if (ok) {
+      const uint8_t* stored = buf_.data() + pos_ + sizeof(header);
+      size_t old_size = text.size();
+      text.resize(old_size + header.raw_len);
+      uint8_t* out = reinterpret_cast<uint8_t*>(&text[old_size]);
+      if ((header.stored_len & kStoredRaw) != 0) {
+        memcpy(out, stored, stored_len);
+      } else {
+        ok = lz::Decompress(stored, stored_len, out, header.raw_len);
+      }
+      ok = ok && Checksum(out, header.raw_len) == header.checksum;
+      if (ok) {
+        if (incomplete) ++damaged_;
+        pos_ += sizeof(header) + stored_len;
+        return true;
+      }
+      text.resize(old_size);
+    }
+    if (!skipping) ++damaged_;
+    skipping = true;
+    ++pos_;
+  }
+}
+
+}  // namespace compressed_log
+
+namespace {
+
+// Room kept in each block for a "records dropped" note.
+static constexpr size_t kDropNoteReserve = 48;
+
+// The longest prefix (see send()).
+static constexpr size_t kMaxPrefixLen = 127;
+
+static_assert(CompressedFileSink::kMinBlockSize >
+                  kDropNoteReserve + kMaxPrefixLen + 1,
+              "kMinBlockSize leaves no room for the message");
+
+}  // namespace
+
+constexpr size_t CompressedFileSink::kMinBlockSize;
+
+CompressedFileSink::CompressedFileSink(const char* path, size_t block_size,
+                                       size_t max_pending_blocks,
+                                       roo_time::Duration flush_interval)
+    : file_(fopen(path, "ab")),
+      block_size_(block_size < kMinBlockSize     ? kMinBlockSize
+                  : block_size < lz::kMaxBlockSize ? block_size
+                                                   : lz::kMaxBlockSize),
+      max_pending_blocks_(max_pending_blocks),
+      flush_interval_(flush_interval),
+      sealed_count_(0),
+      written_count_(0),
+      unreported_drops_(0),
+      stopping_(false),
+      compressor_(new lz::Compressor()),
+      compressed_(sizeof(compressed_log::BlockHeader) +
+                  lz::MaxCompressedSize(block_size_)),
+      dropped_(0),
+      bytes_in_(0),
+      bytes_out_(0) {
+  if (file_ == nullptr) return;
+  current_.reserve(block_size_);
+  thread_ = std::thread(&CompressedFileSink::run, this);
+}
+
+CompressedFileSink::~CompressedFileSink() {
+  if (file_ == nullptr) return;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopping_ = true;
+  }
+  wakeup_.notify_one();
+  thread_.join();
+  fclose(file_);
+}
+
+void CompressedFileSink::send(LogSeverity severity, const char* full_filename,
+                              const char* base_filename, int line,
+                              roo_time::Uptime uptime,
+                              roo_time::WallTime walltime, const char* message,
+                              size_t message_len) {
+  if (file_ == nullptr) return;
+  char prefix[kMaxPrefixLen + 1];
+  size_t prefix_len =
+      FormatLogPrefix(prefix, sizeof(prefix), severity, uptime, walltime, 0,
+                      nullptr, base_filename, strlen(base_filename), line);
+  // Each line must fit in a single block.
+  size_t max_message_len = block_size_ - kDropNoteReserve - prefix_len - 1;
+  if (message_len > max_message_len) message_len = max_message_len;
+  bool wake = false;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    char note[kDropNoteReserve];
+    size_t note_len = 0;
+    if (unreported_drops_ > 0) {
+      note_len = snprintf(note, sizeof(note), "[%llu records dropped]\n",
+                          (unsigned long long)unreported_drops_);
+    }
+    size_t len = note_len + prefix_len + message_len + 1;
+    if (current_.size() + len > block_size_) {
+      if (pending_.size() >= max_pending_blocks_) {
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+        ++unreported_drops_;
+        return;
+      }
+      sealCurrent();
+      wake = true;
+    }
+    unreported_drops_ = 0;
+    current_.insert(current_.end(), note, note + note_len);
+    current_.insert(current_.end(), prefix, prefix + prefix_len);
+    current_.insert(current_.end(), message, message + message_len);
+    current_.push_back('\n');
+  }
+  if (wake) wakeup_.notify_one();
+}
+
+void CompressedFileSink::WaitTillSent() {
+  if (file_ == nullptr) return;
+  std::unique_lock<std::mutex> lock(mutex_);
+  if (!current_.empty()) sealCurrent();
+  uint64_t target = sealed_count_;
+  wakeup_.notify_one();
+  written_.wait_for(lock, std::chrono::seconds(1),
+                    [&] { return written_count_ >= target; });
+}
+
+void CompressedFileSink::sealCurrent() {
+  pending_.push_back(std::move(current_));
+  if (spare_.empty()) {
+    current_ = std::vector<char>();
+    current_.reserve(block_size_);
+  } else {
+    current_ = std::move(spare_.back());
+    spare_.pop_back();
+  }
+  ++sealed_count_;
+}
+
+void CompressedFileSink::run() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (true) {
+    wakeup_.wait_for(lock,
+                     std::chrono::microseconds(flush_interval_.inMicros()),
+                     [&] { return stopping_ || !pending_.empty(); });
+    if (pending_.empty()) {
+      // Flush interval elapsed, or stopping.
+      if (!current_.empty()) sealCurrent();
+      if (pending_.empty()) {
+        if (stopping_) break;
+        continue;
+      }
+    }
+    std::vector<char> block = std::move(pending_.front());
+    pending_.pop_front();
+    lock.unlock();
+    writeBlock(block);
+    lock.lock();
+    block.clear();
+    if (spare_.size() < 2) spare_.push_back(std::move(block));
+    ++written_count_;
+    written_.notify_all();
+  }
+}
+
+void CompressedFileSink::writeBlock(const std::vector<char>& block) {
+  const uint8_t* data = reinterpret_cast<const uint8_t*>(block.data());
+  compressed_log::BlockHeader header;
+  header.magic = compressed_log::kMagic;
+  header.raw_len = (uint32_t)block.size();
+  header.checksum = compressed_log::Checksum(data, block.size());
+  uint8_t* payload = compressed_.data() + sizeof(header);
+  size_t stored_len = compressor_->compress(data, block.size(), payload);
+  if (stored_len >= block.size()) {
+    memcpy(payload, data, block.size());
+    stored_len = block.size();
+    header.stored_len = (uint32_t)stored_len | compressed_log::kStoredRaw;
+  } else {
+    header.stored_len = (uint32_t)stored_len;
+  }
+  memcpy(compressed_.data(), &header, sizeof(header));
+  // A single write, so that a crash leaves at most one partial block.
+  fwrite(compressed_.data(), 1, sizeof(header) + stored_len, file_);
+  fflush(file_);
+  bytes_in_.fetch_add(block.size(), std::memory_order_relaxed);
+  bytes_out_.fetch_add(sizeof(header) + stored_len, std::memory_order_relaxed);
+}
+
+}  // namespace roo_logging
+
+#endif  // defined(__linux__)
@@ -0,0 +1,173 @@
+#pragma once
+
+#if defined(__linux__)
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "roo_logging/lz.h"
+#include "roo_logging/sink.h"
+#include "roo_time.h"
+
+namespace roo_logging {
+
+/// Compressed log file format, written by CompressedFileSink and read by
+/// compressed_log::Reader (and the log_cat tool; see tools/).
+///
+/// The file is a sequence of blocks, each consisting of a BlockHeader followed
+/// by the block's data, compressed independently of all other blocks (see
+/// lz.h). Decompressed, the blocks are the log text. Since blocks don't depend
+/// on one another, a file truncated in a crash loses only its last, partially
+/// written block; a damaged block is detected by its checksum, and skipped.
+/// Files can be appended to, and concatenated. Integers are little-endian.
+namespace compressed_log {
+
+static constexpr uint32_t kMagic = 0x425A4C52;  // "RLZB"
+
+/// Set in BlockHeader::stored_len if the block is stored uncompressed
+/// (because it did not compress).
+static constexpr uint32_t kStoredRaw = 0x80000000u;
+
+struct BlockHeader {
+  uint32_t magic;
+  // The size of the decompressed data.
+  uint32_t raw_len;
+  // The size of the data that follows the header, possibly with kStoredRaw.
+  uint32_t stored_len;
+  // FNV-1a of the decompressed data.
+  uint32_t checksum;
+};
+
+/// Returns the checksum used in BlockHeader.
+uint32_t Checksum(const uint8_t* data, size_t len);
+
+/// Reads a compressed log file, one block at a time.
+class Reader {
+ public:
+  /// Does not take ownership of the file, which does not need to be seekable.
+  explicit Reader(FILE* in);
+
+  /// Appends the decompressed text of the next intact block to text. Returns
+  /// false at the end of the file. Damaged blocks are skipped (the reader
+  /// searches for the next block header), and counted.
+  bool next(std::string& text);
+
+  /// Returns the number of damaged blocks skipped so far.
+  uint64_t damaged() const { return damaged_; }
+
+  /// Returns true if the file ended in the middle of a block, which is
+  /// what a crash while writing leaves behind.
+  bool truncated() const { return truncated_; }
+
+ private:
+  // Makes sure that at least n bytes are buffered, reading more as needed.
+  // Returns false if the file ends sooner.
+  bool fill(size_t n);
+
+  FILE* in_;
+  std::vector<uint8_t> buf_;
+  size_t pos_;
+  size_t end_;
+  uint64_t damaged_;
+  bool truncated_;
+};
+
+}  // namespace compressed_log
+
+/// A LogSink (Linux only) that writes formatted log lines to a compressed log
+/// file (see compressed_log above), typically several times smaller than the
+/// plain text. Read the file with the log_cat tool.
+///
+/// send() only formats the line into the current block buffer. Once the
+/// block reaches block_size, or every flush_interval, it is handed to a
+/// background thread, which compresses it, and appends it to the file. The
+/// logging thread never compresses, nor waits for I/O: if max_pending_blocks
+/// are already waiting for the writer, records are dropped, and the count is
+/// noted in the log.
+///
+/// Shorter flush intervals lose less on a crash, but produce smaller blocks,
+/// which compress less well.
+class CompressedFileSink : public LogSink {
+ public:
+  /// Smallest block size; each block must fit at least one line, with its
+  /// prefix, and a "records dropped" note.
+  static constexpr size_t kMinBlockSize = 256;
+
+  /// Opens (for appending) the file, and starts the writer thread.
+  /// block_size is clamped to [kMinBlockSize, lz::kMaxBlockSize].
+  CompressedFileSink(const char* path, size_t block_size = 64 * 1024,
+                     size_t max_pending_blocks = 8,
+                     roo_time::Duration flush_interval = roo_time::Seconds(1));
+
+  /// Writes out what remains, and closes the file.
+  ~CompressedFileSink();
+
+  /// Returns true if the file has been successfully opened.
+  bool ok() const { return file_ != nullptr; }
+
+  /// Returns the number of records dropped so far.
+  uint64_t dropped() const { return dropped_.load(std::memory_order_relaxed); }
+
+  /// Returns the number of bytes of log text written so far, before and after
+  /// compression (including block headers).
+  uint64_t bytes_in() const {
+    return bytes_in_.load(std::memory_order_relaxed);
+  }
+  uint64_t bytes_out() const {
+    return bytes_out_.load(std::memory_order_relaxed);
+  }
+
+  void send(LogSeverity severity, const char* full_filename,
+            const char* base_filename, int line, roo_time::Uptime uptime,
+            roo_time::WallTime walltime, const char* message,
+            size_t message_len) override;
+
+  /// Writes out everything logged so far (waiting for up to a second).
+  void WaitTillSent() override;
+
+ private:
+  // Moves the current block to the writer's queue. Requires mutex_.
+  void sealCurrent();
+
+  void run();
+  void writeBlock(const std::vector<char>& block);
+
+  FILE* file_;
+  size_t block_size_;
+  size_t max_pending_blocks_;
+  roo_time::Duration flush_interval_;
+
+  std::mutex mutex_;
+  std::condition_variable wakeup_;
+  std::condition_variable written_;
+  std::vector<char> current_;              // Guarded by mutex_.
+  std::deque<std::vector<char>> pending_;  // Guarded by mutex_.
+  std::vector<std::vector<char>> spare_;   // Guarded by mutex_.
+  uint64_t sealed_count_;                  // Guarded by mutex_.
+  uint64_t written_count_;                 // Guarded by mutex_.
+  uint64_t unreported_drops_;              // Guarded by mutex_.
+  bool stopping_;                          // Guarded by mutex_.
+
+  // Used by the writer thread only.
+  std::unique_ptr<lz::Compressor> compressor_;
+  std::vector<uint8_t> compressed_;
+
+  std::atomic<uint64_t> dropped_;
+  std::atomic<uint64_t> bytes_in_;
+  std::atomic<uint64_t> bytes_out_;
+  std::thread thread_;
+};
+
+}  // namespace roo_logging
+
+#endif  // defined(__linux__)
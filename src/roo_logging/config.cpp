@@ -1,9 +1,108 @@
 #include "roo_logging/config.h"
 
-ROO_FLAG(roo_logging::WallTimeClockPtr, roo_logging_wall_time_clock, nullptr);
-ROO_FLAG(roo_time::TimeZone, roo_logging_timezone, roo_time::timezone::UTC);
-ROO_FLAG(bool, roo_logging_prefix, ROO_LOGGING_PREFIX);
-ROO_FLAG(bool, roo_logging_colorlogtostderr, ROO_LOGGING_COLORLOGTOSTDERR);
-ROO_FLAG(uint8_t, roo_logging_minloglevel, ROO_LOGGING_MINLOGLEVEL);
-ROO_FLAG(bool, roo_logging_freertos_log_core_id,
+#include <atomic>
+
+#include "roo_threads.h"
+#include "roo_threads/mutex.h"
+#include "roo_threads/thread.h"
+
+ROO_FLAG(roo_logging::ConfigFlag<roo_logging::WallTimeClockPtr>,
+         roo_logging_wall_time_clock, nullptr);
+ROO_FLAG(roo_logging::ConfigFlag<roo_time::TimeZone>, roo_logging_timezone,
+         roo_time::timezone::UTC);
+ROO_FLAG(roo_logging::ConfigFlag<bool>, roo_logging_prefix, ROO_LOGGING_PREFIX);
+ROO_FLAG(roo_logging::ConfigFlag<bool>, roo_logging_log_sequence,
+         ROO_LOGGING_LOG_SEQUENCE);
+ROO_FLAG(roo_logging::ConfigFlag<uint8_t>, roo_logging_timestamp_source,
+         ROO_LOGGING_TIMESTAMP_SOURCE);
+ROO_FLAG(roo_logging::ConfigFlag<bool>, roo_logging_colorlogtostderr,
+         ROO_LOGGING_COLORLOGTOSTDERR);
+ROO_FLAG(roo_logging::ConfigFlag<uint8_t>, roo_logging_minloglevel,
+         ROO_LOGGING_MINLOGLEVEL);
+ROO_FLAG(roo_logging::ConfigFlag<bool>, roo_logging_freertos_log_core_id,
          ROO_LOGGING_FREERTOS_LOG_CORE_ID);
+ROO_FLAG(roo_logging::ConfigFlag<bool>, roo_logging_dedup, ROO_LOGGING_DEDUP);
+ROO_FLAG(uint32_t, roo_logging_dedup_window_ms, ROO_LOGGING_DEDUP_WINDOW_MS);
+ROO_FLAG(roo_logging::ConfigFlag<uint32_t>, roo_logging_overflow_limit,
+         ROO_LOGGING_OVERFLOW_LIMIT);
+ROO_FLAG(roo_logging::ConfigFlag<uint32_t>, roo_logging_sink_latency_budget_ms,
+         ROO_LOGGING_SINK_LATENCY_BUDGET_MS);
+ROO_FLAG(uint8_t, roo_logging_sink_trip_count, ROO_LOGGING_SINK_TRIP_COUNT);
+ROO_FLAG(uint32_t, roo_logging_sink_retry_ms, ROO_LOGGING_SINK_RETRY_MS);
+
+namespace roo_logging {
+
+namespace {
+
+// Snapshots are written round-robin, skipping the ones still pinned by a
+// message (or a ConfigRef).
+constexpr int kSnapshotSlots = 4;
+
+ConfigSnapshot snapshots[kSnapshotSlots];
+std::atomic<const ConfigSnapshot*> current_snapshot(nullptr);
+
+roo::mutex& publish_mutex() {
+  static roo::mutex m;
+  return m;
+}
+
+}  // namespace
+
+const ConfigSnapshot* AcquireConfig() {
+  while (true) {
+    const ConfigSnapshot* snapshot = current_snapshot.load();
+    if (snapshot == nullptr) {
+      PublishConfig();
+      continue;
+    }
+    snapshot->users.fetch_add(1);
+    // If the snapshot is still current after pinning it, PublishConfig() has
+    // not picked its slot for reuse, and won't, until it is released.
+    if (current_snapshot.load() == snapshot) return snapshot;
+    snapshot->users.fetch_sub(1);
+  }
+}
+
+void ReleaseConfig(const ConfigSnapshot* snapshot) {
+  snapshot->users.fetch_sub(1, std::memory_order_release);
+}
+
+void PublishConfig() {
+  roo::lock_guard<roo::mutex> lock(publish_mutex());
+  const ConfigSnapshot* previous = current_snapshot.load();
+  uint32_t generation = (previous == nullptr) ? 1 : previous->generation + 1;
+  // Finds a slot that is neither current nor pinned. Normally, that's the
+  // next one; otherwise, waits for the messages that pin the slots to finish.
+  // (All of them can only be pinned if several messages stay in flight
+  // across as many publications.)
+  ConfigSnapshot* slot = nullptr;
+  while (true) {
+    for (int i = 0; i < kSnapshotSlots; ++i) {
+      ConfigSnapshot& candidate = snapshots[(generation + i) % kSnapshotSlots];
+      if (&candidate != previous && candidate.users.load() == 0) {
+        slot = &candidate;
+        break;
+      }
+    }
+    if (slot != nullptr) break;
+    roo::this_thread::yield();
+  }
+  ConfigSnapshot& snapshot = *slot;
+  snapshot.wall_time_clock = GET_ROO_FLAG(roo_logging_wall_time_clock);
+  snapshot.timezone = GET_ROO_FLAG(roo_logging_timezone);
+  snapshot.generation = generation;
+  snapshot.minloglevel = GET_ROO_FLAG(roo_logging_minloglevel);
+  snapshot.timestamp_source = GET_ROO_FLAG(roo_logging_timestamp_source);
+  snapshot.prefix = GET_ROO_FLAG(roo_logging_prefix);
+  snapshot.log_sequence = GET_ROO_FLAG(roo_logging_log_sequence);
+  snapshot.colorlogtostderr = GET_ROO_FLAG(roo_logging_colorlogtostderr);
+  snapshot.freertos_log_core_id =
+      GET_ROO_FLAG(roo_logging_freertos_log_core_id);
+  snapshot.dedup = GET_ROO_FLAG(roo_logging_dedup);
+  snapshot.overflow_limit = GET_ROO_FLAG(roo_logging_overflow_limit);
+  snapshot.sink_latency_budget_ms =
+      GET_ROO_FLAG(roo_logging_sink_latency_budget_ms);
+  current_snapshot.store(&snapshot);
+}
+
+}  // namespace roo_logging
@@ -1,32 +1,114 @@
 #pragma once
 
+#include <stdint.h>
+
+#include <atomic>
+
 #include "roo_flags.h"
 #include "roo_time.h"
 
 namespace roo_logging {
+
 using WallTimeClockPtr = ::roo_time::WallTimeClock*;
-}
+
+/// Publishes a new ConfigSnapshot (see below) with the current values of the
+/// flags.
+void PublishConfig();
+
+/// The type of the flags that are copied into ConfigSnapshot. Behaves like a
+/// plain T, except that assigning to it (as SET_ROO_FLAG does) publishes a
+/// new snapshot, so that the change takes effect immediately.
+template <typename T>
+class ConfigFlag {
+ public:
+  constexpr ConfigFlag(T value) : value_(value) {}
+
+  ConfigFlag& operator=(T value) {
+    value_ = value;
+    PublishConfig();
+    return *this;
+  }
+
+  operator T() const { return value_; }
+
+ private:
+  T value_;
+};
+
+}  // namespace roo_logging
 
 /// Which wall time clock to use. If nullptr (default), uses uptime in the logs,
 /// instead of wall time.
-ROO_DECLARE_FLAG(roo_logging::WallTimeClockPtr, roo_logging_wall_time_clock);
+ROO_DECLARE_FLAG(roo_logging::ConfigFlag<roo_logging::WallTimeClockPtr>,
+                 roo_logging_wall_time_clock);
 
 /// Which time zone to use to report wall time. Ignored if the
 /// roo_logging_wall_time_clock flag is nullptr.
-ROO_DECLARE_FLAG(roo_time::TimeZone, roo_logging_timezone);
+ROO_DECLARE_FLAG(roo_logging::ConfigFlag<roo_time::TimeZone>,
+                 roo_logging_timezone);
 
 /// Whether to prepend prefix (time, file, line number, etc.) in front of each
 /// log line.
-ROO_DECLARE_FLAG(bool, roo_logging_prefix);
+ROO_DECLARE_FLAG(roo_logging::ConfigFlag<bool>, roo_logging_prefix);
+
+/// Whether to include the global sequence number of the message (see
+/// LogMessage::sequence()) in the prefix, as "#N", after the time.
+ROO_DECLARE_FLAG(roo_logging::ConfigFlag<bool>, roo_logging_log_sequence);
+
+/// Where messages get their timestamps from (see TimestampSource in
+/// roo_logging/timestamp.h): 0 for the precise clock (default), 1 for a
+/// coarse clock, or 2 for the CPU cycle counter. The latter two are cheaper
+/// per message, and also avoid reading the wall time clock for every message.
+ROO_DECLARE_FLAG(roo_logging::ConfigFlag<uint8_t>,
+                 roo_logging_timestamp_source);
 
 /// Whether to ANSI-color the log lines written to stderr.
-ROO_DECLARE_FLAG(bool, roo_logging_colorlogtostderr);
+ROO_DECLARE_FLAG(roo_logging::ConfigFlag<bool>, roo_logging_colorlogtostderr);
 
 /// Messages with severity below this level are not logged at all.
-ROO_DECLARE_FLAG(uint8_t, roo_logging_minloglevel);
+ROO_DECLARE_FLAG(roo_logging::ConfigFlag<uint8_t>, roo_logging_minloglevel);
 
 /// If true, core ID will be logged in log messages when running on FreeRTOS.
-ROO_DECLARE_FLAG(bool, roo_logging_freertos_log_core_id);
+ROO_DECLARE_FLAG(roo_logging::ConfigFlag<bool>,
+                 roo_logging_freertos_log_core_id);
+
+/// If true, identical consecutive messages are collapsed into a single line,
+/// followed by a periodic "last message repeated N times" summary.
+ROO_DECLARE_FLAG(roo_logging::ConfigFlag<bool>, roo_logging_dedup);
+
+/// Time window (in milliseconds) for repeated-message suppression. Identical
+/// messages from different call sites are considered repeats only within that
+/// window, and the summary of suppressed repeats is emitted at most once per
+/// window. Ignored if roo_logging_dedup is false.
+ROO_DECLARE_FLAG(uint32_t, roo_logging_dedup_window_ms);
+
+/// If non-zero, enables the overflow mode, and sets the hard limit on the
+/// length of a single message (at most 65534). Messages longer than
+/// kMaxLogMessageLen then spill into a (pooled) larger buffer, up to this
+/// limit, and messages that still get cut end with a "...[truncated N bytes]"
+/// marker. If zero (default), messages are silently cut at kMaxLogMessageLen.
+ROO_DECLARE_FLAG(roo_logging::ConfigFlag<uint32_t>, roo_logging_overflow_limit);
+
+/// Latency budget (in milliseconds) for a single call to the sink. If the
+/// sink exceeds it roo_logging_sink_trip_count times in a row (e.g. because
+/// it writes to a full UART, or to a stalled socket), it is considered
+/// stalled: a diagnostic is written to stderr, and INFO and WARNING messages
+/// are not sent to the sink (and are counted as dropped); ERROR and FATAL
+/// messages always are. After roo_logging_sink_retry_ms, the next message is
+/// sent as a probe; if it is within the budget, the sink is back in use, and
+/// gets a note with the number of dropped messages; otherwise, the retry
+/// interval doubles (up to 64 times). Zero (default) disables the watchdog.
+///
+/// The watchdog can only act after a send returns, so it does not protect
+/// against a sink that hangs; use AsyncSink for that (see SinkHealth).
+ROO_DECLARE_FLAG(roo_logging::ConfigFlag<uint32_t>,
+                 roo_logging_sink_latency_budget_ms);
+
+/// See roo_logging_sink_latency_budget_ms.
+ROO_DECLARE_FLAG(uint8_t, roo_logging_sink_trip_count);
+
+/// See roo_logging_sink_latency_budget_ms.
+ROO_DECLARE_FLAG(uint32_t, roo_logging_sink_retry_ms);
 
 /// The global value of ROO_STRIP_LOG. All the messages logged to
 /// LOG(XXX) with severity less than ROO_STRIP_LOG will not be displayed.
@@ -47,8 +129,33 @@ ROO_DECLARE_FLAG(bool, roo_logging_freertos_log_core_id);
 #define DCHECK_IS_ON() 1
 #endif
 
+/// If set to 1, VLOG and MLOG verbosity can be changed at run time (see
+/// roo_logging/vlog.h). In that case, VLOG_LEVEL and MLOG_<module> only
+/// provide the initial levels. Otherwise (default), verbose logging is fully
+/// determined, and compiled out as needed, at compile time.
+#ifndef ROO_LOGGING_RUNTIME_VLOG
+#define ROO_LOGGING_RUNTIME_VLOG 0
+#endif
+
+#if ROO_LOGGING_RUNTIME_VLOG
+
+#include "roo_logging/vlog.h"
+
 #if defined(VLOG_LEVEL)
-#define VLOG_IS_ON(verboselevel) ((verboselevel) >= VLOG_LEVEL)
+#define ROO_LOGGING_DEFAULT_VLOG_LEVEL VLOG_LEVEL
+#else
+#define ROO_LOGGING_DEFAULT_VLOG_LEVEL -1
+#endif
+
+#define VLOG_IS_ON(verboselevel)                   \
+  ((verboselevel) <= ROO_LOGGING_MAX_VLOG_LEVEL && \
+   (verboselevel) <=                               \
+       ROO_LOGGING_SITE_LEVEL(nullptr, ROO_LOGGING_DEFAULT_VLOG_LEVEL))
+
+#elif defined(VLOG_LEVEL)
+// Note: VLOG(n) is on when n <= VLOG_LEVEL, as documented. (Older versions had
+// the comparison reversed, logging only VLOG(n) with n >= VLOG_LEVEL.)
+#define VLOG_IS_ON(verboselevel) ((verboselevel) <= VLOG_LEVEL)
 #else
 #define VLOG_IS_ON(verboselevel) 0
 #endif
@@ -65,6 +172,12 @@ ROO_DECLARE_FLAG(bool, roo_logging_freertos_log_core_id);
 #define ROO_LOGGING_SYMBOLIZE_STACKTRACE 1
 #endif
 
+#ifndef ROO_LOGGING_LOG_SEQUENCE
+#define ROO_LOGGING_LOG_SEQUENCE false
+#endif
+#ifndef ROO_LOGGING_TIMESTAMP_SOURCE
+#define ROO_LOGGING_TIMESTAMP_SOURCE 0
+#endif
 #ifndef ROO_LOGGING_COLORLOGTOSTDERR
 #define ROO_LOGGING_COLORLOGTOSTDERR false
 #endif
@@ -77,6 +190,90 @@ ROO_DECLARE_FLAG(bool, roo_logging_freertos_log_core_id);
 #ifndef ROO_LOGGING_FREERTOS_LOG_CORE_ID
 #define ROO_LOGGING_FREERTOS_LOG_CORE_ID 0
 #endif
+#ifndef ROO_LOGGING_DEDUP
+#define ROO_LOGGING_DEDUP false
+#endif
+#ifndef ROO_LOGGING_DEDUP_WINDOW_MS
+#define ROO_LOGGING_DEDUP_WINDOW_MS 10000
+#endif
+// Longest message (excluding the prefix) that roo_logging_dedup can
+// collapse; it keeps a copy of the previous message, of up to this length.
+#ifndef ROO_LOGGING_DEDUP_MAX_LEN
+#define ROO_LOGGING_DEDUP_MAX_LEN 128
+#endif
+#ifndef ROO_LOGGING_MAX_MESSAGE_LEN
+#define ROO_LOGGING_MAX_MESSAGE_LEN 1024
+#endif
+#ifndef ROO_LOGGING_EARLY_BUFFER_SIZE
+#define ROO_LOGGING_EARLY_BUFFER_SIZE 0
+#endif
+#ifndef ROO_LOGGING_SINK_LATENCY_BUDGET_MS
+#define ROO_LOGGING_SINK_LATENCY_BUDGET_MS 0
+#endif
+#ifndef ROO_LOGGING_SINK_TRIP_COUNT
+#define ROO_LOGGING_SINK_TRIP_COUNT 3
+#endif
+#ifndef ROO_LOGGING_SINK_RETRY_MS
+#define ROO_LOGGING_SINK_RETRY_MS 1000
+#endif
+#ifndef ROO_LOGGING_OVERFLOW_LIMIT
+#define ROO_LOGGING_OVERFLOW_LIMIT 0
+#endif
+
+namespace roo_logging {
+
+/// Copy of the flags that are read for every message, so that the logging
+/// path reads a single pointer, instead of each flag separately, and sees a
+/// consistent configuration even if the flags change while a message is being
+/// logged.
+///
+/// A new snapshot is published by PublishConfig(), which is called whenever
+/// one of the flags below is set (see ConfigFlag). The other flags are read
+/// directly, as before.
+struct alignas(64) ConfigSnapshot {
+  roo_time::WallTimeClock* wall_time_clock;
+  roo_time::TimeZone timezone;
+  // Incremented with each published snapshot.
+  uint32_t generation;
+  uint32_t overflow_limit;
+  uint32_t sink_latency_budget_ms;
+  uint8_t minloglevel;
+  uint8_t timestamp_source;
+  bool prefix;
+  bool log_sequence;
+  bool colorlogtostderr;
+  bool freertos_log_core_id;
+  bool dedup;
+  // Number of holders (see AcquireConfig()). PublishConfig() does not reuse
+  // the snapshot while it is non-zero.
+  mutable std::atomic<uint32_t> users;
+};
+
+/// Returns the current snapshot, and pins it: it stays valid and unchanged
+/// until released with ReleaseConfig(). Each message pins the snapshot for
+/// its whole lifetime, at the cost of an atomic increment and decrement.
+const ConfigSnapshot* AcquireConfig();
+
+/// Releases a snapshot obtained from AcquireConfig().
+void ReleaseConfig(const ConfigSnapshot* snapshot);
+
+/// Pins the current snapshot for the lifetime of the object.
+class ConfigRef {
+ public:
+  ConfigRef() : snapshot_(AcquireConfig()) {}
+  ~ConfigRef() { ReleaseConfig(snapshot_); }
+
+  ConfigRef(const ConfigRef&) = delete;
+  ConfigRef& operator=(const ConfigRef&) = delete;
+
+  const ConfigSnapshot& operator*() const { return *snapshot_; }
+  const ConfigSnapshot* operator->() const { return snapshot_; }
+
+ private:
+  const ConfigSnapshot* snapshot_;
+};
+
+}  // namespace roo_logging
 
 #if defined(ARDUINO)
 #include <Arduino.h>
@@ -0,0 +1,764 @@
+#include "roo_logging/debug_line.h"
+
+#if defined(ROO_LOGGING_HAVE_SYMBOLIZE) && defined(__ELF__)
+
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+
+#include "roo_logging/itoa.h"
+
+namespace roo_logging {
+
+namespace {
+
+// Standard opcodes of the line number program (DWARF 5, section 6.2.5.2).
+enum : uint8_t {
+  kCopy = 1,
+  kAdvancePc = 2,
+  kAdvanceLine = 3,
+  kSetFile = 4,
+  kConstAddPc = 8,
+  kFixedAdvancePc = 9,
+};
+
+// Extended opcodes (section 6.2.5.3).
+enum : uint8_t {
+  kEndSequence = 1,
+  kSetAddress = 2,
+  kDefineFile = 3,
+};
+
+// Content types of the DWARF 5 directory and file name entries (section
+// 6.2.4.1).
+enum : uint64_t {
+  kContentPath = 1,
+};
+
+// Attribute forms that can appear in these entries (section 7.5.6).
+enum : uint64_t {
+  kFormBlock2 = 0x03,
+  kFormBlock4 = 0x04,
+  kFormData2 = 0x05,
+  kFormData4 = 0x06,
+  kFormData8 = 0x07,
+  kFormString = 0x08,
+  kFormBlock = 0x09,
+  kFormBlock1 = 0x0a,
+  kFormData1 = 0x0b,
+  kFormSdata = 0x0d,
+  kFormStrp = 0x0e,
+  kFormUdata = 0x0f,
+  kFormData16 = 0x1e,
+  kFormLineStrp = 0x1f,
+};
+
+// Reads a section, with bounds checks. Reading past the end clears ok, and
+// yields zeros (or empty strings).
+struct Reader {
+  const uint8_t* cur;
+  const uint8_t* end;
+  bool ok;
+
+  Reader(const uint8_t* begin, const uint8_t* end)
+      : cur(begin), end(end), ok(true) {}
+
+  bool Has(uint64_t n) {
+    if ((uint64_t)(end - cur) >= n) return true;
+    ok = false;
+    cur = end;
+    return false;
+  }
+
+  void Skip(uint64_t n) {
+    if (Has(n)) cur += n;
+  }
+
+  // Reads a little- or big-endian (as per the host) unsigned integer.
+  uint64_t Fixed(int size) {
+    if (!Has(size)) return 0;
+    uint64_t value;
+    switch (size) {
+      case 1:
+        value = *cur;
+        break;
+      case 2: {
+        uint16_t v;
+        memcpy(&v, cur, 2);
+        value = v;
+        break;
+      }
+      case 4: {
+        uint32_t v;
+        memcpy(&v, cur, 4);
+        value = v;
+        break;
+      }
+      default: {
+        uint64_t v;
+        memcpy(&v, cur, 8);
+        value = v;
+        break;
+      }
+    }
+    cur += size;
+    return value;
+  }
+
+  uint64_t Uleb() {
+    uint64_t value = 0;
+    int shift = 0;
+    while (Has(1)) {
+      uint8_t byte = *cur++;
+      if (shift < 64) value |= (uint64_t)(byte & 0x7f) << shift;
+      shift += 7;
+      if ((byte & 0x80) == 0) break;
+    }
+    return value;
+  }
+
+  int64_t Sleb() {
+    uint64_t value = 0;
+    int shift = 0;
+    uint8_t byte = 0;
+    while (Has(1)) {
+      byte = *cur++;
+      if (shift < 64) value |= (uint64_t)(byte & 0x7f) << shift;
+      shift += 7;
+      if ((byte & 0x80) == 0) break;
+    }
+    if (shift < 64 && (byte & 0x40) != 0) value |= ~(uint64_t)0 << shift;
+    return (int64_t)value;
+  }
+
+  const char* String() {
+    const void* nul = memchr(cur, '\0', end - cur);
+    if (nul == nullptr) {
+      ok = false;
+      cur = end;
+      return "";
+    }
+    const char* str = (const char*)cur;
+    cur = (const uint8_t*)nul + 1;
+    return str;
+  }
+};
+
+// A section of the object file, mapped into memory.
+class MappedSection {
+ public:
+  MappedSection() : map_(MAP_FAILED), map_size_(0), data_(nullptr), size_(0) {}
+
+  ~MappedSection() {
+    if (map_ != MAP_FAILED) munmap(map_, map_size_);
+  }
+
+  // name_len includes the terminating '\0'. Fails if the section is missing,
+  // empty, or compressed.
+  bool Map(int fd, off_t file_size, const char* name, size_t name_len) {
+    ElfW(Shdr) header;
+    if (!GetSectionHeaderByName(fd, name, name_len, &header)) return false;
+    if (header.sh_type == SHT_NOBITS || header.sh_size == 0 ||
+        header.sh_offset + header.sh_size > (uint64_t)file_size) {
+      return false;
+    }
+#ifdef SHF_COMPRESSED
+    if ((header.sh_flags & SHF_COMPRESSED) != 0) return false;
+#endif
+    off_t page_size = sysconf(_SC_PAGESIZE);
+    off_t start = header.sh_offset & ~(page_size - 1);
+    map_size_ = header.sh_offset - start + header.sh_size;
+    map_ = mmap(nullptr, map_size_, PROT_READ, MAP_PRIVATE, fd, start);
+    if (map_ == MAP_FAILED) return false;
+    data_ = (const uint8_t*)map_ + (header.sh_offset - start);
+    size_ = header.sh_size;
+    return true;
+  }
+
+  const uint8_t* data() const { return data_; }
+  size_t size() const { return size_; }
+
+  // Returns the '\0'-terminated string at the offset, or nullptr.
+  const char* StringAt(uint64_t offset) const {
+    if (offset >= size_) return nullptr;
+    const char* str = (const char*)data_ + offset;
+    return memchr(str, '\0', size_ - offset) != nullptr ? str : nullptr;
+  }
+
+ private:
+  MappedSection(const MappedSection&) = delete;
+  MappedSection& operator=(const MappedSection&) = delete;
+
+  void* map_;
+  size_t map_size_;
+  const uint8_t* data_;
+  size_t size_;
+};
+
+// The sections that the line tables refer to.
+struct Sections {
+  MappedSection line;
+  MappedSection str;
+  MappedSection line_str;
+};
+
+// An entry of the index: the first address of a run of instructions from
+// the same source line.
+struct LineEntry {
+  // Relative to the index's base address.
+  uint32_t address;
+  // Offset of the base name of the source file in the index's names.
+  uint32_t name;
+  // Zero at the end of a sequence (i.e., no source line).
+  uint32_t line;
+};
+
+bool operator<(const LineEntry& a, const LineEntry& b) {
+  // At the same address, the end of one sequence precedes the start of the
+  // next one.
+  return a.address < b.address ||
+         (a.address == b.address && a.line == 0 && b.line != 0);
+}
+
+const char* BaseName(const char* path) {
+  const char* slash = strrchr(path, '/');
+  return slash != nullptr ? slash + 1 : path;
+}
+
+// FNV-1a.
+uint32_t Hash(const char* str) {
+  uint32_t hash = 2166136261u;
+  for (; *str != '\0'; ++str) {
+    hash = (hash ^ (uint8_t)*str) * 16777619u;
+  }
+  return hash;
+}
+
+// Collects the rows and the file names of the line tables. Runs in two
+// passes over the line number programs: the first one only counts, so that
+// the memory for the second one can be allocated up front.
+class TableBuilder {
+ public:
+  TableBuilder()
+      : counting_(true),
+        rows_(0),
+        files_(0),
+        name_bytes_(0),
+        max_unit_files_(0),
+        min_address_(UINT64_MAX),
+        max_address_(0),
+        entries_offset_(0),
+        entries_(nullptr),
+        names_(nullptr),
+        unit_names_(nullptr),
+        hash_(nullptr),
+        hash_mask_(0),
+        first_file_(1),
+        unit_files_(0),
+        in_sequence_(false),
+        skip_sequence_(false),
+        new_sequence_(true) {}
+
+  // Ends the counting pass. Returns the number of bytes needed for the
+  // second one.
+  size_t FinishCounting() {
+    counting_ = false;
+    size_t hash_size = 1;
+    while (hash_size < 2 * files_) hash_size *= 2;
+    hash_mask_ = hash_size - 1;
+    return Align(name_bytes_) + rows_ * sizeof(LineEntry) +
+           max_unit_files_ * sizeof(uint32_t) + hash_size * sizeof(uint32_t);
+  }
+
+  // Sets the (zeroed) memory for the second pass.
+  void SetStorage(uint8_t* storage) {
+    names_ = (char*)storage;
+    entries_offset_ = Align(name_bytes_);
+    entries_ = (LineEntry*)(storage + entries_offset_);
+    unit_names_ = (uint32_t*)(entries_ + rows_);
+    hash_ = unit_names_ + max_unit_files_;
+    name_bytes_ = 0;
+    rows_ = 0;
+  }
+
+  void BeginUnit(int first_file) {
+    first_file_ = first_file;
+    unit_files_ = 0;
+    in_sequence_ = false;
+    new_sequence_ = true;
+  }
+
+  void AddFile(const char* path) {
+    const char* name = BaseName(path);
+    ++unit_files_;
+    if (counting_) {
+      ++files_;
+      name_bytes_ += strlen(name) + 1;
+      max_unit_files_ = std::max(max_unit_files_, unit_files_);
+      return;
+    }
+    unit_names_[unit_files_ - 1] = Intern(name);
+  }
+
+  void AddRow(uint64_t address, uint64_t file, uint64_t line,
+              bool end_sequence) {
+    if (!in_sequence_) {
+      in_sequence_ = true;
+      // Code removed by the linker (e.g., with --gc-sections) keeps its line
+      // table, with addresses relative to zero (or to -1 with lld).
+      skip_sequence_ = address == 0 || address == UINT32_MAX ||
+                       address == UINT64_MAX;
+    }
+    if (end_sequence) in_sequence_ = false;
+    if (skip_sequence_) return;
+    if (counting_) {
+      ++rows_;
+      min_address_ = std::min(min_address_, address);
+      max_address_ = std::max(max_address_, address);
+      return;
+    }
+    LineEntry entry;
+    entry.address = (uint32_t)(address - min_address_);
+    entry.name = 0;
+    entry.line = 0;
+    if (!end_sequence) {
+      file -= first_file_;
+      // Out of range files, and lines, are treated as unknown.
+      if (file < unit_files_ && line <= UINT32_MAX) {
+        entry.name = unit_names_[file];
+        entry.line = (uint32_t)line;
+      }
+    }
+    // Of rows at the same address, the last one applies.
+    if (rows_ > 0 && !new_sequence_ &&
+        entries_[rows_ - 1].address == entry.address) {
+      entries_[rows_ - 1] = entry;
+    } else {
+      entries_[rows_++] = entry;
+    }
+    new_sequence_ = end_sequence;
+  }
+
+  bool empty() const { return rows_ == 0; }
+
+  // Whether the addresses fit the index's 32-bit offsets.
+  bool fits() const { return max_address_ - min_address_ <= UINT32_MAX; }
+
+  uint64_t base() const { return min_address_; }
+  const char* names() const { return names_; }
+  const LineEntry* entries() const { return entries_; }
+  size_t rows() const { return rows_; }
+
+  // Bytes used by the names and the entries, once Finish() is called. (The
+  // entries start where SetStorage() put them, past the space reserved for
+  // all the names, duplicates included, not past the interned ones.)
+  size_t used_bytes() const {
+    return entries_offset_ + rows_ * sizeof(LineEntry);
+  }
+
+  // Sorts the entries by address, and merges the consecutive ones from the
+  // same line.
+  void Finish() {
+    std::sort(entries_, entries_ + rows_);
+    size_t count = 0;
+    for (size_t i = 0; i < rows_; ++i) {
+      if (count > 0 && entries_[count - 1].line == entries_[i].line &&
+          entries_[count - 1].name == entries_[i].name) {
+        continue;
+      }
+      entries_[count++] = entries_[i];
+    }
+    rows_ = count;
+  }
+
+ private:
+  static size_t Align(size_t size) {
+    return (size + alignof(LineEntry) - 1) & ~(alignof(LineEntry) - 1);
+  }
+
+  // Returns the offset of the name in names_, adding it if needed.
+  uint32_t Intern(const char* name) {
+    for (size_t i = Hash(name) & hash_mask_;; i = (i + 1) & hash_mask_) {
+      if (hash_[i] == 0) {
+        uint32_t offset = (uint32_t)name_bytes_;
+        size_t size = strlen(name) + 1;
+        memcpy(names_ + offset, name, size);
+        name_bytes_ += size;
+        // Offsets are stored plus one, so that zero means empty.
+        hash_[i] = offset + 1;
+        return offset;
+      }
+      if (strcmp(names_ + hash_[i] - 1, name) == 0) return hash_[i] - 1;
+    }
+  }
+
+  bool counting_;
+  size_t rows_;
+  size_t files_;
+  size_t name_bytes_;
+  size_t max_unit_files_;
+  uint64_t min_address_;
+  uint64_t max_address_;
+
+  size_t entries_offset_;
+  LineEntry* entries_;
+  char* names_;
+  // Offsets of the names of the current unit's files, in names_.
+  uint32_t* unit_names_;
+  uint32_t* hash_;
+  size_t hash_mask_;
+
+  // State of the current unit.
+  int first_file_;
+  size_t unit_files_;
+  bool in_sequence_;
+  bool skip_sequence_;
+  // Whether the last stored row ended a sequence.
+  bool new_sequence_;
+};
+
+// Reads an attribute of a DWARF 5 directory or file name entry. Sets *str
+// for the string forms. Returns false for unsupported forms.
+bool ReadForm(Reader* reader, uint64_t form, int offset_size,
+              const Sections& sections, const char** str) {
+  *str = nullptr;
+  switch (form) {
+    case kFormString:
+      *str = reader->String();
+      return true;
+    case kFormStrp:
+      *str = sections.str.StringAt(reader->Fixed(offset_size));
+      return true;
+    case kFormLineStrp:
+      *str = sections.line_str.StringAt(reader->Fixed(offset_size));
+      return true;
+    case kFormData1:
+      reader->Skip(1);
+      return true;
+    case kFormData2:
+      reader->Skip(2);
+      return true;
+    case kFormData4:
+      reader->Skip(4);
+      return true;
+    case kFormData8:
+      reader->Skip(8);
+      return true;
+    case kFormData16:
+      reader->Skip(16);
+      return true;
+    case kFormUdata:
+      reader->Uleb();
+      return true;
+    case kFormSdata:
+      reader->Sleb();
+      return true;
+    case kFormBlock1:
+      reader->Skip(reader->Fixed(1));
+      return true;
+    case kFormBlock2:
+      reader->Skip(reader->Fixed(2));
+      return true;
+    case kFormBlock4:
+      reader->Skip(reader->Fixed(4));
+      return true;
+    case kFormBlock:
+      reader->Skip(reader->Uleb());
+      return true;
+    default:
+      return false;
+  }
+}
+
+// Reads the DWARF 5 directory or file name entries; passes the file names
+// (if files is true) to the builder.
+bool ReadEntries(Reader* reader, int offset_size, const Sections& sections,
+                 bool files, TableBuilder* builder) {
+  // Up to this many (content type, form) pairs per entry.
+  constexpr int kMaxFormats = 8;
+  uint64_t types[kMaxFormats];
+  uint64_t forms[kMaxFormats];
+  int format_count = reader->Fixed(1);
+  if (format_count > kMaxFormats) return false;
+  for (int i = 0; i < format_count; ++i) {
+    types[i] = reader->Uleb();
+    forms[i] = reader->Uleb();
+  }
+  uint64_t count = reader->Uleb();
+  for (uint64_t i = 0; i < count && reader->ok; ++i) {
+    const char* path = nullptr;
+    for (int j = 0; j < format_count; ++j) {
+      const char* str;
+      if (!ReadForm(reader, forms[j], offset_size, sections, &str)) {
+        return false;
+      }
+      if (types[j] == kContentPath) path = str;
+    }
+    if (files) builder->AddFile(path != nullptr ? path : "??");
+  }
+  return reader->ok;
+}
+
+// Runs the line number program of one unit (DWARF versions 2 to 5), whose
+// header starts after the unit length.
+void ParseUnit(Reader unit, int offset_size, const Sections& sections,
+               TableBuilder* builder) {
+  int version = unit.Fixed(2);
+  if (version < 2 || version > 5) return;
+  if (version >= 5) {
+    unit.Skip(2);  // Address and segment selector sizes.
+  }
+  uint64_t header_length = unit.Fixed(offset_size);
+  if (!unit.Has(header_length)) return;
+  Reader program(unit.cur + header_length, unit.end);
+  int min_instruction_length = unit.Fixed(1);
+  if (version >= 4) {
+    unit.Skip(1);  // Maximum operations per instruction (for VLIW).
+  }
+  unit.Skip(1);  // Default is_stmt.
+  int line_base = (int8_t)unit.Fixed(1);
+  int line_range = unit.Fixed(1);
+  int opcode_base = unit.Fixed(1);
+  if (line_range == 0 || opcode_base == 0) return;
+  const uint8_t* opcode_lengths = unit.cur;
+  unit.Skip(opcode_base - 1);
+  if (!unit.ok) return;
+
+  builder->BeginUnit(version >= 5 ? 0 : 1);
+  if (version >= 5) {
+    if (!ReadEntries(&unit, offset_size, sections, false, builder) ||
+        !ReadEntries(&unit, offset_size, sections, true, builder)) {
+      return;
+    }
+  } else {
+    while (unit.ok && *unit.String() != '\0') {
+    }
+    while (unit.ok) {
+      const char* path = unit.String();
+      if (*path == '\0') break;
+      unit.Uleb();  // Directory.
+      unit.Uleb();  // Modification time.
+      unit.Uleb();  // Length.
+      builder->AddFile(path);
+    }
+  }
+  if (!unit.ok) return;
+
+  uint64_t address = 0;
+  uint64_t file = 1;
+  int64_t line = 1;
+  while (program.ok && program.cur < program.end) {
+    int opcode = program.Fixed(1);
+    if (opcode >= opcode_base) {
+      int adjusted = opcode - opcode_base;
+      address += min_instruction_length * (adjusted / line_range);
+      line += line_base + adjusted % line_range;
+      builder->AddRow(address, file, line, false);
+      continue;
+    }
+    switch (opcode) {
+      case 0: {
+        uint64_t length = program.Uleb();
+        if (length == 0 || !program.Has(length)) break;
+        Reader extended(program.cur, program.cur + length);
+        program.cur += length;
+        switch (extended.Fixed(1)) {
+          case kEndSequence:
+            builder->AddRow(address, file, line, true);
+            address = 0;
+            file = 1;
+            line = 1;
+            break;
+          case kSetAddress:
+            if (length == 5 || length == 9) {
+              address = extended.Fixed(length - 1);
+            }
+            break;
+          case kDefineFile:
+            builder->AddFile(extended.String());
+            break;
+          default:
+            break;
+        }
+        break;
+      }
+      case kCopy:
+        builder->AddRow(address, file, line, false);
+        break;
+      case kAdvancePc:
+        address += min_instruction_length * program.Uleb();
+        break;
+      case kAdvanceLine:
+        line += program.Sleb();
+        break;
+      case kSetFile:
+        file = program.Uleb();
+        break;
+      case kConstAddPc:
+        address += min_instruction_length * ((255 - opcode_base) / line_range);
+        break;
+      case kFixedAdvancePc:
+        address += program.Fixed(2);
+        break;
+      default:
+        // Other standard opcodes only set registers that are not used here.
+        for (int i = 0; i < opcode_lengths[opcode - 1]; ++i) program.Uleb();
+        break;
+    }
+  }
+}
+
+void ParseLineTables(const Sections& sections, TableBuilder* builder) {
+  Reader section(sections.line.data(),
+                 sections.line.data() + sections.line.size());
+  while (section.ok && section.cur < section.end) {
+    int offset_size = 4;
+    uint64_t length = section.Fixed(4);
+    if (length == 0xffffffff) {
+      offset_size = 8;
+      length = section.Fixed(8);
+    }
+    if (!section.Has(length)) break;
+    ParseUnit(Reader(section.cur, section.cur + length), offset_size, sections,
+              builder);
+    section.cur += length;
+  }
+}
+
+// The index of an object file. Objects without line tables have no entries.
+struct ObjectIndex {
+  dev_t device;
+  ino_t inode;
+  off_t size;
+  uint64_t base;
+  const LineEntry* entries;
+  size_t count;
+  const char* names;
+};
+
+ObjectIndex objects[ROO_LOGGING_DEBUG_LINE_MAX_OBJECTS];
+
+// Number of the (complete) objects.
+std::atomic<int> object_count(0);
+
+// Held while indexing.
+std::atomic_flag indexing = ATOMIC_FLAG_INIT;
+
+void BuildIndex(int fd, off_t file_size, ObjectIndex* index) {
+  index->entries = nullptr;
+  index->count = 0;
+  Sections sections;
+  if (!sections.line.Map(fd, file_size, ".debug_line", sizeof(".debug_line"))) {
+    return;
+  }
+  sections.str.Map(fd, file_size, ".debug_str", sizeof(".debug_str"));
+  sections.line_str.Map(fd, file_size, ".debug_line_str",
+                        sizeof(".debug_line_str"));
+  TableBuilder builder;
+  ParseLineTables(sections, &builder);
+  if (builder.empty() || !builder.fits()) return;
+  size_t size = builder.FinishCounting();
+  void* storage = mmap(nullptr, size, PROT_READ | PROT_WRITE,
+                       MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (storage == MAP_FAILED) return;
+  builder.SetStorage((uint8_t*)storage);
+  ParseLineTables(sections, &builder);
+  builder.Finish();
+  // Returns the pages past the entries (i.e., the ones used only while
+  // building).
+  size_t page_size = sysconf(_SC_PAGESIZE);
+  size_t used = (builder.used_bytes() + page_size - 1) & ~(page_size - 1);
+  if (used < size) munmap((uint8_t*)storage + used, size - used);
+  index->base = builder.base();
+  index->entries = builder.entries();
+  index->count = builder.rows();
+  index->names = builder.names();
+}
+
+// Returns the index of the object, building it if needed, or nullptr.
+const ObjectIndex* GetIndex(int fd) {
+  struct stat st;
+  if (fstat(fd, &st) != 0) return nullptr;
+  int count = object_count.load(std::memory_order_acquire);
+  for (int i = 0; i < count; ++i) {
+    const ObjectIndex& index = objects[i];
+    if (index.device == st.st_dev && index.inode == st.st_ino &&
+        index.size == st.st_size) {
+      return &index;
+    }
+  }
+  if (indexing.test_and_set(std::memory_order_acquire)) return nullptr;
+  const ObjectIndex* result = nullptr;
+  // Another thread might have indexed the object meanwhile.
+  int new_count = object_count.load(std::memory_order_relaxed);
+  for (int i = count; i < new_count; ++i) {
+    const ObjectIndex& index = objects[i];
+    if (index.device == st.st_dev && index.inode == st.st_ino &&
+        index.size == st.st_size) {
+      result = &index;
+    }
+  }
+  if (result == nullptr && new_count < ROO_LOGGING_DEBUG_LINE_MAX_OBJECTS) {
+    ObjectIndex& index = objects[new_count];
+    index.device = st.st_dev;
+    index.inode = st.st_ino;
+    index.size = st.st_size;
+    BuildIndex(fd, st.st_size, &index);
+    object_count.store(new_count + 1, std::memory_order_release);
+    result = &index;
+  }
+  indexing.clear(std::memory_order_release);
+  return result;
+}
+
+}  // namespace
+
+bool LookupDebugLine(int fd, uint64_t address, const char** file, int* line) {
+  const ObjectIndex* index = GetIndex(fd);
+  if (index == nullptr || index->count == 0 || address < index->base ||
+      address - index->base > UINT32_MAX) {
+    return false;
+  }
+  LineEntry key;
+  key.address = (uint32_t)(address - index->base);
+  key.name = 0;
+  key.line = 1;
+  // The last entry at or before the address.
+  const LineEntry* entry =
+      std::upper_bound(index->entries, index->entries + index->count, key);
+  if (entry == index->entries) return false;
+  --entry;
+  if (entry->line == 0) return false;
+  *file = index->names + entry->name;
+  *line = (int)entry->line;
+  return true;
+}
+
+int DebugLineSymbolizeCallback(int fd, void* pc, char* out, size_t out_size,
+                               uint64_t relocation) {
+  const char* file;
+  int line;
+  if (!LookupDebugLine(fd, reinterpret_cast<uintptr_t>(pc) - relocation, &file,
+                       &line)) {
+    return -1;
+  }
+  char digits[kMaxIntegerChars];
+  size_t digits_length = FormatInteger(line, false, 10, digits);
+  size_t file_length = strlen(file);
+  size_t length = file_length + 1 + digits_length + 1;
+  // Leaves most of the space to the symbol name.
+  if (length > out_size / 2) return -1;
+  memcpy(out, file, file_length);
+  out[file_length] = ':';
+  memcpy(out + file_length + 1, digits, digits_length);
+  out[length - 1] = ' ';
+  return (int)length;
+}
+
+}  // namespace roo_logging
+
+#endif  // defined(ROO_LOGGING_HAVE_SYMBOLIZE) && defined(__ELF__)
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "roo_logging/symbolize.h"
+
+#if defined(ROO_LOGGING_HAVE_SYMBOLIZE) && defined(__ELF__)
+
+// Source file and line resolution for stack traces, from the DWARF line
+// tables (the .debug_line section) of the executable and the shared
+// libraries. Needs debug info (e.g., -g, or -gmlt / -g1, which is enough).
+//
+// The line table of an object is parsed on the first lookup in it, into a
+// compact index (12 bytes per run of instructions on the same line, sorted
+// by address, plus the deduplicated base names of the source files), which
+// is then searched with binary search. Memory for the index is obtained
+// with mmap(), not from the heap, so that lookups can be done (and the
+// index built) from the signal handlers that print stack traces.
+
+/// If 1, DebugLineSymbolizeCallback() is installed by default, so that
+/// stack traces show "file:line" for each frame.
+#ifndef ROO_LOGGING_SYMBOLIZE_DEBUG_LINE
+#define ROO_LOGGING_SYMBOLIZE_DEBUG_LINE 1
+#endif
+
+/// Maximum number of object files whose line tables are indexed.
+#ifndef ROO_LOGGING_DEBUG_LINE_MAX_OBJECTS
+#define ROO_LOGGING_DEBUG_LINE_MAX_OBJECTS 16
+#endif
+
+namespace roo_logging {
+
+/// Looks up the source location of the address (as in the object file,
+/// i.e. without the load bias) in the line table of the ELF object file open
+/// as fd, indexing the table first if needed. On success, sets *file to the
+/// base name of the source file (valid for the lifetime of the process), and
+/// *line to the line number, and returns true. Returns false if the object
+/// has no (uncompressed) line table, or no entry for the address, or if
+/// another thread is indexing, or if ROO_LOGGING_DEBUG_LINE_MAX_OBJECTS
+/// objects are already indexed. Thread-safe and async-signal-safe.
+bool LookupDebugLine(int fd, uint64_t address, const char** file, int* line);
+
+/// A SymbolizeCallback that writes "file:line " (see LookupDebugLine()),
+/// which then precedes the symbol name.
+int DebugLineSymbolizeCallback(int fd, void* pc, char* out, size_t out_size,
+                               uint64_t relocation);
+
+}  // namespace roo_logging
+
+#endif  // defined(ROO_LOGGING_HAVE_SYMBOLIZE) && defined(__ELF__)
@@ -0,0 +1,139 @@
+#include "roo_logging/dedup.h"
+
+#include <stdint.h>
+#include <string.h>
+
+#include "roo_logging/config.h"
+#include "roo_logging/sink.h"
+#include "roo_logging/stderr.h"
+#include "roo_logging/stream.h"
+#include "roo_threads.h"
+#include "roo_threads/mutex.h"
+
+namespace roo_logging {
+
+// Defined in log_message.cpp.
+roo::mutex& log_mutex();
+
+namespace {
+
+// Describes the last dispatched message, and the repeats suppressed since.
+// Guarded by the log mutex.
+struct RepeatState {
+  bool valid;
+  char text[ROO_LOGGING_DEDUP_MAX_LEN];
+  size_t len;
+  LogSeverity severity;
+  const char* full_filename;
+  const char* base_filename;
+  int line;
+
+  // Start of the current suppression window.
+  roo_time::Uptime window_start;
+
+  uint32_t count;
+  roo_time::Uptime first_uptime;
+  roo_time::WallTime first_walltime;
+  roo_time::Uptime last_uptime;
+  roo_time::WallTime last_walltime;
+};
+
+RepeatState state;
+
+void WriteTimestamp(Stream& s, const ConfigSnapshot& config,
+                    roo_time::Uptime uptime, roo_time::WallTime walltime) {
+  if (config.wall_time_clock == nullptr) {
+    s << uptime;
+  } else {
+    s << roo_time::DateTime(walltime, config.timezone);
+  }
+}
+
+void EmitSummary() {
+  ConfigRef config;
+  char buf[200];
+  Stream s(buf, sizeof(buf) - 1);
+  if (config->prefix) {
+    s << LogSeverityNames[state.severity][0];
+    WriteTimestamp(s, *config, state.last_uptime, state.last_walltime);
+    s << " " << state.base_filename << ":" << state.line << "] ";
+  }
+  size_t prefix_len = s.pcount();
+  s << "Last message repeated " << (unsigned long)state.count
+    << " times (first at ";
+  WriteTimestamp(s, *config, state.first_uptime, state.first_walltime);
+  s << ", last at ";
+  WriteTimestamp(s, *config, state.last_uptime, state.last_walltime);
+  s << ")";
+  size_t len = s.pcount();
+  buf[len++] = '\n';
+  buf[len] = '\0';
+  MaybeLogToStderr(*config, state.severity, buf, len, false);
+  MaybeLogToSink(*config,
+                 LogRecord{0, state.severity, state.full_filename,
+                           state.base_filename, state.line, state.last_uptime,
+                           state.last_walltime, buf + prefix_len,
+                           len - prefix_len - 1, LogFields()});
+  state.count = 0;
+}
+
+}  // namespace
+
+bool SuppressRepeatedMessage(LogSeverity severity, const char* full_filename,
+                             const char* base_filename, int line,
+                             roo_time::Uptime uptime,
+                             roo_time::WallTime walltime, const char* message,
+                             size_t message_len) {
+  bool window_elapsed =
+      (uptime - state.window_start) >=
+      roo_time::Millis(GET_ROO_FLAG(roo_logging_dedup_window_ms));
+  if (state.valid && severity != ROO_LOGGING_FATAL &&
+      message_len == state.len && severity == state.severity &&
+      ((full_filename == state.full_filename && line == state.line) ||
+       !window_elapsed) &&
+      memcmp(message, state.text, message_len) == 0) {
+    if (state.count == 0) {
+      state.first_uptime = uptime;
+      state.first_walltime = walltime;
+    }
+    ++state.count;
+    state.last_uptime = uptime;
+    state.last_walltime = walltime;
+    if (window_elapsed) {
+      EmitSummary();
+      state.window_start = uptime;
+    }
+    return true;
+  }
+  if (state.count > 0) EmitSummary();
+  // Messages too long to copy can't be compared, so they are never repeats.
+  state.valid = message_len <= sizeof(state.text);
+  if (state.valid) memcpy(state.text, message, message_len);
+  state.len = message_len;
+  state.severity = severity;
+  state.full_filename = full_filename;
+  state.base_filename = base_filename;
+  state.line = line;
+  state.window_start = uptime;
+  return false;
+}
+
+void EmitPendingRepeatSummary() {
+  if (state.count > 0) EmitSummary();
+  state.valid = false;
+}
+
+void FlushRepeatedMessages(bool force) {
+  roo::lock_guard<roo::mutex> lock(log_mutex());
+  if (state.count == 0) return;
+  roo_time::Uptime now = roo_time::Uptime::Now();
+  if (!force &&
+      (now - state.window_start) <
+          roo_time::Millis(GET_ROO_FLAG(roo_logging_dedup_window_ms))) {
+    return;
+  }
+  EmitSummary();
+  state.window_start = now;
+}
+
+}  // namespace roo_logging
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <stddef.h>
+
+#include "roo_logging/log_severity.h"
+#include "roo_time.h"
+
+namespace roo_logging {
+
+/// Repeated-message suppression. Called (under the log mutex) for each
+/// message, before it is dispatched to stderr and to the sink, if the
+/// roo_logging_dedup flag is set.
+///
+/// A message is considered a repeat if its text (excluding the prefix) and
+/// severity are identical to those of the previously dispatched message, and
+/// it either comes from the same call site, or arrives within
+/// roo_logging_dedup_window_ms of it. Repeats are dropped (and the function
+/// returns true). Instead, a "last message repeated N times" summary, with
+/// the timestamps of the first and the last repeat, is dispatched once per
+/// window while the repeats continue, and when a different message arrives.
+///
+/// The text is compared with a copy of the previous message, so only
+/// messages of up to ROO_LOGGING_DEDUP_MAX_LEN characters can be suppressed.
+/// FATAL messages are never suppressed.
+bool SuppressRepeatedMessage(LogSeverity severity, const char* full_filename,
+                             const char* base_filename, int line,
+                             roo_time::Uptime uptime,
+                             roo_time::WallTime walltime, const char* message,
+                             size_t message_len);
+
+/// Dispatches the pending summary of suppressed repeats, if any. Called
+/// (under the log mutex) for each message while roo_logging_dedup is off, so
+/// that turning it off does not lose the summary.
+void EmitPendingRepeatSummary();
+
+/// Dispatches the pending summary of suppressed repeats, if any, and if
+/// roo_logging_dedup_window_ms has passed since the previous summary (or
+/// since the first message); or, with force, right away. Otherwise, the
+/// summary of repeats that have stopped is held back until the next message.
+/// Call it periodically (e.g., from the main loop) if messages can be rare,
+/// and with force before exiting.
+void FlushRepeatedMessages(bool force = false);
+
+}  // namespace roo_logging
@@ -37,7 +37,9 @@
 #include "demangle.h"
 
 #include <algorithm>
+#include <atomic>
 #include <cstdlib>
+#include <cstring>
 #include <limits>
 
 // #include "utilities.h"
@@ -386,6 +388,7 @@ bool ParseIdentifier(State* state, int length);
 bool ParseAbiTags(State* state);
 bool ParseAbiTag(State* state);
 bool ParseOperatorName(State* state);
+bool ParseNonCastOperatorName(State* state);
 bool ParseSpecialName(State* state);
 bool ParseCallOffset(State* state);
 bool ParseNVOffset(State* state);
@@ -708,8 +711,13 @@ bool ParseOperatorName(State* state) {
     return true;
   }
   *state = copy;
+  return ParseNonCastOperatorName(state);
+}
 
-  // Then vendor extended operators.
+// The <operator-name>s other than the cast, which do not recurse.
+bool ParseNonCastOperatorName(State* state) {
+  // Vendor extended operators.
+  State copy = *state;
   if (ParseOneCharToken(state, 'v') && ParseCharClass(state, "0123456789") &&
       ParseSourceName(state)) {
     return true;
@@ -1283,6 +1291,7 @@ bool ParseSubstitution(State* state) {
   return false;
 }
 
+#if !ROO_LOGGING_DEMANGLE_BOUNDED
 // Parse <mangled-name>, optionally followed by either a function-clone suffix
 // or version suffix.  Returns true only if all of "mangled_cur" was consumed.
 bool ParseTopLevelMangledName(State* state) {
@@ -1304,6 +1313,688 @@ bool ParseTopLevelMangledName(State* state) {
   }
   return false;
 }
+#endif
+
+// The bounded (non-recursive) parser, used by DemangleBounded().
+//
+// It follows the recursive parser above rule by rule, and call by call, so
+// that the results are the same. Each invocation of a recursive rule gets a
+// Frame on an explicit stack, instead of the C++ call stack; it holds the
+// saved state for backtracking (the "copy" in the functions above), and the
+// point at which to resume the rule when the callee returns. Rules that do
+// not recurse (ParseSourceName(), ParseSubstitution(), etc.) are called
+// directly, as their stack use is small and fixed; so are the recursive ones
+// on input on which they don't recurse (see ParseNameWithoutFrame()).
+//
+// The rules are the cases of a single switch, on the resume point. A call
+// (ROO_DEMANGLE_CALL) saves the resume point, derived from the line number of
+// the call, pushes the callee's frame, and jumps back to the switch; when the
+// callee returns (ROO_DEMANGLE_RETURN), its result is in "result", and the
+// caller's frame continues at the case label that follows the call. Hence,
+// there can be at most one call per line, and the rules can't keep local
+// variables across calls (they use the frame instead).
+
+enum Rule : uint16_t {
+  kTopLevelMangledNameRule,
+  kMangledNameRule,
+  kEncodingRule,
+  kNameRule,
+  kUnscopedNameRule,
+  kUnscopedTemplateNameRule,
+  kNestedNameRule,
+  kPrefixRule,
+  kUnqualifiedNameRule,
+  kOperatorNameRule,
+  kSpecialNameRule,
+  kTypeRule,
+  kFunctionTypeRule,
+  kBareFunctionTypeRule,
+  kArrayTypeRule,
+  kPointerToMemberTypeRule,
+  kTemplateArgsRule,
+  kTemplateArgRule,
+  kExpressionRule,
+  kExprPrimaryRule,
+  kLocalNameRule,
+  kRuleCount,
+};
+
+struct Frame {
+  State copy;
+  // The rule's entry point (a Rule), or a resume point (see
+  // ROO_DEMANGLE_RESUME_POINT).
+  uint16_t pc;
+  // ParsePrefix()'s "has_something".
+  bool has_something;
+};
+
+bool IsCastOperator(const char* cur) { return cur[0] == 'c' && cur[1] == 'v'; }
+
+// ParseUnqualifiedName(), for input that doesn't start with a cast operator.
+bool ParseNonCastUnqualifiedName(State* state) {
+  return (AtLeastNumCharsRemaining(state->mangled_cur, 2) &&
+          ParseNonCastOperatorName(state)) ||
+         ParseCtorDtorName(state) ||
+         (ParseSourceName(state) && Optional(ParseAbiTags(state))) ||
+         (ParseLocalSourceName(state) && Optional(ParseAbiTags(state)));
+}
+
+// Returns true if the rule fails, without side effects, as the input
+// doesn't start with the rule's prefix. Saves a push, and a dispatch, for the
+// many alternatives that are tried and rejected. Small enough to be inlined,
+// and reduced to a single comparison, at each call site.
+inline bool CannotMatch(Rule rule, char next) {
+  switch (rule) {
+    case kMangledNameRule:
+      return next != '_';
+    case kNestedNameRule:
+      return next != 'N';
+    case kSpecialNameRule:
+      return next != 'T' && next != 'G';
+    case kFunctionTypeRule:
+      return next != 'F';
+    case kArrayTypeRule:
+      return next != 'A';
+    case kPointerToMemberTypeRule:
+      return next != 'M';
+    case kTemplateArgsRule:
+      return next != 'I';
+    case kExprPrimaryRule:
+      return next != 'L';
+    default:
+      return false;
+  }
+}
+
+inline bool IsNameRule(Rule rule) {
+  return rule == kUnscopedNameRule || rule == kUnqualifiedNameRule ||
+         rule == kOperatorNameRule;
+}
+
+// Parses the names that don't recurse (all but cast operators) without a
+// frame. Returns false if the name needs one; otherwise, sets *result to the
+// rule's result.
+bool ParseNameWithoutFrame(Rule rule, State* state, bool* result) {
+  const char* cur = state->mangled_cur;
+  if (IsCastOperator(cur)) return false;
+  switch (rule) {
+    case kOperatorNameRule:
+      *result = AtLeastNumCharsRemaining(cur, 2) &&
+                ParseNonCastOperatorName(state);
+      return true;
+    case kUnqualifiedNameRule:
+      *result = ParseNonCastUnqualifiedName(state);
+      return true;
+    default: {  // kUnscopedNameRule.
+      if (cur[0] == 'S' && cur[1] == 't' && IsCastOperator(cur + 2)) {
+        return false;
+      }
+      if (ParseNonCastUnqualifiedName(state)) {
+        *result = true;
+        return true;
+      }
+      State copy = *state;
+      if (ParseTwoCharToken(state, "St") && MaybeAppend(state, "std::") &&
+          ParseNonCastUnqualifiedName(state)) {
+        *result = true;
+        return true;
+      }
+      *state = copy;
+      *result = false;
+      return true;
+    }
+  }
+}
+
+// Resume points are numbered after the rules, so that the cases of the
+// switch are dense enough to compile to a jump table.
+#define ROO_DEMANGLE_RESUME_POINT() (kRuleCount + __LINE__ - kFirstLine)
+
+#define ROO_DEMANGLE_CALL(rule)                        \
+  do {                                                 \
+    if (CannotMatch(rule, *state->mangled_cur)) {      \
+      result = false;                                  \
+      break;                                           \
+    }                                                  \
+    if (IsNameRule(rule) &&                            \
+        ParseNameWithoutFrame(rule, state, &result)) { \
+      break;                                           \
+    }                                                  \
+    frame->pc = ROO_DEMANGLE_RESUME_POINT();           \
+    if (++frame == end || ++steps > max_steps) {       \
+      return false;                                    \
+    }                                                  \
+    frame->pc = rule;                                  \
+    goto dispatch;                                     \
+    case ROO_DEMANGLE_RESUME_POINT():;                 \
+  } while (0)
+
+// Calls the rule, and returns its result. Reuses the frame of the caller.
+#define ROO_DEMANGLE_TAIL_CALL(rule)       \
+  do {                                     \
+    if (++steps > max_steps) return false; \
+    frame->pc = rule;                      \
+    goto dispatch;                         \
+  } while (0)
+
+#define ROO_DEMANGLE_RETURN(value) \
+  do {                             \
+    result = (value);              \
+    goto unwind;                   \
+  } while (0)
+
+constexpr int kFirstLine = __LINE__;
+
+// Returns false if the input is not a valid name, or if the parse needs more
+// than (end - stack) frames, or max_steps steps.
+bool ParseBounded(State* state, Frame* stack, Frame* end,
+                  uint32_t max_steps) {
+  if (stack == end) return false;
+  Frame* frame = stack;
+  frame->pc = kTopLevelMangledNameRule;
+  uint32_t steps = 0;
+  bool result = false;
+
+dispatch:
+  switch (frame->pc) {
+    case kTopLevelMangledNameRule:
+      ROO_DEMANGLE_CALL(kMangledNameRule);
+      if (!result) ROO_DEMANGLE_RETURN(false);
+      if (state->mangled_cur[0] != '\0') {
+        // Drop trailing function clone suffix, if any.
+        if (IsFunctionCloneSuffix(state->mangled_cur)) {
+          ROO_DEMANGLE_RETURN(true);
+        }
+        // Append trailing version suffix if any.
+        if (state->mangled_cur[0] == '@') {
+          MaybeAppend(state, state->mangled_cur);
+          ROO_DEMANGLE_RETURN(true);
+        }
+        ROO_DEMANGLE_TAIL_CALL(kNameRule);
+      }
+      ROO_DEMANGLE_RETURN(true);
+
+    case kMangledNameRule:
+      if (!ParseTwoCharToken(state, "_Z")) ROO_DEMANGLE_RETURN(false);
+      ROO_DEMANGLE_TAIL_CALL(kEncodingRule);
+
+    case kEncodingRule:
+      frame->copy = *state;
+      ROO_DEMANGLE_CALL(kNameRule);
+      if (result) {
+        ROO_DEMANGLE_CALL(kBareFunctionTypeRule);
+        if (result) ROO_DEMANGLE_RETURN(true);
+      }
+      *state = frame->copy;
+      ROO_DEMANGLE_CALL(kNameRule);
+      if (result) ROO_DEMANGLE_RETURN(true);
+      ROO_DEMANGLE_TAIL_CALL(kSpecialNameRule);
+
+    case kNameRule:
+      ROO_DEMANGLE_CALL(kNestedNameRule);
+      if (result) ROO_DEMANGLE_RETURN(true);
+      ROO_DEMANGLE_CALL(kLocalNameRule);
+      if (result) ROO_DEMANGLE_RETURN(true);
+      frame->copy = *state;
+      ROO_DEMANGLE_CALL(kUnscopedTemplateNameRule);
+      if (result) {
+        ROO_DEMANGLE_CALL(kTemplateArgsRule);
+        if (result) ROO_DEMANGLE_RETURN(true);
+      }
+      *state = frame->copy;
+      ROO_DEMANGLE_TAIL_CALL(kUnscopedNameRule);
+
+    case kUnscopedNameRule:
+      ROO_DEMANGLE_CALL(kUnqualifiedNameRule);
+      if (result) ROO_DEMANGLE_RETURN(true);
+      frame->copy = *state;
+      if (ParseTwoCharToken(state, "St") && MaybeAppend(state, "std::")) {
+        ROO_DEMANGLE_CALL(kUnqualifiedNameRule);
+        if (result) ROO_DEMANGLE_RETURN(true);
+      }
+      *state = frame->copy;
+      ROO_DEMANGLE_RETURN(false);
+
+    case kUnscopedTemplateNameRule:
+      ROO_DEMANGLE_CALL(kUnscopedNameRule);
+      if (result) ROO_DEMANGLE_RETURN(true);
+      ROO_DEMANGLE_RETURN(ParseSubstitution(state));
+
+    case kNestedNameRule:
+      frame->copy = *state;
+      if (ParseOneCharToken(state, 'N') && EnterNestedName(state) &&
+          Optional(ParseCVQualifiers(state))) {
+        ROO_DEMANGLE_CALL(kPrefixRule);
+        if (result && LeaveNestedName(state, frame->copy.nest_level) &&
+            ParseOneCharToken(state, 'E')) {
+          ROO_DEMANGLE_RETURN(true);
+        }
+      }
+      *state = frame->copy;
+      ROO_DEMANGLE_RETURN(false);
+
+    case kPrefixRule:
+      frame->has_something = false;
+      while (true) {
+        MaybeAppendSeparator(state);
+        if (ParseTemplateParam(state) || ParseSubstitution(state)) {
+          frame->has_something = true;
+          MaybeIncreaseNestLevel(state);
+          continue;
+        }
+        ROO_DEMANGLE_CALL(kUnscopedNameRule);
+        if (result) {
+          frame->has_something = true;
+          MaybeIncreaseNestLevel(state);
+          continue;
+        }
+        MaybeCancelLastSeparator(state);
+        if (frame->has_something) {
+          ROO_DEMANGLE_CALL(kTemplateArgsRule);
+          if (result) ROO_DEMANGLE_TAIL_CALL(kPrefixRule);
+        }
+        break;
+      }
+      ROO_DEMANGLE_RETURN(true);
+
+    case kUnqualifiedNameRule:
+      ROO_DEMANGLE_CALL(kOperatorNameRule);
+      if (result) ROO_DEMANGLE_RETURN(true);
+      ROO_DEMANGLE_RETURN(
+          ParseCtorDtorName(state) ||
+          (ParseSourceName(state) && Optional(ParseAbiTags(state))) ||
+          (ParseLocalSourceName(state) && Optional(ParseAbiTags(state))));
+
+    case kOperatorNameRule:
+      if (!AtLeastNumCharsRemaining(state->mangled_cur, 2)) {
+        ROO_DEMANGLE_RETURN(false);
+      }
+      frame->copy = *state;
+      if (ParseTwoCharToken(state, "cv") && MaybeAppend(state, "operator ") &&
+          EnterNestedName(state)) {
+        ROO_DEMANGLE_CALL(kTypeRule);
+        if (result && LeaveNestedName(state, frame->copy.nest_level)) {
+          ROO_DEMANGLE_RETURN(true);
+        }
+      }
+      *state = frame->copy;
+      ROO_DEMANGLE_RETURN(ParseNonCastOperatorName(state));
+
+    case kSpecialNameRule:
+      frame->copy = *state;
+      if (ParseOneCharToken(state, 'T') && ParseCharClass(state, "VTIS")) {
+        ROO_DEMANGLE_CALL(kTypeRule);
+        if (result) ROO_DEMANGLE_RETURN(true);
+      }
+      *state = frame->copy;
+      if (ParseTwoCharToken(state, "Tc") && ParseCallOffset(state) &&
+          ParseCallOffset(state)) {
+        ROO_DEMANGLE_CALL(kEncodingRule);
+        if (result) ROO_DEMANGLE_RETURN(true);
+      }
+      *state = frame->copy;
+      if (ParseTwoCharToken(state, "GV")) {
+        ROO_DEMANGLE_CALL(kNameRule);
+        if (result) ROO_DEMANGLE_RETURN(true);
+      }
+      *state = frame->copy;
+      if (ParseOneCharToken(state, 'T') && ParseCallOffset(state)) {
+        ROO_DEMANGLE_CALL(kEncodingRule);
+        if (result) ROO_DEMANGLE_RETURN(true);
+      }
+      *state = frame->copy;
+      // G++ extensions
+      if (ParseTwoCharToken(state, "TC")) {
+        ROO_DEMANGLE_CALL(kTypeRule);
+        if (result && ParseNumber(state, nullptr) &&
+            ParseOneCharToken(state, '_') && DisableAppend(state)) {
+          ROO_DEMANGLE_CALL(kTypeRule);
+          if (result) {
+            RestoreAppend(state, frame->copy.append);
+            ROO_DEMANGLE_RETURN(true);
+          }
+        }
+      }
+      *state = frame->copy;
+      if (ParseOneCharToken(state, 'T') && ParseCharClass(state, "FJ")) {
+        ROO_DEMANGLE_CALL(kTypeRule);
+        if (result) ROO_DEMANGLE_RETURN(true);
+      }
+      *state = frame->copy;
+      if (ParseTwoCharToken(state, "GR")) {
+        ROO_DEMANGLE_CALL(kNameRule);
+        if (result) ROO_DEMANGLE_RETURN(true);
+      }
+      *state = frame->copy;
+      if (ParseTwoCharToken(state, "GA")) {
+        ROO_DEMANGLE_CALL(kEncodingRule);
+        if (result) ROO_DEMANGLE_RETURN(true);
+      }
+      *state = frame->copy;
+      if (ParseOneCharToken(state, 'T') && ParseCharClass(state, "hv") &&
+          ParseCallOffset(state)) {
+        ROO_DEMANGLE_CALL(kEncodingRule);
+        if (result) ROO_DEMANGLE_RETURN(true);
+      }
+      *state = frame->copy;
+      ROO_DEMANGLE_RETURN(false);
+
+    case kTypeRule:
+      frame->copy = *state;
+      if (ParseCVQualifiers(state)) {
+        ROO_DEMANGLE_CALL(kTypeRule);
+        if (result) ROO_DEMANGLE_RETURN(true);
+      }
+      *state = frame->copy;
+      if (ParseCharClass(state, "OPRCG")) {
+        ROO_DEMANGLE_CALL(kTypeRule);
+        if (result) ROO_DEMANGLE_RETURN(true);
+      }
+      *state = frame->copy;
+      if (ParseTwoCharToken(state, "Dp")) {
+        ROO_DEMANGLE_CALL(kTypeRule);
+        if (result) ROO_DEMANGLE_RETURN(true);
+      }
+      *state = frame->copy;
+      if (ParseOneCharToken(state, 'D') && ParseCharClass(state, "tT")) {
+        ROO_DEMANGLE_CALL(kExpressionRule);
+        if (result && ParseOneCharToken(state, 'E')) {
+          ROO_DEMANGLE_RETURN(true);
+        }
+      }
+      *state = frame->copy;
+      if (ParseOneCharToken(state, 'U') && ParseSourceName(state)) {
+        ROO_DEMANGLE_CALL(kTypeRule);
+        if (result) ROO_DEMANGLE_RETURN(true);
+      }
+      *state = frame->copy;
+      if (ParseBuiltinType(state)) ROO_DEMANGLE_RETURN(true);
+      ROO_DEMANGLE_CALL(kFunctionTypeRule);
+      if (result) ROO_DEMANGLE_RETURN(true);
+      // <class-enum-type> ::= <name>
+      ROO_DEMANGLE_CALL(kNameRule);
+      if (result) ROO_DEMANGLE_RETURN(true);
+      ROO_DEMANGLE_CALL(kArrayTypeRule);
+      if (result) ROO_DEMANGLE_RETURN(true);
+      ROO_DEMANGLE_CALL(kPointerToMemberTypeRule);
+      if (result) ROO_DEMANGLE_RETURN(true);
+      if (ParseSubstitution(state)) ROO_DEMANGLE_RETURN(true);
+      if (ParseTemplateTemplateParam(state)) {
+        ROO_DEMANGLE_CALL(kTemplateArgsRule);
+        if (result) ROO_DEMANGLE_RETURN(true);
+      }
+      *state = frame->copy;
+      // Less greedy than <template-template-param> <template-args>.
+      ROO_DEMANGLE_RETURN(ParseTemplateParam(state));
+
+    case kFunctionTypeRule:
+      frame->copy = *state;
+      if (ParseOneCharToken(state, 'F') &&
+          Optional(ParseOneCharToken(state, 'Y'))) {
+        ROO_DEMANGLE_CALL(kBareFunctionTypeRule);
+        if (result && ParseOneCharToken(state, 'E')) {
+          ROO_DEMANGLE_RETURN(true);
+        }
+      }
+      *state = frame->copy;
+      ROO_DEMANGLE_RETURN(false);
+
+    case kBareFunctionTypeRule:
+      frame->copy = *state;
+      DisableAppend(state);
+      ROO_DEMANGLE_CALL(kTypeRule);
+      if (result) {
+        do {
+          ROO_DEMANGLE_CALL(kTypeRule);
+        } while (result);
+        RestoreAppend(state, frame->copy.append);
+        MaybeAppend(state, "()");
+        ROO_DEMANGLE_RETURN(true);
+      }
+      *state = frame->copy;
+      ROO_DEMANGLE_RETURN(false);
+
+    case kArrayTypeRule:
+      frame->copy = *state;
+      if (ParseOneCharToken(state, 'A') && ParseNumber(state, nullptr) &&
+          ParseOneCharToken(state, '_')) {
+        ROO_DEMANGLE_CALL(kTypeRule);
+        if (result) ROO_DEMANGLE_RETURN(true);
+      }
+      *state = frame->copy;
+      if (ParseOneCharToken(state, 'A')) {
+        // Optional.
+        ROO_DEMANGLE_CALL(kExpressionRule);
+        if (ParseOneCharToken(state, '_')) {
+          ROO_DEMANGLE_CALL(kTypeRule);
+          if (result) ROO_DEMANGLE_RETURN(true);
+        }
+      }
+      *state = frame->copy;
+      ROO_DEMANGLE_RETURN(false);
+
+    case kPointerToMemberTypeRule:
+      frame->copy = *state;
+      if (ParseOneCharToken(state, 'M')) {
+        ROO_DEMANGLE_CALL(kTypeRule);
+        if (result) {
+          ROO_DEMANGLE_CALL(kTypeRule);
+          if (result) ROO_DEMANGLE_RETURN(true);
+        }
+      }
+      *state = frame->copy;
+      ROO_DEMANGLE_RETURN(false);
+
+    case kTemplateArgsRule:
+      frame->copy = *state;
+      DisableAppend(state);
+      if (ParseOneCharToken(state, 'I')) {
+        ROO_DEMANGLE_CALL(kTemplateArgRule);
+        if (result) {
+          do {
+            ROO_DEMANGLE_CALL(kTemplateArgRule);
+          } while (result);
+          if (ParseOneCharToken(state, 'E')) {
+            RestoreAppend(state, frame->copy.append);
+            MaybeAppend(state, "<>");
+            ROO_DEMANGLE_RETURN(true);
+          }
+        }
+      }
+      *state = frame->copy;
+      ROO_DEMANGLE_RETURN(false);
+
+    case kTemplateArgRule:
+      if (state->arg_level > 6) ROO_DEMANGLE_RETURN(false);
+      ++state->arg_level;
+      frame->copy = *state;
+      if (ParseOneCharToken(state, 'I') || ParseOneCharToken(state, 'J')) {
+        do {
+          ROO_DEMANGLE_CALL(kTemplateArgRule);
+        } while (result);
+        if (ParseOneCharToken(state, 'E')) {
+          --state->arg_level;
+          ROO_DEMANGLE_RETURN(true);
+        }
+      }
+      *state = frame->copy;
+      ROO_DEMANGLE_CALL(kTypeRule);
+      if (!result) {
+        ROO_DEMANGLE_CALL(kExprPrimaryRule);
+      }
+      if (result) {
+        --state->arg_level;
+        ROO_DEMANGLE_RETURN(true);
+      }
+      *state = frame->copy;
+      if (ParseOneCharToken(state, 'X')) {
+        ROO_DEMANGLE_CALL(kExpressionRule);
+        if (result && ParseOneCharToken(state, 'E')) {
+          --state->arg_level;
+          ROO_DEMANGLE_RETURN(true);
+        }
+      }
+      *state = frame->copy;
+      ROO_DEMANGLE_RETURN(false);
+
+    case kExpressionRule:
+      if (ParseTemplateParam(state)) ROO_DEMANGLE_RETURN(true);
+      ROO_DEMANGLE_CALL(kExprPrimaryRule);
+      if (result) ROO_DEMANGLE_RETURN(true);
+      if (state->expr_level > 5) ROO_DEMANGLE_RETURN(false);
+      ++state->expr_level;
+      frame->copy = *state;
+      ROO_DEMANGLE_CALL(kOperatorNameRule);
+      if (result) {
+        ROO_DEMANGLE_CALL(kExpressionRule);
+        if (result) {
+          ROO_DEMANGLE_CALL(kExpressionRule);
+          if (result) {
+            ROO_DEMANGLE_CALL(kExpressionRule);
+            if (result) {
+              --state->expr_level;
+              ROO_DEMANGLE_RETURN(true);
+            }
+          }
+        }
+      }
+      *state = frame->copy;
+      ROO_DEMANGLE_CALL(kOperatorNameRule);
+      if (result) {
+        ROO_DEMANGLE_CALL(kExpressionRule);
+        if (result) {
+          ROO_DEMANGLE_CALL(kExpressionRule);
+          if (result) {
+            --state->expr_level;
+            ROO_DEMANGLE_RETURN(true);
+          }
+        }
+      }
+      *state = frame->copy;
+      ROO_DEMANGLE_CALL(kOperatorNameRule);
+      if (result) {
+        ROO_DEMANGLE_CALL(kExpressionRule);
+        if (result) {
+          --state->expr_level;
+          ROO_DEMANGLE_RETURN(true);
+        }
+      }
+      *state = frame->copy;
+      if (ParseTwoCharToken(state, "st")) {
+        ROO_DEMANGLE_CALL(kTypeRule);
+        // Like ParseExpression(), does not decrement expr_level here.
+        if (result) ROO_DEMANGLE_RETURN(true);
+      }
+      *state = frame->copy;
+      if (ParseTwoCharToken(state, "sr")) {
+        ROO_DEMANGLE_CALL(kTypeRule);
+        if (result) {
+          ROO_DEMANGLE_CALL(kUnqualifiedNameRule);
+          if (result) {
+            ROO_DEMANGLE_CALL(kTemplateArgsRule);
+            if (result) {
+              --state->expr_level;
+              ROO_DEMANGLE_RETURN(true);
+            }
+          }
+        }
+      }
+      *state = frame->copy;
+      if (ParseTwoCharToken(state, "sr")) {
+        ROO_DEMANGLE_CALL(kTypeRule);
+        if (result) {
+          ROO_DEMANGLE_CALL(kUnqualifiedNameRule);
+          if (result) {
+            --state->expr_level;
+            ROO_DEMANGLE_RETURN(true);
+          }
+        }
+      }
+      *state = frame->copy;
+      // Pack expansion
+      if (ParseTwoCharToken(state, "sp")) {
+        ROO_DEMANGLE_CALL(kTypeRule);
+        if (result) {
+          --state->expr_level;
+          ROO_DEMANGLE_RETURN(true);
+        }
+      }
+      *state = frame->copy;
+      ROO_DEMANGLE_RETURN(false);
+
+    case kExprPrimaryRule:
+      frame->copy = *state;
+      if (ParseOneCharToken(state, 'L')) {
+        ROO_DEMANGLE_CALL(kTypeRule);
+        if (result && ParseNumber(state, nullptr) &&
+            ParseOneCharToken(state, 'E')) {
+          ROO_DEMANGLE_RETURN(true);
+        }
+      }
+      *state = frame->copy;
+      if (ParseOneCharToken(state, 'L')) {
+        ROO_DEMANGLE_CALL(kTypeRule);
+        if (result && ParseFloatNumber(state) &&
+            ParseOneCharToken(state, 'E')) {
+          ROO_DEMANGLE_RETURN(true);
+        }
+      }
+      *state = frame->copy;
+      if (ParseOneCharToken(state, 'L')) {
+        ROO_DEMANGLE_CALL(kMangledNameRule);
+        if (result && ParseOneCharToken(state, 'E')) {
+          ROO_DEMANGLE_RETURN(true);
+        }
+      }
+      *state = frame->copy;
+      if (ParseTwoCharToken(state, "LZ")) {
+        ROO_DEMANGLE_CALL(kEncodingRule);
+        if (result && ParseOneCharToken(state, 'E')) {
+          ROO_DEMANGLE_RETURN(true);
+        }
+      }
+      *state = frame->copy;
+      ROO_DEMANGLE_RETURN(false);
+
+    case kLocalNameRule:
+      if (state->local_level > 5) ROO_DEMANGLE_RETURN(false);
+      ++state->local_level;
+      frame->copy = *state;
+      if (ParseOneCharToken(state, 'Z')) {
+        ROO_DEMANGLE_CALL(kEncodingRule);
+        if (result && ParseOneCharToken(state, 'E') &&
+            MaybeAppend(state, "::")) {
+          ROO_DEMANGLE_CALL(kNameRule);
+          if (result) {
+            Optional(ParseDiscriminator(state));
+            --state->local_level;
+            ROO_DEMANGLE_RETURN(true);
+          }
+        }
+      }
+      *state = frame->copy;
+      if (ParseOneCharToken(state, 'Z')) {
+        ROO_DEMANGLE_CALL(kEncodingRule);
+        if (result && ParseTwoCharToken(state, "Es")) {
+          Optional(ParseDiscriminator(state));
+          --state->local_level;
+          ROO_DEMANGLE_RETURN(true);
+        }
+      }
+      *state = frame->copy;
+      ROO_DEMANGLE_RETURN(false);
+  }
+
+unwind:
+  if (frame == stack) return result;
+  --frame;
+  goto dispatch;
+}
+
+#undef ROO_DEMANGLE_RESUME_POINT
+#undef ROO_DEMANGLE_CALL
+#undef ROO_DEMANGLE_TAIL_CALL
+#undef ROO_DEMANGLE_RETURN
 }  // namespace
 #endif
 
@@ -1350,6 +2041,8 @@ bool Demangle(const char* mangled, char* out, size_t out_size) {
 
   std::copy_n(unmangled.get(), std::min(n, out_size), out);
   return status == 0;
+#elif ROO_LOGGING_DEMANGLE_BOUNDED
+  return DemangleBounded(mangled, out, out_size);
 #else
   State state;
   InitState(&state, mangled, out, out_size);
@@ -1357,4 +2050,162 @@ bool Demangle(const char* mangled, char* out, size_t out_size) {
 #endif
 }
 
-}  // namespace roo_logging
\ No newline at end of file
+bool DemangleBounded(const char* mangled, char* out, size_t out_size,
+                     size_t max_depth, uint32_t max_steps) {
+#if defined(GLOG_OS_WINDOWS) || defined(HAVE___CXA_DEMANGLE)
+  (void)max_depth;
+  (void)max_steps;
+  return Demangle(mangled, out, out_size);
+#else
+  Frame stack[ROO_LOGGING_DEMANGLE_MAX_DEPTH];
+  if (max_depth > ROO_LOGGING_DEMANGLE_MAX_DEPTH) {
+    max_depth = ROO_LOGGING_DEMANGLE_MAX_DEPTH;
+  }
+  State state;
+  InitState(&state, mangled, out, out_size);
+  return ParseBounded(&state, stack, stack + max_depth, max_steps) &&
+         !state.overflowed;
+#endif
+}
+
+#if ROO_LOGGING_DEMANGLE_CACHE_SIZE > 0
+
+namespace {
+
+// Longest demangled name that gets cached; matches the buffer used by
+// Symbolize().
+constexpr size_t kMaxCachedLength = 255;
+
+struct CacheEntry {
+  // FNV-1a of the mangled name, and its length. Zero length: empty entry.
+  uint64_t hash;
+  size_t mangled_length;
+  // For choosing the entry to evict.
+  uint32_t last_used;
+  // False if the name could not be demangled into kMaxCachedLength chars.
+  bool ok;
+  uint8_t length;
+  char demangled[kMaxCachedLength + 1];
+};
+
+// Set-associative: each name can go into any of the kCacheWays entries of
+// its set, and evicts the least recently used one.
+constexpr int kCacheWays = ROO_LOGGING_DEMANGLE_CACHE_SIZE < 4
+                               ? ROO_LOGGING_DEMANGLE_CACHE_SIZE
+                               : 4;
+constexpr int kCacheSets = ROO_LOGGING_DEMANGLE_CACHE_SIZE / kCacheWays;
+
+CacheEntry cache[kCacheSets][kCacheWays];
+uint32_t cache_clock = 0;
+
+// Guards the cache and the statistics. A flag rather than a mutex, so that
+// the cache never blocks, and stays async-signal-safe: a thread that finds
+// it taken just skips the cache.
+std::atomic_flag cache_busy = ATOMIC_FLAG_INIT;
+uint64_t cache_hits = 0;
+uint64_t cache_misses = 0;
+
+uint64_t HashName(const char* name, size_t& length) {
+  uint64_t hash = 14695981039346656037ull;
+  const char* p = name;
+  for (; *p != '\0'; ++p) {
+    hash ^= (uint8_t)*p;
+    hash *= 1099511628211ull;
+  }
+  length = p - name;
+  return hash;
+}
+
+}  // namespace
+
+bool DemangleCached(const char* mangled, char* out, size_t out_size) {
+  size_t mangled_length;
+  uint64_t hash = HashName(mangled, mangled_length);
+  CacheEntry* set = cache[hash % kCacheSets];
+  char demangled[kMaxCachedLength + 1];
+  bool found = false;
+  bool ok = false;
+  size_t length = 0;
+  if (!cache_busy.test_and_set(std::memory_order_acquire)) {
+    for (int i = 0; i < kCacheWays; ++i) {
+      CacheEntry& entry = set[i];
+      if (entry.mangled_length == mangled_length && entry.hash == hash) {
+        entry.last_used = ++cache_clock;
+        ok = entry.ok;
+        length = entry.length;
+        memcpy(demangled, entry.demangled, length + 1);
+        found = true;
+        break;
+      }
+    }
+    if (found) {
+      ++cache_hits;
+    } else {
+      ++cache_misses;
+    }
+    cache_busy.clear(std::memory_order_release);
+  }
+  if (!found) {
+    ok = Demangle(mangled, demangled, sizeof(demangled));
+    length = ok ? strlen(demangled) : 0;
+    if (mangled_length > 0 &&
+        !cache_busy.test_and_set(std::memory_order_acquire)) {
+      CacheEntry* victim = &set[0];
+      for (int i = 1; i < kCacheWays; ++i) {
+        // Wraparound-safe comparison.
+        if ((int32_t)(set[i].last_used - victim->last_used) < 0) {
+          victim = &set[i];
+        }
+      }
+      victim->hash = hash;
+      victim->mangled_length = mangled_length;
+      victim->last_used = ++cache_clock;
+      victim->ok = ok;
+      victim->length = (uint8_t)length;
+      memcpy(victim->demangled, demangled, length + 1);
+      cache_busy.clear(std::memory_order_release);
+    }
+  }
+  if (!ok) {
+    // Either not a valid name, or one too long to cache.
+    if (out_size > sizeof(demangled)) return Demangle(mangled, out, out_size);
+    if (out_size > 0) out[0] = '\0';
+    return false;
+  }
+  if (length >= out_size) return false;
+  memcpy(out, demangled, length + 1);
+  return true;
+}
+
+DemangleCacheStats GetDemangleCacheStats() {
+  while (cache_busy.test_and_set(std::memory_order_acquire)) {
+  }
+  DemangleCacheStats stats{cache_hits, cache_misses};
+  cache_busy.clear(std::memory_order_release);
+  return stats;
+}
+
+void ClearDemangleCache() {
+  while (cache_busy.test_and_set(std::memory_order_acquire)) {
+  }
+  for (auto& set : cache) {
+    for (CacheEntry& entry : set) entry.mangled_length = 0;
+  }
+  cache_hits = 0;
+  cache_misses = 0;
+  cache_busy.clear(std::memory_order_release);
+}
+
+#else
+
+bool DemangleCached(const char* mangled, char* out, size_t out_size) {
+  return Demangle(mangled, out, out_size);
+}
+
+DemangleCacheStats GetDemangleCacheStats() { return DemangleCacheStats{0, 0}; }
+
+void ClearDemangleCache() {}
+
+#endif
+
+}  // namespace roo_logging
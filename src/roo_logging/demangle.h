@@ -72,9 +72,38 @@
 #pragma once
 
 #include <cstddef>
+#include <stdint.h>
 
 #include "roo_logging/config.h"
 
+// Number of entries in the cache used by DemangleCached(). Each entry takes
+// about 300 bytes. Zero disables the cache.
+#ifndef ROO_LOGGING_DEMANGLE_CACHE_SIZE
+#if defined(ROO_LOGGING_HAVE_SYMBOLIZE)
+#define ROO_LOGGING_DEMANGLE_CACHE_SIZE 128
+#else
+#define ROO_LOGGING_DEMANGLE_CACHE_SIZE 0
+#endif
+#endif
+
+// Limits of DemangleBounded(): the maximum nesting depth of the parse, which
+// determines its stack use (see the README), and the maximum number of rule
+// invocations, which bounds its running time. Names that exceed either limit
+// are not demangled.
+#ifndef ROO_LOGGING_DEMANGLE_MAX_DEPTH
+#define ROO_LOGGING_DEMANGLE_MAX_DEPTH 48
+#endif
+
+#ifndef ROO_LOGGING_DEMANGLE_MAX_STEPS
+#define ROO_LOGGING_DEMANGLE_MAX_STEPS 20000
+#endif
+
+// If 1, Demangle() uses DemangleBounded(), rather than the recursive parser.
+// Useful on targets with small (e.g., signal handler or task) stacks.
+#ifndef ROO_LOGGING_DEMANGLE_BOUNDED
+#define ROO_LOGGING_DEMANGLE_BOUNDED 0
+#endif
+
 namespace roo_logging {
 
 // Demangle "mangled".  On success, return true and write the
@@ -82,4 +111,31 @@ namespace roo_logging {
 // "out" is modified even if demangling is unsuccessful.
 bool Demangle(const char *mangled, char *out, size_t out_size);
 
+// Same as Demangle(), but parses with an explicit stack of at most
+// "max_depth" frames (capped at ROO_LOGGING_DEMANGLE_MAX_DEPTH), allocated
+// up front, and gives up (returning false) after "max_steps" rule
+// invocations. Its stack use is thus fixed, regardless of the input; the
+// results are the same as Demangle()'s for names within the limits.
+bool DemangleBounded(const char *mangled, char *out, size_t out_size,
+                     size_t max_depth = ROO_LOGGING_DEMANGLE_MAX_DEPTH,
+                     uint32_t max_steps = ROO_LOGGING_DEMANGLE_MAX_STEPS);
+
+// Same as Demangle(), but remembers the results (of up to
+// ROO_LOGGING_DEMANGLE_CACHE_SIZE recent symbols, keyed by the hash of the
+// mangled name), so that symbols that appear in many stack traces are parsed
+// only once. Thread-safe. Does not block: if another thread is using the
+// cache, demangles without it. Prefer Demangle() in signal handlers.
+bool DemangleCached(const char *mangled, char *out, size_t out_size);
+
+struct DemangleCacheStats {
+  uint64_t hits;
+  uint64_t misses;
+};
+
+// Returns the hit and miss counts of DemangleCached().
+DemangleCacheStats GetDemangleCacheStats();
+
+// Empties the cache used by DemangleCached(), and resets its statistics.
+void ClearDemangleCache();
+
 }  // namespace roo_logging
@@ -0,0 +1,457 @@
+#include "roo_logging/dtoa.h"
+
+#include <stdint.h>
+#include <string.h>
+
+// Grisu2, as described in: Florian Loitsch, "Printing Floating-Point Numbers
+// Quickly and Accurately with Integers", PLDI 2010. It always produces a
+// representation that round-trips, and the shortest one in the vast majority
+// of cases. Unlike Ryu or Grisu3 with a bignum fallback, it needs just a
+// small (~1 KB) table, which makes it suitable for microcontrollers.
+
+namespace roo_logging {
+
+namespace {
+
+// A 'do-it-yourself floating point': f * 2^e.
+struct DiyFp {
+  uint64_t f;
+  int e;
+};
+
+DiyFp Sub(DiyFp x, DiyFp y) { return DiyFp{x.f - y.f, x.e}; }
+
+// Returns x * y, rounded, with the upper 64 bits of the 128-bit product.
+DiyFp Mul(DiyFp x, DiyFp y) {
+  uint64_t x_lo = x.f & 0xFFFFFFFFu;
+  uint64_t x_hi = x.f >> 32;
+  uint64_t y_lo = y.f & 0xFFFFFFFFu;
+  uint64_t y_hi = y.f >> 32;
+  uint64_t p0 = x_lo * y_lo;
+  uint64_t p1 = x_lo * y_hi;
+  uint64_t p2 = x_hi * y_lo;
+  uint64_t p3 = x_hi * y_hi;
+  uint64_t q = (p0 >> 32) + (p1 & 0xFFFFFFFFu) + (p2 & 0xFFFFFFFFu);
+  q += uint64_t{1} << 31;  // Round.
+  uint64_t h = p3 + (p2 >> 32) + (p1 >> 32) + (q >> 32);
+  return DiyFp{h, x.e + y.e + 64};
+}
+
+DiyFp Normalize(DiyFp x) {
+  while ((x.f >> 63) == 0) {
+    x.f <<= 1;
+    --x.e;
+  }
+  return x;
+}
+
+DiyFp NormalizeTo(DiyFp x, int target_exponent) {
+  return DiyFp{x.f << (x.e - target_exponent), target_exponent};
+}
+
+// The value, and the normalized boundaries of its rounding interval.
+struct Boundaries {
+  DiyFp w;
+  DiyFp minus;
+  DiyFp plus;
+};
+
+// Computes the boundaries for an IEEE value with the given number of
+// significand bits (including the hidden bit), and the exponent bias.
+Boundaries ComputeBoundaries(uint64_t bits, int precision, int bias) {
+  const uint64_t hidden_bit = uint64_t{1} << (precision - 1);
+  const int min_exp = 1 - bias;
+  uint64_t exp_bits = bits >> (precision - 1);
+  uint64_t fraction = bits & (hidden_bit - 1);
+  DiyFp v = (exp_bits == 0)
+                ? DiyFp{fraction, min_exp}
+                : DiyFp{fraction + hidden_bit, (int)exp_bits - bias};
+  // The lower boundary is closer if the significand is a power of two (and
+  // the value is normalized, with a smaller exponent below it).
+  bool lower_boundary_is_closer = (fraction == 0 && exp_bits > 1);
+  DiyFp m_plus = DiyFp{2 * v.f + 1, v.e - 1};
+  DiyFp m_minus = lower_boundary_is_closer ? DiyFp{4 * v.f - 1, v.e - 2}
+                                           : DiyFp{2 * v.f - 1, v.e - 1};
+  Boundaries result;
+  result.plus = Normalize(m_plus);
+  result.minus = NormalizeTo(m_minus, result.plus.e);
+  result.w = Normalize(v);
+  return result;
+}
+
+// The exponent range in which the digit generation operates.
+constexpr int kAlpha = -60;
+constexpr int kGamma = -32;
+
+struct CachedPower {
+  uint64_t f;
+  int e;
+  int k;
+};
+
+// Normalized approximations of 10^k, for k = -300, -292, ..., 324.
+constexpr int kCachedPowersMinDecExp = -300;
+constexpr int kCachedPowersDecStep = 8;
+
+const CachedPower kCachedPowers[] = {
+    {0xAB70FE17C79AC6CA, -1060, -300},
+    {0xFF77B1FCBEBCDC4F, -1034, -292},
+    {0xBE5691EF416BD60C, -1007, -284},
+    {0x8DD01FAD907FFC3C, -980, -276},
+    {0xD3515C2831559A83, -954, -268},
+    {0x9D71AC8FADA6C9B5, -927, -260},
+    {0xEA9C227723EE8BCB, -901, -252},
+    {0xAECC49914078536D, -874, -244},
+    {0x823C12795DB6CE57, -847, -236},
+    {0xC21094364DFB5637, -821, -228},
+    {0x9096EA6F3848984F, -794, -220},
+    {0xD77485CB25823AC7, -768, -212},
+    {0xA086CFCD97BF97F4, -741, -204},
+    {0xEF340A98172AACE5, -715, -196},
+    {0xB23867FB2A35B28E, -688, -188},
+    {0x84C8D4DFD2C63F3B, -661, -180},
+    {0xC5DD44271AD3CDBA, -635, -172},
+    {0x936B9FCEBB25C996, -608, -164},
+    {0xDBAC6C247D62A584, -582, -156},
+    {0xA3AB66580D5FDAF6, -555, -148},
+    {0xF3E2F893DEC3F126, -529, -140},
+    {0xB5B5ADA8AAFF80B8, -502, -132},
+    {0x87625F056C7C4A8B, -475, -124},
+    {0xC9BCFF6034C13053, -449, -116},
+    {0x964E858C91BA2655, -422, -108},
+    {0xDFF9772470297EBD, -396, -100},
+    {0xA6DFBD9FB8E5B88F, -369, -92},
+    {0xF8A95FCF88747D94, -343, -84},
+    {0xB94470938FA89BCF, -316, -76},
+    {0x8A08F0F8BF0F156B, -289, -68},
+    {0xCDB02555653131B6, -263, -60},
+    {0x993FE2C6D07B7FAC, -236, -52},
+    {0xE45C10C42A2B3B06, -210, -44},
+    {0xAA242499697392D3, -183, -36},
+    {0xFD87B5F28300CA0E, -157, -28},
+    {0xBCE5086492111AEB, -130, -20},
+    {0x8CBCCC096F5088CC, -103, -12},
+    {0xD1B71758E219652C, -77, -4},
+    {0x9C40000000000000, -50, 4},
+    {0xE8D4A51000000000, -24, 12},
+    {0xAD78EBC5AC620000, 3, 20},
+    {0x813F3978F8940984, 30, 28},
+    {0xC097CE7BC90715B3, 56, 36},
+    {0x8F7E32CE7BEA5C70, 83, 44},
+    {0xD5D238A4ABE98068, 109, 52},
+    {0x9F4F2726179A2245, 136, 60},
+    {0xED63A231D4C4FB27, 162, 68},
+    {0xB0DE65388CC8ADA8, 189, 76},
+    {0x83C7088E1AAB65DB, 216, 84},
+    {0xC45D1DF942711D9A, 242, 92},
+    {0x924D692CA61BE758, 269, 100},
+    {0xDA01EE641A708DEA, 295, 108},
+    {0xA26DA3999AEF774A, 322, 116},
+    {0xF209787BB47D6B85, 348, 124},
+    {0xB454E4A179DD1877, 375, 132},
+    {0x865B86925B9BC5C2, 402, 140},
+    {0xC83553C5C8965D3D, 428, 148},
+    {0x952AB45CFA97A0B3, 455, 156},
+    {0xDE469FBD99A05FE3, 481, 164},
+    {0xA59BC234DB398C25, 508, 172},
+    {0xF6C69A72A3989F5C, 534, 180},
+    {0xB7DCBF5354E9BECE, 561, 188},
+    {0x88FCF317F22241E2, 588, 196},
+    {0xCC20CE9BD35C78A5, 614, 204},
+    {0x98165AF37B2153DF, 641, 212},
+    {0xE2A0B5DC971F303A, 667, 220},
+    {0xA8D9D1535CE3B396, 694, 228},
+    {0xFB9B7CD9A4A7443C, 720, 236},
+    {0xBB764C4CA7A44410, 747, 244},
+    {0x8BAB8EEFB6409C1A, 774, 252},
+    {0xD01FEF10A657842C, 800, 260},
+    {0x9B10A4E5E9913129, 827, 268},
+    {0xE7109BFBA19C0C9D, 853, 276},
+    {0xAC2820D9623BF429, 880, 284},
+    {0x80444B5E7AA7CF85, 907, 292},
+    {0xBF21E44003ACDD2D, 933, 300},
+    {0x8E679C2F5E44FF8F, 960, 308},
+    {0xD433179D9C8CB841, 986, 316},
+    {0x9E19DB92B4E31BA9, 1013, 324},
+};
+
+// Returns a cached power c = 10^k such that alpha <= e + c.e + 64 <= gamma.
+const CachedPower& GetCachedPowerForBinaryExponent(int e) {
+  // k = ceil((alpha - e - 1) * log10(2)), using 78913 / 2^18 ~ log10(2).
+  const int f = kAlpha - e - 1;
+  const int k = (f * 78913) / (1 << 18) + (f > 0);
+  const int index = (-kCachedPowersMinDecExp + k + (kCachedPowersDecStep - 1)) /
+                    kCachedPowersDecStep;
+  return kCachedPowers[index];
+}
+
+// Returns the number of decimal digits of n (n < 10^10), and sets pow10 to
+// 10^(digits - 1).
+int FindLargestPow10(uint32_t n, uint32_t& pow10) {
+  if (n >= 1000000000) {
+    pow10 = 1000000000;
+    return 10;
+  }
+  int digits = 1;
+  pow10 = 1;
+  while (n >= pow10 * 10) {
+    pow10 *= 10;
+    ++digits;
+  }
+  return digits;
+}
+
+void Grisu2Round(char* buf, int len, uint64_t dist, uint64_t delta,
+                 uint64_t rest, uint64_t ten_k) {
+  // Moves the last digit down as long as the result stays within the
+  // rounding interval, and gets closer to the exact value.
+  while (rest < dist && delta - rest >= ten_k &&
+         (rest + ten_k < dist || dist - rest > rest + ten_k - dist)) {
+    --buf[len - 1];
+    rest += ten_k;
+  }
+}
+
+// Generates the digits of w, which lies within [m_minus, m_plus]; the result
+// is buf[0, len) * 10^decimal_exponent.
+void Grisu2DigitGen(char* buf, int& len, int& decimal_exponent, DiyFp m_minus,
+                    DiyFp w, DiyFp m_plus) {
+  uint64_t delta = Sub(m_plus, m_minus).f;
+  uint64_t dist = Sub(m_plus, w).f;
+
+  // Split m_plus into the integral part p1 and the fractional part p2.
+  const DiyFp one{uint64_t{1} << -m_plus.e, m_plus.e};
+  uint32_t p1 = (uint32_t)(m_plus.f >> -one.e);
+  uint64_t p2 = m_plus.f & (one.f - 1);
+
+  uint32_t pow10;
+  int n = FindLargestPow10(p1, pow10);
+  while (n > 0) {
+    uint32_t d = p1 / pow10;
+    p1 %= pow10;
+    buf[len++] = (char)('0' + d);
+    --n;
+    uint64_t rest = ((uint64_t)p1 << -one.e) + p2;
+    if (rest <= delta) {
+      decimal_exponent += n;
+      Grisu2Round(buf, len, dist, delta, rest, (uint64_t)pow10 << -one.e);
+      return;
+    }
+    pow10 /= 10;
+  }
+
+  int m = 0;
+  for (;;) {
+    p2 *= 10;
+    uint64_t d = p2 >> -one.e;
+    p2 &= one.f - 1;
+    buf[len++] = (char)('0' + d);
+    ++m;
+    delta *= 10;
+    dist *= 10;
+    if (p2 <= delta) break;
+  }
+  decimal_exponent -= m;
+  Grisu2Round(buf, len, dist, delta, p2, one.f);
+}
+
+// Writes the shortest digits of the (positive, finite, non-zero) value to
+// buf, and returns their count. The value is buf * 10^decimal_exponent.
+int Grisu2(const Boundaries& b, char* buf, int& decimal_exponent) {
+  const CachedPower& cached = GetCachedPowerForBinaryExponent(b.plus.e);
+  const DiyFp c_minus_k{cached.f, cached.e};
+  const DiyFp w = Mul(b.w, c_minus_k);
+  const DiyFp w_minus = Mul(b.minus, c_minus_k);
+  const DiyFp w_plus = Mul(b.plus, c_minus_k);
+  // Account for the imprecision of the multiplication, by narrowing the
+  // interval by 1 ulp on both sides.
+  const DiyFp m_minus{w_minus.f + 1, w_minus.e};
+  const DiyFp m_plus{w_plus.f - 1, w_plus.e};
+  decimal_exponent = -cached.k;
+  int len = 0;
+  Grisu2DigitGen(buf, len, decimal_exponent, m_minus, w, m_plus);
+  return len;
+}
+
+char* WriteExponent(int e, char* out) {
+  if (e < 0) {
+    *out++ = '-';
+    e = -e;
+  } else {
+    *out++ = '+';
+  }
+  if (e >= 100) {
+    *out++ = (char)('0' + e / 100);
+    e %= 100;
+  }
+  *out++ = (char)('0' + e / 10);
+  *out++ = (char)('0' + e % 10);
+  return out;
+}
+
+// Lays out digits[0, len) * 10^decimal_exponent, like printf's "%g".
+char* FormatDigits(const char* digits, int len, int decimal_exponent,
+                   char* out) {
+  // Position of the decimal point, relative to the first digit.
+  const int point = len + decimal_exponent;
+  if (len <= point && point <= 17) {
+    // Integer: dddd000.
+    memcpy(out, digits, len);
+    out += len;
+    for (int i = len; i < point; ++i) *out++ = '0';
+  } else if (0 < point && point <= 17) {
+    // ddd.ddd
+    memcpy(out, digits, point);
+    out += point;
+    *out++ = '.';
+    memcpy(out, digits + point, len - point);
+    out += len - point;
+  } else if (-4 < point && point <= 0) {
+    // 0.000ddd
+    *out++ = '0';
+    *out++ = '.';
+    for (int i = point; i < 0; ++i) *out++ = '0';
+    memcpy(out, digits, len);
+    out += len;
+  } else {
+    // d.ddde+XX
+    *out++ = digits[0];
+    if (len > 1) {
+      *out++ = '.';
+      memcpy(out, digits + 1, len - 1);
+      out += len - 1;
+    }
+    *out++ = 'e';
+    out = WriteExponent(point - 1, out);
+  }
+  return out;
+}
+
+// Handles sign and special values. Returns nullptr if the magnitude is
+// finite and non-zero, and needs to be formatted.
+char* FormatSpecial(bool negative, bool is_nan, bool is_inf, bool is_zero,
+                    char*& out) {
+  if (is_nan) {
+    memcpy(out, "nan", 3);
+    return out + 3;
+  }
+  if (negative) *out++ = '-';
+  if (is_inf) {
+    memcpy(out, "inf", 3);
+    return out + 3;
+  }
+  if (is_zero) {
+    *out = '0';
+    return out + 1;
+  }
+  return nullptr;
+}
+
+// Extracts the shortest digits of a double. Returns false for special
+// values, which are then written to out directly.
+bool DoubleDigits(double value, char* digits, int& len, int& decimal_exponent,
+                  char*& out, char*& end) {
+  uint64_t bits;
+  memcpy(&bits, &value, sizeof(bits));
+  uint64_t exp_bits = (bits >> 52) & 0x7FF;
+  uint64_t fraction = bits & ((uint64_t{1} << 52) - 1);
+  end = FormatSpecial((bits >> 63) != 0, exp_bits == 0x7FF && fraction != 0,
+                      exp_bits == 0x7FF && fraction == 0,
+                      exp_bits == 0 && fraction == 0, out);
+  if (end != nullptr) return false;
+  len = Grisu2(ComputeBoundaries(bits & ~(uint64_t{1} << 63), 53, 1075),
+               digits, decimal_exponent);
+  return true;
+}
+
+}  // namespace
+
+size_t FormatDouble(double value, char* buf) {
+  char digits[20];
+  int len;
+  int decimal_exponent;
+  char* out = buf;
+  char* end;
+  if (DoubleDigits(value, digits, len, decimal_exponent, out, end)) {
+    end = FormatDigits(digits, len, decimal_exponent, out);
+  }
+  return end - buf;
+}
+
+size_t FormatFloat(float value, char* buf) {
+  uint32_t bits;
+  memcpy(&bits, &value, sizeof(bits));
+  uint32_t exp_bits = (bits >> 23) & 0xFF;
+  uint32_t fraction = bits & ((1u << 23) - 1);
+  char* out = buf;
+  char* end =
+      FormatSpecial((bits >> 31) != 0, exp_bits == 0xFF && fraction != 0,
+                    exp_bits == 0xFF && fraction == 0,
+                    exp_bits == 0 && fraction == 0, out);
+  if (end != nullptr) return end - buf;
+  char digits[20];
+  int decimal_exponent;
+  int len = Grisu2(ComputeBoundaries(bits & ~(1u << 31), 24, 150), digits,
+                   decimal_exponent);
+  return FormatDigits(digits, len, decimal_exponent, out) - buf;
+}
+
+size_t FormatFixed(double value, int decimals, char* buf) {
+  if (decimals < 0) decimals = 0;
+  if (decimals > kMaxFixedDecimals) decimals = kMaxFixedDecimals;
+  // One extra leading position, for the carry from rounding.
+  char digits[21];
+  int len;
+  int decimal_exponent;
+  char* out = buf;
+  char* end;
+  if (!DoubleDigits(value, digits + 1, len, decimal_exponent, out, end)) {
+    if (end > out && *out == '0' && decimals > 0) {
+      // Zero.
+      *end++ = '.';
+      for (int i = 0; i < decimals; ++i) *end++ = '0';
+    }
+    return end - buf;
+  }
+  int point = len + decimal_exponent;
+  if (point > 21) {
+    return FormatDigits(digits + 1, len, decimal_exponent, out) - buf;
+  }
+  // Number of significant digits to keep.
+  int keep = point + decimals;
+  char* d = digits + 1;
+  if (keep < 0) {
+    // Rounds to zero.
+    len = 0;
+  } else if (keep < len) {
+    bool round_up = (d[keep] >= '5');
+    len = keep;
+    if (round_up) {
+      int i = len - 1;
+      while (i >= 0 && d[i] == '9') d[i--] = '0';
+      if (i >= 0) {
+        ++d[i];
+      } else {
+        // Carry out of the first digit, e.g. 9.96 -> 10.0.
+        *--d = '1';
+        ++len;
+        ++point;
+      }
+    }
+  }
+  // Integral part.
+  if (point <= 0) {
+    *out++ = '0';
+  } else {
+    for (int i = 0; i < point; ++i) *out++ = (i < len) ? d[i] : '0';
+  }
+  if (decimals > 0) {
+    *out++ = '.';
+    for (int i = point; i < point + decimals; ++i) {
+      *out++ = (i >= 0 && i < len) ? d[i] : '0';
+    }
+  }
+  return out - buf;
+}
+
+}  // namespace roo_logging
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <stddef.h>
+
+namespace roo_logging {
+
+/// Buffer size sufficient for any output of FormatDouble, FormatFloat, and
+/// (with decimals <= kMaxFixedDecimals) FormatFixed.
+static constexpr size_t kMaxFloatChars = 64;
+
+/// Maximum number of decimals supported by FormatFixed.
+static constexpr int kMaxFixedDecimals = 20;
+
+/// Writes the shortest decimal representation of the value that parses back
+/// (e.g. with strtod) to exactly the same value, using the Grisu2 algorithm.
+/// Does not use printf, and only uses integer arithmetic.
+///
+/// The layout resembles printf's "%g": plain decimal notation for moderate
+/// exponents (e.g. "21.5", "0.001", "1234567"), and scientific notation
+/// otherwise (e.g. "1e+20", "1.5e-07"). Special values are written as "nan",
+/// "inf", and "-inf". Returns the number of characters written (no
+/// terminating '\0'). The buffer must hold at least kMaxFloatChars.
+size_t FormatDouble(double value, char* buf);
+
+/// Like FormatDouble, but produces the shortest representation that parses
+/// back to the same float (e.g. "0.1" for 0.1f, rather than
+/// "0.10000000149011612").
+size_t FormatFloat(float value, char* buf);
+
+/// Writes the value in fixed-point notation, with the specified number of
+/// decimals (clamped to [0, kMaxFixedDecimals]), e.g. "21.50". The value is
+/// rounded (half-up) from its shortest representation. Values with magnitude
+/// of 1e21 and above are written as by FormatDouble.
+size_t FormatFixed(double value, int decimals, char* buf);
+
+}  // namespace roo_logging
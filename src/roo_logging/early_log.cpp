@@ -0,0 +1,107 @@
+#include "roo_logging/early_log.h"
+
+#include <stdint.h>
+#include <string.h>
+
+#include "roo_logging/config.h"
+#include "roo_logging/fields.h"
+#include "roo_logging/sink.h"
+
+namespace roo_logging {
+
+namespace {
+
+// Each message is stored as an EarlyRecord, immediately followed by the
+// message text. Records are copied in and out with memcpy, so the buffer
+// needs no alignment.
+struct EarlyRecord {
+  uint64_t sequence;
+  const char* full_filename;
+  const char* base_filename;
+  roo_time::Uptime uptime;
+  roo_time::WallTime walltime;
+  int line;
+  uint16_t message_len;
+  uint8_t severity;
+};
+
+// Statically zero-initialized, so that it's usable during static
+// initialization, regardless of the initialization order.
+struct EarlyBuffer {
+  bool closed;
+  size_t used;
+  uint32_t dropped;
+#if ROO_LOGGING_EARLY_BUFFER_SIZE > 0
+  char data[ROO_LOGGING_EARLY_BUFFER_SIZE];
+#endif
+};
+
+EarlyBuffer early;
+
+}  // namespace
+
+bool CaptureEarlyMessage(uint64_t sequence, LogSeverity severity,
+                         const char* full_filename, const char* base_filename,
+                         int line, roo_time::Uptime uptime,
+                         roo_time::WallTime walltime,
+                         const char* message, size_t message_len) {
+#if ROO_LOGGING_EARLY_BUFFER_SIZE > 0
+  if (early.closed) return false;
+  if (message_len <= 0xFFFF &&
+      sizeof(EarlyRecord) + message_len <=
+          ROO_LOGGING_EARLY_BUFFER_SIZE - early.used) {
+    EarlyRecord record;
+    record.sequence = sequence;
+    record.full_filename = full_filename;
+    record.base_filename = base_filename;
+    record.uptime = uptime;
+    record.walltime = walltime;
+    record.line = line;
+    record.message_len = (uint16_t)message_len;
+    record.severity = (uint8_t)severity;
+    memcpy(early.data + early.used, &record, sizeof(record));
+    memcpy(early.data + early.used + sizeof(record), message, message_len);
+    early.used += sizeof(record) + message_len;
+    return true;
+  }
+  ++early.dropped;
+  return true;
+#else
+  // Disabled; as if the buffer was closed from the start.
+  return false;
+#endif
+}
+
+void ReplayEarlyMessages(LogSink* sink) {
+  if (early.closed) return;
+  early.closed = true;
+#if ROO_LOGGING_EARLY_BUFFER_SIZE > 0
+  size_t pos = 0;
+  while (pos < early.used) {
+    EarlyRecord record;
+    memcpy(&record, early.data + pos, sizeof(record));
+    pos += sizeof(record);
+    sink->sendRecord(LogRecord{record.sequence, (LogSeverity)record.severity,
+                               record.full_filename, record.base_filename,
+                               record.line, record.uptime, record.walltime,
+                               early.data + pos, record.message_len,
+                               LogFields()});
+    pos += record.message_len;
+  }
+  early.used = 0;
+#endif
+  if (early.dropped > 0) {
+    char buf[80];
+    Stream s(buf, sizeof(buf));
+    s << "Dropped " << (unsigned long)early.dropped
+      << " early messages (buffer full)";
+    roo_time::Uptime now = roo_time::Uptime::Now();
+    sink->sendRecord(LogRecord{0, ROO_LOGGING_WARNING, __FILE__,
+                               "early_log.cpp", __LINE__, now,
+                               roo_time::WallTime(), buf, (size_t)s.pcount(),
+                               LogFields()});
+    early.dropped = 0;
+  }
+}
+
+}  // namespace roo_logging
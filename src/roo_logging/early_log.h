@@ -0,0 +1,37 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "roo_logging/log_severity.h"
+#include "roo_time.h"
+
+namespace roo_logging {
+
+class LogSink;
+
+/// Early-boot buffer. If enabled with ROO_LOGGING_EARLY_BUFFER_SIZE (it is off
+/// by default), messages that would go to the sink before the first sink is
+/// registered are captured in a fixed-size static buffer of that many bytes,
+/// and replayed to the first sink when it gets registered, in order, with
+/// their original timestamps. This way, sinks also get messages logged during
+/// static initialization, or early in setup(). The buffer never allocates,
+/// since it may be used before the heap is usable. Messages that don't fit are
+/// dropped and counted; the sink gets a summary warning after the replay.
+///
+/// Both functions must be called under the log mutex.
+
+/// Captures the message, if the early-boot buffer is enabled and still open
+/// (i.e. no sink has been registered yet). Returns false otherwise.
+/// Structured fields are captured in their text rendering only.
+bool CaptureEarlyMessage(uint64_t sequence, LogSeverity severity,
+                         const char* full_filename, const char* base_filename,
+                         int line, roo_time::Uptime uptime,
+                         roo_time::WallTime walltime,
+                         const char* message, size_t message_len);
+
+/// If the early-boot buffer is still open, replays its contents to the sink,
+/// and closes it.
+void ReplayEarlyMessages(LogSink* sink);
+
+}  // namespace roo_logging
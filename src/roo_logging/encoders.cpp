@@ -0,0 +1,150 @@
+#include "roo_logging/encoders.h"
+
+#include <math.h>
+
+#include "roo_logging/dtoa.h"
+
+namespace roo_logging {
+
+namespace {
+
+const char kHexDigits[] = "0123456789abcdef";
+
+bool NeedsLogfmtQuoting(roo::string_view str) {
+  if (str.size() == 0) return true;
+  for (size_t i = 0; i < str.size(); ++i) {
+    char c = str.data()[i];
+    if (c <= ' ' || c == '=' || c == '"' || c == '\\' || c == 0x7F) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// Writes the string, quoted, with JSON escapes (which are also accepted by
+// logfmt parsers).
+void WriteQuoted(Stream& s, roo::string_view str) {
+  s.write('"');
+  for (size_t i = 0; i < str.size(); ++i) {
+    char c = str.data()[i];
+    switch (c) {
+      case '"':
+        s.write("\\\"", 2);
+        break;
+      case '\\':
+        s.write("\\\\", 2);
+        break;
+      case '\n':
+        s.write("\\n", 2);
+        break;
+      case '\r':
+        s.write("\\r", 2);
+        break;
+      case '\t':
+        s.write("\\t", 2);
+        break;
+      default:
+        if ((uint8_t)c < 0x20) {
+          char esc[6] = {'\\', 'u', '0', '0', kHexDigits[(c >> 4) & 0xF],
+                         kHexDigits[c & 0xF]};
+          s.write(esc, 6);
+        } else {
+          s.write(c);
+        }
+    }
+  }
+  s.write('"');
+}
+
+// Writes a non-string value, in base 10 regardless of the stream's setting.
+void WriteScalar(Stream& s, const LogField& field, bool json) {
+  int base = s.number_base();
+  s.setBase(10);
+  switch (field.type) {
+    case LOG_FIELD_BOOL: {
+      s << (field.bool_value ? "true" : "false");
+      break;
+    }
+    case LOG_FIELD_INT: {
+      s << (long long)field.int_value;
+      break;
+    }
+    case LOG_FIELD_UINT: {
+      s << (unsigned long long)field.uint_value;
+      break;
+    }
+    case LOG_FIELD_DOUBLE: {
+      if (json && !isfinite(field.double_value)) {
+        s << "null";
+      } else {
+        // Always the shortest round-trip form, regardless of the stream's
+        // precision setting.
+        char buf[kMaxFloatChars];
+        s.write(buf, FormatDouble(field.double_value, buf));
+      }
+      break;
+    }
+    default: {
+      break;
+    }
+  }
+  s.setBase(base);
+}
+
+void WriteLogfmtValue(Stream& s, const LogField& field) {
+  if (field.type != LOG_FIELD_STRING) {
+    WriteScalar(s, field, false);
+  } else if (NeedsLogfmtQuoting(field.string_value)) {
+    WriteQuoted(s, field.string_value);
+  } else {
+    s << field.string_value;
+  }
+}
+
+}  // namespace
+
+void WriteFieldsLogfmt(Stream& s, const LogFields& fields) {
+  bool first = true;
+  for (const LogField& field : fields) {
+    if (!first) s.write(' ');
+    first = false;
+    // Keys are quoted like values, if needed, so that a key with a space or
+    // a '=' can't break the line into bogus pairs.
+    if (NeedsLogfmtQuoting(field.key)) {
+      WriteQuoted(s, field.key);
+    } else {
+      s << field.key;
+    }
+    s.write('=');
+    WriteLogfmtValue(s, field);
+  }
+}
+
+void EncodeLogfmt(Stream& s, const char* message, size_t message_len,
+                  const LogFields& fields) {
+  s << "msg=";
+  WriteQuoted(s, roo::string_view(message, message_len));
+  if (!fields.empty()) {
+    s.write(' ');
+    WriteFieldsLogfmt(s, fields);
+  }
+}
+
+void EncodeJson(Stream& s, const char* message, size_t message_len,
+                const LogFields& fields) {
+  s << "{\"msg\":";
+  WriteQuoted(s, roo::string_view(message, message_len));
+  for (const LogField& field : fields) {
+    s.write(',');
+    WriteQuoted(s, field.key);
+    s.write(':');
+    if (field.type == LOG_FIELD_STRING) {
+      WriteQuoted(s, field.string_value);
+    } else {
+      WriteScalar(s, field, true);
+    }
+  }
+  s.write('}');
+}
+
+}  // namespace roo_logging
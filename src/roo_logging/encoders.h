@@ -0,0 +1,31 @@
+#pragma once
+
+#include <stddef.h>
+
+#include "roo_logging/fields.h"
+#include "roo_logging/stream.h"
+
+namespace roo_logging {
+
+/// Encoders for structured log messages (see Stream::kv()), for use by sinks.
+/// They write to any Stream, e.g. an OStringStream, or a Stream wrapping the
+/// sink's own buffer.
+
+/// Writes the fields as space-separated logfmt pairs, e.g.
+/// 'temp=21.5 id=7 name="living room"'. Keys and string values that are
+/// empty, or contain spaces, '=', quotes or control characters, are quoted.
+/// This is also the default rendering of the fields in the log text.
+void WriteFieldsLogfmt(Stream& s, const LogFields& fields);
+
+/// Writes a logfmt line with the message and the fields, e.g.
+/// 'msg="Reading" temp=21.5 id=7'.
+void EncodeLogfmt(Stream& s, const char* message, size_t message_len,
+                  const LogFields& fields);
+
+/// Writes a JSON object with the message and the fields, e.g.
+/// '{"msg":"Reading","temp":21.5,"id":7}'. Non-finite numbers are written as
+/// null.
+void EncodeJson(Stream& s, const char* message, size_t message_len,
+                const LogFields& fields);
+
+}  // namespace roo_logging
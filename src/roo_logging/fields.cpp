@@ -0,0 +1,45 @@
+#include "roo_logging/fields.h"
+
+namespace roo_logging {
+
+void LogFields::const_iterator::advance(const char* end) {
+  if (end <= begin_) {
+    done_ = true;
+    next_end_ = begin_;
+    return;
+  }
+  done_ = false;
+  size_t size = (uint8_t)end[-2] | ((size_t)(uint8_t)end[-1] << 8);
+  const char* p = end - size;
+  next_end_ = p;
+  field_.type = (LogFieldType)*p++;
+  size_t key_len = (uint8_t)*p++;
+  field_.key = roo::string_view(p, key_len);
+  p += key_len;
+  field_.string_value = roo::string_view();
+  switch (field_.type) {
+    case LOG_FIELD_BOOL: {
+      field_.bool_value = (*p != 0);
+      break;
+    }
+    case LOG_FIELD_INT: {
+      memcpy(&field_.int_value, p, sizeof(int64_t));
+      break;
+    }
+    case LOG_FIELD_UINT: {
+      memcpy(&field_.uint_value, p, sizeof(uint64_t));
+      break;
+    }
+    case LOG_FIELD_DOUBLE: {
+      memcpy(&field_.double_value, p, sizeof(double));
+      break;
+    }
+    case LOG_FIELD_STRING: {
+      size_t len = (uint8_t)p[0] | ((size_t)(uint8_t)p[1] << 8);
+      field_.string_value = roo::string_view(p + 2, len);
+      break;
+    }
+  }
+}
+
+}  // namespace roo_logging
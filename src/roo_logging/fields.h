@@ -0,0 +1,100 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "roo_backport.h"
+#include "roo_backport/string_view.h"
+
+namespace roo_logging {
+
+/// Type of a structured field, recorded with Stream::kv().
+enum LogFieldType : uint8_t {
+  LOG_FIELD_BOOL = 0,
+  LOG_FIELD_INT = 1,     // int64_t
+  LOG_FIELD_UINT = 2,    // uint64_t
+  LOG_FIELD_DOUBLE = 3,  // double
+  LOG_FIELD_STRING = 4,
+};
+
+/// A single structured key/value field. The key and the string value point
+/// directly into the message buffer, and are only valid for the duration of
+/// the LogSink call.
+struct LogField {
+  LogFieldType type;
+  roo::string_view key;
+  union {
+    bool bool_value;
+    int64_t int_value;
+    uint64_t uint_value;
+    double double_value;
+  };
+  roo::string_view string_value;
+};
+
+/// Zero-copy view of the structured fields of a log message, in the order in
+/// which they were recorded.
+///
+/// Fields are stored in the tail of the message buffer, growing downwards.
+/// Each record is laid out as: type (1 byte), key length (1 byte), key,
+/// value, record size (2 bytes, little-endian). The value is 1 byte for bool,
+/// 8 bytes for numbers, and a 2-byte length followed by the characters for
+/// strings.
+class LogFields {
+ public:
+  class const_iterator {
+   public:
+    const_iterator(const char* begin, const char* end) : begin_(begin) {
+      advance(end);
+    }
+
+    const LogField& operator*() const { return field_; }
+    const LogField* operator->() const { return &field_; }
+
+    const_iterator& operator++() {
+      advance(next_end_);
+      return *this;
+    }
+
+    bool operator==(const const_iterator& other) const {
+      return next_end_ == other.next_end_ && done_ == other.done_;
+    }
+    bool operator!=(const const_iterator& other) const {
+      return !(*this == other);
+    }
+
+   private:
+    void advance(const char* end);
+
+    const char* begin_;
+    const char* next_end_;
+    bool done_;
+    LogField field_;
+  };
+
+  LogFields() : begin_(nullptr), end_(nullptr), text_(nullptr), text_size_(0) {}
+
+  LogFields(const char* begin, const char* end, const char* text,
+            size_t text_size)
+      : begin_(begin), end_(end), text_(text), text_size_(text_size) {}
+
+  bool empty() const { return begin_ == end_; }
+
+  const_iterator begin() const { return const_iterator(begin_, end_); }
+  const_iterator end() const { return const_iterator(begin_, begin_); }
+
+  /// The default text rendering of the fields (e.g. " temp=21.5 id=7"), as
+  /// written to stderr. In messages passed to LogSink, it immediately follows
+  /// the message text.
+  const char* text() const { return text_; }
+  size_t text_size() const { return text_size_; }
+
+ private:
+  const char* begin_;
+  const char* end_;
+  const char* text_;
+  size_t text_size_;
+};
+
+}  // namespace roo_logging
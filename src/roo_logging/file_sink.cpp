@@ -0,0 +1,174 @@
+#if defined(__linux__)
+
+#include "roo_logging/file_sink.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "roo_logging/log_line.h"
+
+namespace roo_logging {
+
+namespace {
+
+using log_index::IndexEntry;
+using log_index::IndexHeader;
+
+// Opens the index of the segment with the specified inode, for appending. A
+// matching index (e.g. from before a restart) is kept; anything else is
+// replaced.
+FILE* OpenIndex(const std::string& path, const struct stat& st) {
+  FILE* index = fopen(path.c_str(), "r+b");
+  if (index != nullptr) {
+    IndexHeader header;
+    struct stat index_st;
+    if (fread(&header, sizeof(header), 1, index) == 1 &&
+        header.magic == log_index::kMagic &&
+        header.version == log_index::kVersion &&
+        header.device == (uint64_t)st.st_dev &&
+        header.inode == (uint64_t)st.st_ino &&
+        fstat(fileno(index), &index_st) == 0) {
+      // Drops a partially written last entry, if any.
+      size_t entries = (index_st.st_size - sizeof(header)) / sizeof(IndexEntry);
+      if (ftruncate(fileno(index),
+                    sizeof(header) + entries * sizeof(IndexEntry)) == 0 &&
+          fseek(index, 0, SEEK_END) == 0) {
+        return index;
+      }
+    }
+    fclose(index);
+  }
+  index = fopen(path.c_str(), "wb");
+  if (index == nullptr) return nullptr;
+  IndexHeader header;
+  header.magic = log_index::kMagic;
+  header.version = log_index::kVersion;
+  header.device = st.st_dev;
+  header.inode = st.st_ino;
+  fwrite(&header, sizeof(header), 1, index);
+  return index;
+}
+
+}  // namespace
+
+FileSink::FileSink(const char* path, size_t max_file_size, int max_files,
+                   size_t index_interval)
+    : path_(path),
+      max_file_size_(max_file_size),
+      max_files_(max_files < 1 ? 1 : max_files),
+      index_interval_(index_interval),
+      file_(nullptr),
+      index_(nullptr),
+      size_(0),
+      next_index_offset_(0) {
+  open();
+}
+
+FileSink::~FileSink() { close(); }
+
+std::string FileSink::segmentPath(int segment) const {
+  if (segment == 0) return path_;
+  return path_ + "." + std::to_string(segment);
+}
+
+void FileSink::open() {
+  file_ = fopen(path_.c_str(), "a");
+  if (file_ == nullptr) return;
+  struct stat st;
+  if (fstat(fileno(file_), &st) != 0) {
+    fclose(file_);
+    file_ = nullptr;
+    return;
+  }
+  size_ = st.st_size;
+  // Indexes the first line after (re)opening, since the uptime restarts.
+  next_index_offset_ = size_;
+  index_ = OpenIndex(indexPath(0), st);
+}
+
+void FileSink::close() {
+  if (file_ != nullptr) {
+    fclose(file_);
+    file_ = nullptr;
+  }
+  if (index_ != nullptr) {
+    fclose(index_);
+    index_ = nullptr;
+  }
+}
+
+void FileSink::flush() {
+  // The data first, so that the index never points past it.
+  fflush(file_);
+  if (index_ != nullptr) fflush(index_);
+}
+
+void FileSink::rotate() {
+  close();
+  // Each index moves along with its segment. Renames preserve the inodes
+  // that the indexes refer to, so a crash between the two renames leaves an
+  // index that is detectably stale, rather than wrong.
+  for (int i = max_files_ - 1; i >= 1; --i) {
+    rename(segmentPath(i - 1).c_str(), segmentPath(i).c_str());
+    rename(indexPath(i - 1).c_str(), indexPath(i).c_str());
+  }
+  if (max_files_ == 1) {
+    unlink(path_.c_str());
+    unlink(indexPath(0).c_str());
+  }
+  open();
+}
+
+void FileSink::send(LogSeverity severity, const char* full_filename,
+                    const char* base_filename, int line,
+                    roo_time::Uptime uptime, roo_time::WallTime walltime,
+                    const char* message, size_t message_len) {
+  write(0, severity, base_filename, line, uptime, walltime, message,
+        message_len);
+}
+
+void FileSink::sendRecord(const LogRecord& record) {
+  // The text rendering of the fields directly follows the message.
+  write(record.sequence, record.severity, record.base_filename, record.line,
+        record.uptime, record.walltime, record.message,
+        record.message_len + record.fields.text_size());
+}
+
+void FileSink::write(uint64_t sequence, LogSeverity severity,
+                     const char* base_filename, int line,
+                     roo_time::Uptime uptime, roo_time::WallTime walltime,
+                     const char* message, size_t message_len) {
+  char prefix[128];
+  size_t prefix_len =
+      FormatLogPrefix(prefix, sizeof(prefix), severity, uptime, walltime,
+                      sequence, nullptr, base_filename, strlen(base_filename),
+                      line);
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (file_ != nullptr && size_ >= max_file_size_) rotate();
+  if (file_ == nullptr) return;
+  if (index_ != nullptr && size_ >= next_index_offset_) {
+    IndexEntry entry;
+    entry.uptime_us = (uptime - roo_time::Uptime::Start()).inMicros();
+    entry.walltime_us = walltime.sinceEpoch().inMicros();
+    entry.offset = size_;
+    fwrite(&entry, sizeof(entry), 1, index_);
+    next_index_offset_ = size_ + index_interval_;
+  }
+  fwrite(prefix, 1, prefix_len, file_);
+  fwrite(message, 1, message_len, file_);
+  fputc('\n', file_);
+  size_ += prefix_len + message_len + 1;
+  if (severity >= ROO_LOGGING_WARNING) flush();
+}
+
+void FileSink::WaitTillSent() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (file_ != nullptr) flush();
+}
+
+}  // namespace roo_logging
+
+#endif  // defined(__linux__)
@@ -0,0 +1,109 @@
+#pragma once
+
+#if defined(__linux__)
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include <mutex>
+#include <string>
+
+#include "roo_logging/sink.h"
+#include "roo_time.h"
+
+namespace roo_logging {
+
+/// Sparse time index of a log file, written by FileSink alongside each
+/// segment (as <segment>.idx), and used by the log_query tool (see tools/) to
+/// seek directly to a time range, instead of scanning the whole file.
+///
+/// The index is an IndexHeader, followed by IndexEntry records, one for the
+/// first line of the segment, and then one for the first line at or past
+/// every index_interval bytes. Each entry gives the timestamps of the line
+/// that starts at the offset. The header identifies the segment by its inode,
+/// which is preserved when segments are renamed on rotation, so that an index
+/// that got separated from its segment (e.g. by a crash in the middle of
+/// rotation) is detected, and ignored. Integers are in the host byte order.
+namespace log_index {
+
+static constexpr uint32_t kMagic = 0x58494C52;  // "RLIX"
+static constexpr uint32_t kVersion = 1;
+
+struct IndexHeader {
+  uint32_t magic;
+  uint32_t version;
+  uint64_t device;
+  uint64_t inode;
+};
+
+struct IndexEntry {
+  int64_t uptime_us;
+  int64_t walltime_us;  // Zero if no wall time clock was configured.
+  uint64_t offset;
+};
+
+}  // namespace log_index
+
+/// A LogSink (Linux only) that writes log lines to a text file, rotating it
+/// when it grows past max_file_size: the file is renamed to <path>.1, the
+/// previous <path>.1 to <path>.2, and so on, up to max_files segments in
+/// total. Lines are written in the same format as to stderr (see
+/// roo_logging/log_line.h), minus the thread name. Each segment gets a sparse
+/// time index (see log_index above).
+///
+/// Lines are buffered, and flushed on messages of severity WARNING or higher,
+/// and on WaitTillSent().
+class FileSink : public LogSink {
+ public:
+  FileSink(const char* path, size_t max_file_size = 64 * 1024 * 1024,
+           int max_files = 8, size_t index_interval = 64 * 1024);
+
+  ~FileSink();
+
+  /// Returns true if the current segment is open.
+  bool ok() const { return file_ != nullptr; }
+
+  void send(LogSeverity severity, const char* full_filename,
+            const char* base_filename, int line, roo_time::Uptime uptime,
+            roo_time::WallTime walltime, const char* message,
+            size_t message_len) override;
+
+  /// Like send(), but also writes the sequence number, if the
+  /// roo_logging_log_sequence flag is set.
+  void sendRecord(const LogRecord& record) override;
+
+  void WaitTillSent() override;
+
+  /// Returns the path of the specified segment (0 being the current one).
+  std::string segmentPath(int segment) const;
+
+  /// Returns the path of the index of the specified segment.
+  std::string indexPath(int segment) const {
+    return segmentPath(segment) + ".idx";
+  }
+
+ private:
+  void open();
+  void close();
+  void rotate();
+  void flush();
+  void write(uint64_t sequence, LogSeverity severity, const char* base_filename,
+             int line, roo_time::Uptime uptime, roo_time::WallTime walltime,
+             const char* message, size_t message_len);
+
+  std::string path_;
+  size_t max_file_size_;
+  int max_files_;
+  size_t index_interval_;
+
+  std::mutex mutex_;
+  FILE* file_;
+  FILE* index_;
+  size_t size_;
+  size_t next_index_offset_;
+};
+
+}  // namespace roo_logging
+
+#endif  // defined(__linux__)
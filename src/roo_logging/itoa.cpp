@@ -0,0 +1,157 @@
+#include "roo_logging/itoa.h"
+
+#include <string.h>
+
+namespace roo_logging {
+
+namespace {
+
+const char kDigitPairs[] =
+    "00010203040506070809"
+    "10111213141516171819"
+    "20212223242526272829"
+    "30313233343536373839"
+    "40414243444546474849"
+    "50515253545556575859"
+    "60616263646566676869"
+    "70717273747576777879"
+    "80818283848586878889"
+    "90919293949596979899";
+
+const char kUpperDigits[] = "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZ";
+const char kLowerDigits[] = "0123456789abcdefghijklmnopqrstuvwxyz";
+
+// Binary representations of all nibbles.
+const char kNibbleBits[] =
+    "0000000100100011010001010110011110001001101010111100110111101111";
+
+const uint64_t kPowersOf10[] = {
+    1ull,
+    10ull,
+    100ull,
+    1000ull,
+    10000ull,
+    100000ull,
+    1000000ull,
+    10000000ull,
+    100000000ull,
+    1000000000ull,
+    10000000000ull,
+    100000000000ull,
+    1000000000000ull,
+    10000000000000ull,
+    100000000000000ull,
+    1000000000000000ull,
+    10000000000000000ull,
+    100000000000000000ull,
+    1000000000000000000ull,
+    10000000000000000000ull,
+};
+
+// Number of significant bits in n, for n > 0.
+inline int BitWidth(uint64_t n) { return 64 - __builtin_clzll(n); }
+
+// Returns log2(base) if base is 2, 8, or 16, and 0 otherwise.
+inline int PowerOfTwoShift(int base) {
+  return base == 16 ? 4 : base == 8 ? 3 : base == 2 ? 1 : 0;
+}
+
+inline char* WriteDecimal32(uint32_t n, char* end) {
+  while (n >= 100) {
+    uint32_t q = n / 100;
+    uint32_t r = n - q * 100;
+    n = q;
+    end -= 2;
+    memcpy(end, &kDigitPairs[r * 2], 2);
+  }
+  if (n >= 10) {
+    end -= 2;
+    memcpy(end, &kDigitPairs[n * 2], 2);
+  } else {
+    *--end = (char)('0' + n);
+  }
+  return end;
+}
+
+inline void WriteDecimal(uint64_t n, char* end) {
+  // Peel off the high part with (slower) 64-bit divisions, until the rest
+  // fits in 32 bits.
+  while (n > 0xFFFFFFFFu) {
+    uint64_t q = n / 100;
+    uint32_t r = (uint32_t)(n - q * 100);
+    n = q;
+    end -= 2;
+    memcpy(end, &kDigitPairs[r * 2], 2);
+  }
+  WriteDecimal32((uint32_t)n, end);
+}
+
+inline void WriteBinary(uint64_t n, int digits, char* end) {
+  while (digits >= 4) {
+    end -= 4;
+    memcpy(end, &kNibbleBits[(n & 0xF) * 4], 4);
+    n >>= 4;
+    digits -= 4;
+  }
+  if (digits > 0) {
+    // The leading, partial nibble.
+    end -= digits;
+    memcpy(end, &kNibbleBits[(n & 0xF) * 4 + 4 - digits], digits);
+  }
+}
+
+}  // namespace
+
+int CountDigits(uint64_t n, int base) {
+  if (n == 0) return 1;
+  if (base == 10) {
+    // Approximates log10(n) as log2(n) * 1233 / 4096, and corrects it.
+    int t = (BitWidth(n) * 1233) >> 12;
+    return t + (n >= kPowersOf10[t] ? 1 : 0);
+  }
+  int shift = PowerOfTwoShift(base);
+  if (shift > 0) return (BitWidth(n) + shift - 1) / shift;
+  int digits = 0;
+  do {
+    n /= base;
+    ++digits;
+  } while (n > 0);
+  return digits;
+}
+
+void WriteDigits(uint64_t n, int base, char* end, bool lowercase) {
+  if (base == 10) {
+    WriteDecimal(n, end);
+    return;
+  }
+  if (base == 2) {
+    WriteBinary(n, CountDigits(n, 2), end);
+    return;
+  }
+  const char* digits = lowercase ? kLowerDigits : kUpperDigits;
+  int shift = PowerOfTwoShift(base);
+  if (shift > 0) {
+    uint32_t mask = base - 1;
+    do {
+      *--end = digits[n & mask];
+      n >>= shift;
+    } while (n > 0);
+    return;
+  }
+  do {
+    uint64_t q = n / base;
+    *--end = digits[n - q * base];
+    n = q;
+  } while (n > 0);
+}
+
+size_t FormatInteger(uint64_t n, bool negative, int base, char* buf) {
+  if (base < 2 || base > 36) base = 10;
+  size_t len = CountDigits(n, base);
+  char* p = buf;
+  if (negative) *p++ = '-';
+  WriteDigits(n, base, p + len, false);
+  return (p - buf) + len;
+}
+
+}  // namespace roo_logging
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace roo_logging {
+
+/// Buffer size sufficient for any output of FormatInteger (64 binary digits,
+/// plus the sign).
+static constexpr size_t kMaxIntegerChars = 65;
+
+/// Returns the number of digits of n in the given base (2 to 36).
+int CountDigits(uint64_t n, int base);
+
+/// Writes exactly CountDigits(n, base) digits of n, ending just before `end`
+/// (i.e. backwards). Decimal numbers are converted two digits at a time,
+/// using a lookup table, and with 32-bit arithmetic whenever the value fits.
+/// Bases 2, 8, and 16 use shifts and masks. Digits above 9 are written as
+/// upper-case letters, unless lowercase is true.
+void WriteDigits(uint64_t n, int base, char* end, bool lowercase = false);
+
+/// Writes n in the given base, preceded by '-' if negative is true, and
+/// returns the number of characters written (no terminating '\0'). The
+/// buffer must hold at least kMaxIntegerChars.
+size_t FormatInteger(uint64_t n, bool negative, int base, char* buf);
+
+}  // namespace roo_logging
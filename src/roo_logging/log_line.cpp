@@ -0,0 +1,250 @@
+#include "roo_logging/log_line.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "roo_logging/config.h"
+#include "roo_logging/stream.h"
+
+namespace roo_logging {
+
+namespace {
+
+// Parses exactly n digits.
+bool ParseDigits(const char*& p, const char* end, int n, int64_t& value) {
+  if (end - p < n) return false;
+  value = 0;
+  for (int i = 0; i < n; ++i) {
+    if (p[i] < '0' || p[i] > '9') return false;
+    value = value * 10 + (p[i] - '0');
+  }
+  p += n;
+  return true;
+}
+
+// Parses one or more digits.
+bool ParseNumber(const char*& p, const char* end, int64_t& value) {
+  if (p == end || *p < '0' || *p > '9') return false;
+  value = 0;
+  while (p != end && *p >= '0' && *p <= '9') value = value * 10 + (*p++ - '0');
+  return true;
+}
+
+bool Expect(const char*& p, const char* end, char c) {
+  if (p == end || *p != c) return false;
+  ++p;
+  return true;
+}
+
+// Parses an optional fraction of a second (".uuuuuu", up to 6 digits).
+void ParseMicros(const char*& p, const char* end, int64_t& micros) {
+  micros = 0;
+  if (p == end || *p != '.') return;
+  const char* q = p + 1;
+  int digits = 0;
+  while (q != end && *q >= '0' && *q <= '9' && digits < 6) {
+    micros = micros * 10 + (*q++ - '0');
+    ++digits;
+  }
+  if (digits == 0) return;
+  for (; digits < 6; ++digits) micros *= 10;
+  p = q;
+}
+
+// Days since the Unix epoch for a date in the proleptic Gregorian calendar.
+int64_t DaysFromCivil(int64_t y, int64_t m, int64_t d) {
+  y -= m <= 2;
+  int64_t era = (y >= 0 ? y : y - 399) / 400;
+  int64_t yoe = y - era * 400;
+  int64_t doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+  int64_t doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+  return era * 146097 + doe - 719468;
+}
+
+// Parses "S+DDDDDD.HH:MM:SS[.uuuuuu]".
+bool ParseUptime(const char*& p, const char* end, int64_t& time_us) {
+  if (!Expect(p, end, 'S') || p == end) return false;
+  bool negative = (*p == '-');
+  if (*p != '+' && *p != '-') return false;
+  ++p;
+  int64_t days, hours, minutes, seconds, micros;
+  if (!ParseNumber(p, end, days) || !Expect(p, end, '.') ||
+      !ParseDigits(p, end, 2, hours) || !Expect(p, end, ':') ||
+      !ParseDigits(p, end, 2, minutes) || !Expect(p, end, ':') ||
+      !ParseDigits(p, end, 2, seconds)) {
+    return false;
+  }
+  ParseMicros(p, end, micros);
+  time_us = (((days * 24 + hours) * 60 + minutes) * 60 + seconds) * 1000000 +
+            micros;
+  if (negative) time_us = -time_us;
+  return true;
+}
+
+// Parses "YYYY-MM-DDTHH:MM:SS[.uuuuuu][(+|-)HH:MM]".
+bool ParseDateTime(const char*& p, const char* end, int64_t& time_us) {
+  int64_t year, month, day, hours, minutes, seconds, micros;
+  if (!ParseDigits(p, end, 4, year) || !Expect(p, end, '-') ||
+      !ParseDigits(p, end, 2, month) || !Expect(p, end, '-') ||
+      !ParseDigits(p, end, 2, day) || !Expect(p, end, 'T') ||
+      !ParseDigits(p, end, 2, hours) || !Expect(p, end, ':') ||
+      !ParseDigits(p, end, 2, minutes) || !Expect(p, end, ':') ||
+      !ParseDigits(p, end, 2, seconds)) {
+    return false;
+  }
+  if (month < 1 || month > 12 || day < 1 || day > 31) return false;
+  ParseMicros(p, end, micros);
+  int64_t offset_minutes = 0;
+  if (p != end && (*p == '+' || *p == '-')) {
+    const char* q = p + 1;
+    int64_t offset_hours, offset_mins;
+    if (ParseDigits(q, end, 2, offset_hours) && Expect(q, end, ':') &&
+        ParseDigits(q, end, 2, offset_mins)) {
+      offset_minutes = offset_hours * 60 + offset_mins;
+      if (*p == '-') offset_minutes = -offset_minutes;
+      p = q;
+    }
+  } else if (p != end && *p == 'Z') {
+    ++p;
+  }
+  int64_t secs = DaysFromCivil(year, month, day) * 86400 + hours * 3600 +
+                 minutes * 60 + seconds - offset_minutes * 60;
+  time_us = secs * 1000000 + micros;
+  return true;
+}
+
+}  // namespace
+
+LogSeverity SeverityFromLetter(char letter) {
+  for (int i = 0; i < NUM_SEVERITIES; ++i) {
+    if (LogSeverityNames[i][0] == letter) return i;
+  }
+  return -1;
+}
+
+size_t FormatLogPrefix(char* buf, size_t size, LogSeverity severity,
+                       roo_time::Uptime uptime, roo_time::WallTime walltime,
+                       uint64_t sequence, const char* thread,
+                       const char* file, size_t file_len, int line) {
+  ConfigRef config;
+  Stream s(buf, size - 1);
+  s << ((severity >= 0 && severity < NUM_SEVERITIES)
+            ? LogSeverityNames[severity][0]
+            : '?');
+  if (walltime == roo_time::WallTime()) {
+    s << uptime;
+  } else {
+    s << roo_time::DateTime(walltime, config->timezone);
+  }
+  if (sequence != 0 && config->log_sequence) {
+    s << " #" << (unsigned long long)sequence;
+  }
+  if (thread != nullptr) s << " " << thread;
+  s << " ";
+  s.write(file, file_len);
+  s << ":" << line << "] ";
+  size_t len = s.pcount();
+  buf[len] = '\0';
+  return len;
+}
+
+bool ParseLogTime(const char** text, const char* end, bool& has_walltime,
+                  int64_t& time_us) {
+  const char* p = *text;
+  if (p != end && *p == 'S') {
+    if (!ParseUptime(p, end, time_us)) return false;
+    has_walltime = false;
+  } else {
+    if (!ParseDateTime(p, end, time_us)) return false;
+    has_walltime = true;
+  }
+  *text = p;
+  return true;
+}
+
+bool ParseTimeArg(const char* arg, bool& has_walltime, int64_t& time_us) {
+  const char* end = arg + strlen(arg);
+  return ParseLogTime(&arg, end, has_walltime, time_us) && arg == end;
+}
+
+LogSeverity ParseSeverity(const char* arg) {
+  for (int i = 0; i < NUM_SEVERITIES; ++i) {
+    if (strcmp(arg, LogSeverityNames[i]) == 0) return i;
+  }
+  if (arg[0] != '\0' && arg[1] == '\0') return SeverityFromLetter(arg[0]);
+  return -1;
+}
+
+void LogLineFilter::setFile(const char* arg) {
+  file = arg;
+  const char* colon = strrchr(arg, ':');
+  if (colon == nullptr) {
+    file_len = strlen(arg);
+    line = -1;
+  } else {
+    file_len = colon - arg;
+    line = atoi(colon + 1);
+  }
+}
+
+bool LogLineFilter::matches(const LogLine& log_line) const {
+  if (log_line.severity < min_severity) return false;
+  if (has_time_range) {
+    if (log_line.has_walltime != walltime) return false;
+    if (log_line.time_us < from_us || log_line.time_us > to_us) return false;
+  }
+  if (file != nullptr) {
+    if (file_len != log_line.file_len ||
+        memcmp(file, log_line.file, file_len) != 0) {
+      return false;
+    }
+    if (line >= 0 && line != log_line.line) return false;
+  }
+  return true;
+}
+
+bool ParseLogLine(const char* text, size_t len, LogLine& result) {
+  const char* p = text;
+  const char* end = text + len;
+  if (p == end) return false;
+  result.severity = SeverityFromLetter(*p++);
+  if (result.severity < 0) return false;
+  if (!ParseLogTime(&p, end, result.has_walltime, result.time_us) ||
+      !Expect(p, end, ' ')) {
+    return false;
+  }
+  result.sequence = 0;
+  if (p != end && *p == '#') {
+    const char* q = p + 1;
+    int64_t sequence;
+    if (ParseNumber(q, end, sequence) && Expect(q, end, ' ')) {
+      result.sequence = (uint64_t)sequence;
+      p = q;
+    }
+  }
+  // The "file:line]" is the first token ending with ']'; anything before it
+  // is the thread name (which may contain spaces, e.g. on FreeRTOS).
+  const char* bracket = p;
+  while (bracket != end && *bracket != ']') ++bracket;
+  if (bracket == end) return false;
+  const char* file = bracket;
+  while (file != p && file[-1] != ' ') --file;
+  const char* colon = bracket;
+  while (colon != file && *colon != ':') --colon;
+  if (colon == file) return false;
+  const char* q = colon + 1;
+  int64_t line;
+  if (!ParseNumber(q, bracket, line) || q != bracket) return false;
+  result.line = (int)line;
+  result.file = file;
+  result.file_len = colon - file;
+  result.thread = p;
+  result.thread_len = (file == p) ? 0 : (file - 1 - p);
+  p = bracket + 1;
+  if (p != end && *p == ' ') ++p;
+  result.message = p;
+  result.message_len = end - p;
+  return true;
+}
+
+}  // namespace roo_logging
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "roo_logging/log_severity.h"
+#include "roo_time.h"
+
+namespace roo_logging {
+
+/// Parsing of log text, as written to stderr (see LogMessage::Init), and by
+/// the file sinks, for host-side tools:
+///
+///   I2026-10-18T14:02:03.123456+02:00 main foo.cpp:12] Message
+///   WS+000001.02:03:04.000005 #42 foo.cpp:12] Message
+///
+/// i.e. the severity letter, the wall time (ISO 8601, with an optional UTC
+/// offset) or the uptime, optionally the sequence number (see the
+/// roo_logging_log_sequence flag), optionally the thread (or task) name, the
+/// file and the line, and the message. Lines that don't parse are
+/// continuations of multi-line messages.
+struct LogLine {
+  LogSeverity severity;
+
+  // True if the line has a wall time; false if it has an uptime.
+  bool has_walltime;
+
+  // Microseconds since the Unix epoch (UTC), or since the start, depending
+  // on has_walltime.
+  int64_t time_us;
+
+  // Zero if not present.
+  uint64_t sequence;
+
+  // Empty if not present.
+  const char* thread;
+  size_t thread_len;
+
+  const char* file;
+  size_t file_len;
+  int line;
+
+  const char* message;
+  size_t message_len;
+};
+
+/// Parses a single line (without the trailing newline). Returns false if it
+/// is not a log line.
+bool ParseLogLine(const char* text, size_t len, LogLine& result);
+
+/// Parses a time, in either of the formats used in log lines, consuming the
+/// longest prefix of [*text, end) that forms it. Also accepts times with
+/// fewer fraction digits, or none. On success, advances *text past the time.
+bool ParseLogTime(const char** text, const char* end, bool& has_walltime,
+                  int64_t& time_us);
+
+/// Parses a time given on its own (e.g. as a command-line argument), in
+/// either of the formats accepted by ParseLogTime(). Returns false unless the
+/// entire string is a time.
+bool ParseTimeArg(const char* arg, bool& has_walltime, int64_t& time_us);
+
+/// Parses a severity given by name (INFO, WARNING, ERROR, FATAL), or by its
+/// first letter. Returns -1 if it is neither.
+LogSeverity ParseSeverity(const char* arg);
+
+/// Filters on the first line of a message (see the log_grep and log_query
+/// tools). The default filter matches every line.
+struct LogLineFilter {
+  LogSeverity min_severity = ROO_LOGGING_INFO;
+
+  // If set, only lines with time_us in [from_us, to_us], and with the same
+  // kind of time (wall time or uptime), match.
+  bool has_time_range = false;
+  bool walltime = true;
+  int64_t from_us = INT64_MIN;
+  int64_t to_us = INT64_MAX;
+
+  // If non-null, only lines logged from this file (base name), and, if
+  // non-negative, this line, match.
+  const char* file = nullptr;
+  size_t file_len = 0;
+  int line = -1;
+
+  /// Sets the file (and the line) from "FILE", or "FILE:LINE". The string
+  /// must outlive the filter.
+  void setFile(const char* arg);
+
+  bool matches(const LogLine& line) const;
+};
+
+/// Formats the beginning of a log line, up to and including the "] " that
+/// precedes the message, as the file sinks write it, and as ParseLogLine()
+/// reads it back: the wall time in the configured time zone, or the uptime
+/// if the wall time is zero; the sequence number, unless zero or turned off;
+/// and the thread name, unless null. Writes at most size - 1 characters, and
+/// the terminating zero. Returns the length.
+size_t FormatLogPrefix(char* buf, size_t size, LogSeverity severity,
+                       roo_time::Uptime uptime, roo_time::WallTime walltime,
+                       uint64_t sequence, const char* thread,
+                       const char* file, size_t file_len, int line);
+
+/// Returns the severity for the specified letter (I, W, E, F), or -1.
+LogSeverity SeverityFromLetter(char letter);
+
+}  // namespace roo_logging
@@ -38,15 +38,35 @@
 #include <pthread.h>
 #endif
 
+#include <atomic>
+
+#include "roo_logging/dedup.h"
+#include "roo_logging/encoders.h"
 #include "roo_logging/exit.h"
+#include "roo_logging/log_message_data.h"
 #include "roo_logging/sink.h"
 #include "roo_logging/stderr.h"
+#include "roo_logging/timestamp.h"
 #include "roo_threads.h"
 #include "roo_threads/mutex.h"
 
 namespace roo_logging {
 
-void WaitForSinks(LogMessage::LogMessageData* data) {}
+// Keeps the per-message overhead (besides the text buffer) in check. See
+// benchmarks/struct_size_report.cpp; on 64-bit targets, the stream buffer
+// is 32 bytes and the rest of the metadata is 63.
+static_assert(sizeof(StreamBuffer) <= 2 * sizeof(void*) + 16,
+              "StreamBuffer got too large");
+static_assert(sizeof(LogMessage::LogMessageData) -
+                      sizeof(LogMessage::LogMessageData::message_text_) -
+                      sizeof(Stream) <=
+                  64,
+              "LogMessageData metadata got too large");
+
+// Lets the sink deliver what it has buffered, before the process dies.
+void WaitForSinks(LogMessage::LogMessageData* data) {
+  if (sink_ != nullptr) sink_->WaitTillSent();
+}
 
 // For now we're going to assume that logging will only be called from the
 // user thread.
@@ -64,14 +84,20 @@ static bool exit_on_dfatal = true;
 // Using a function, to make sure that the mutex is initialized even if
 // LOG(INFO) gets called from a static initializer itself. (Otherwise, there's
 // undefined initialization order).
-static roo::mutex& log_mutex() {
+roo::mutex& log_mutex() {
   static roo::mutex m;
   return m;
 };
 
+// The sequence number of the last created message.
+static std::atomic<uint64_t> last_sequence_(0);
+
 // Number of messages sent at each severity.  Under log_mutex.
 int64_t num_messages_[NUM_SEVERITIES] = {0, 0, 0, 0};
 
+// Number of messages that did not fit in the buffer.  Under log_mutex.
+static int64_t num_truncated_messages_ = 0;
+
 // // Globally disable log writing (if disk is full)
 // static bool stop_writing = false;
 
@@ -85,40 +111,25 @@ const char* const_basename(const char* filepath) {
   return base ? (base + 1) : filepath;
 }
 
-}  // namespace
+// The data of a message created via the (file, line) constructors, together
+// with its call site (as these messages don't have a static one).
+struct LogMessageDataWithSite : public LogMessage::LogMessageData {
+  explicit LogMessageDataWithSite(const LogSite& site) : site(site) {}
 
-struct LogMessage::LogMessageData {
-  LogMessageData() : stream_(message_text_, kMaxLogMessageLen) {}
-
-  //   int preserved_errno_;      // preserved errno
-  // Buffer space; contains complete message text.
-  char message_text_[kMaxLogMessageLen + 1];
-  Stream stream_;
-  char severity_;  // What level is this LogMessage logged at?
-  int line_;       // line number where logging call is.
-  void (LogMessage::*send_method_)();  // Call this in destructor to send
-  //   union {  // At most one of these is used: union to keep the size low.
-  //     LogSink* sink_;             // NULL or sink to send message to
-  //     std::vector<std::string>* outvec_; // NULL or vector to push message
-  //     onto std::string* message_;             // NULL or string to write
-  //     message into
-  //   };
-  roo_time::Uptime uptime_;      // Time of creation of LogMessage
-  roo_time::WallTime walltime_;  // Time of creation of LogMessage
-  size_t num_prefix_chars_;      // # of chars of prefix in this message
-  size_t num_chars_to_log_;      // # of chars of msg to send to log
-  //   size_t num_chars_to_syslog_;  // # of chars of msg to send to syslog
-  const char* basename_;          // basename of file that called LOG
-  const char* fullname_;          // fullname of file that called LOG
-  bool has_been_flushed_;         // false => data has not been flushed
-  bool first_fatal_;              // true => this was first fatal msg
-  bool from_static_initializer_;  // true => logging before main()
-
- private:
-  LogMessageData(const LogMessageData&);
-  void operator=(const LogMessageData&);
+  LogSite site;
 };
 
+// Returns the wall time corresponding to the specified uptime, or the epoch
+// if no wall time clock is configured.
+roo_time::WallTime WallTimeAt(const ConfigSnapshot& config,
+                              roo_time::Uptime uptime) {
+  return WallTimeAt(config.wall_time_clock,
+                    (TimestampSource)config.timestamp_source, uptime);
+}
+
+}  // namespace
+
+
 LogMessage::LogMessage(const char* file, int line, LogSeverity severity,
                        int ctr, void (LogMessage::*send_method)())
     : allocated_(NULL) {
@@ -141,6 +152,23 @@ LogMessage::LogMessage(const char* file, int line, LogSeverity severity)
   Init(file, line, severity, &LogMessage::SendToLog);
 }
 
+LogMessage::LogMessage(const LogSite* site) : allocated_(NULL) {
+  Init(site, &LogMessage::SendToLog);
+}
+
+LogMessage::LogMessage(const LogSite* site, int ctr,
+                       void (LogMessage::*send_method)())
+    : allocated_(NULL) {
+  Init(site, send_method);
+  data_->stream_.set_ctr(ctr);
+}
+
+LogMessage::LogMessage(const LogSite* site, const CheckOpString& result)
+    : allocated_(NULL) {
+  Init(site, &LogMessage::SendToLog);
+  stream() << "Check failed: " << (*result.str_) << " ";
+}
+
 // LogMessage::LogMessage(const char* file, int line, LogSeverity severity,
 //                        LogSink* sink, bool also_send_to_log)
 //     : allocated_(NULL) {
@@ -166,7 +194,21 @@ LogMessage::LogMessage(const char* file, int line, LogSeverity severity)
 
 void LogMessage::Init(const char* file, int line, LogSeverity severity,
                       void (LogMessage::*send_method)()) {
+  LogMessageDataWithSite* data = new LogMessageDataWithSite(
+      LogSite(file, const_basename(file) - file, line, severity));
+  data->has_dynamic_site_ = true;
+  Init(&data->site, data, send_method);
+}
+
+void LogMessage::Init(const LogSite* site,
+                      void (LogMessage::*send_method)()) {
+  Init(site, new LogMessageData(), send_method);
+}
+
+void LogMessage::Init(const LogSite* site, LogMessageData* data,
+                      void (LogMessage::*send_method)()) {
   allocated_ = NULL;
+  LogSeverity severity = site->severity;
   if (severity != ROO_LOGGING_FATAL || !exit_on_dfatal) {
     // #ifdef GLOG_THREAD_LOCAL_STORAGE
     //     // No need for locking, because this is thread local.
@@ -178,12 +220,12 @@ void LogMessage::Init(const char* file, int line, LogSeverity severity,
     //       data_ = allocated_;
     //     }
     // #else   // !defined(GLOG_THREAD_LOCAL_STORAGE)
-    allocated_ = new LogMessageData();
+    allocated_ = data;
     data_ = allocated_;
     // #endif  // defined(GLOG_THREAD_LOCAL_STORAGE)
     data_->first_fatal_ = false;
   } else {
-    allocated_ = new LogMessageData();
+    allocated_ = data;
     data_ = allocated_;
     // #endif  // defined(GLOG_THREAD_LOCAL_STORAGE)
     data_->first_fatal_ = false;
@@ -200,32 +242,35 @@ void LogMessage::Init(const char* file, int line, LogSeverity severity,
 
   //   stream().fill('0');
   //   data_->preserved_errno_ = errno;
-  data_->severity_ = severity;
-  data_->line_ = line;
+  data_->site_ = site;
   data_->send_method_ = send_method;
   //   data_->sink_ = NULL;
   //   data_->outvec_ = NULL;
 
-  data_->uptime_ = roo_time::Uptime::Now();
+  data_->config_ = AcquireConfig();
+  const ConfigSnapshot& config = *data_->config_;
+  data_->uptime_ = TimestampNow((TimestampSource)config.timestamp_source);
+  // Read the wall time clock only once, so that the prefix and the sinks
+  // get the same time.
+  data_->walltime_ = WallTimeAt(config, data_->uptime_);
+  data_->sequence_ =
+      last_sequence_.fetch_add(1, std::memory_order_relaxed) + 1;
 
   data_->num_chars_to_log_ = 0;
-  data_->basename_ = const_basename(file);
-  data_->fullname_ = file;
   data_->has_been_flushed_ = false;
   data_->from_static_initializer_ = false;
 
-  if (GET_ROO_FLAG(roo_logging_prefix)) {
+  if (config.prefix) {
     stream() << LogSeverityNames[severity][0];
-    roo_time::WallTimeClock* clock = GET_ROO_FLAG(roo_logging_wall_time_clock);
-    if (clock == nullptr) {
+    if (config.wall_time_clock == nullptr) {
       stream() << data_->uptime_ << " ";
     } else {
-      data_->walltime_ = clock->now();
-      roo_time::TimeZone tz = GET_ROO_FLAG(roo_logging_timezone);
-      roo_time::DateTime dt(data_->walltime_, tz);
-      stream() << dt;
+      stream() << roo_time::DateTime(data_->walltime_, config.timezone);
       stream().write(' ');
     }
+    if (config.log_sequence) {
+      stream() << '#' << (unsigned long long)data_->sequence_ << ' ';
+    }
 #if (defined __FREERTOS || defined ESP_PLATFORM)
     TaskHandle_t tHandle = xTaskGetCurrentTaskHandle();
 
@@ -234,7 +279,7 @@ void LogMessage::Init(const char* file, int line, LogSeverity severity,
       char* tName = pcTaskGetName(tHandle);
       stream() << tName << '(' << tHandle;
 #if (defined portGET_CORE_ID)
-      if (GET_ROO_FLAG(roo_logging_freertos_log_core_id)) {
+      if (config.freertos_log_core_id) {
         BaseType_t core_id = portGET_CORE_ID();
         stream() << ",core" << (int)core_id;
       }
@@ -254,9 +299,12 @@ void LogMessage::Init(const char* file, int line, LogSeverity severity,
       }
     }
 #endif
-    stream() << data_->basename_ << ":" << data_->line_ << "] ";
+    stream() << site->basename() << ":" << site->line << "] ";
   }
   data_->num_prefix_chars_ = data_->stream_.pcount();
+  if (config.overflow_limit > 0) {
+    data_->stream_.enableOverflow(config.overflow_limit);
+  }
 
   //   if (!GET_ROO_GLOG_FLAG(log_backtrace_at).empty()) {
   //     char fileline[128];
@@ -273,6 +321,15 @@ void LogMessage::Init(const char* file, int line, LogSeverity severity,
 
 Stream& LogMessage::stream() { return data_->stream_; }
 
+const LogSite& LogMessage::site() const { return *data_->site_; }
+
+uint64_t LogMessage::sequence() const { return data_->sequence_; }
+
+int64_t LogMessage::num_truncated_messages() {
+  roo::lock_guard<roo::mutex> l{log_mutex()};
+  return num_truncated_messages_;
+}
+
 LogMessage::~LogMessage() {
   Flush();
   // #ifdef GLOG_THREAD_LOCAL_STORAGE
@@ -283,7 +340,12 @@ LogMessage::~LogMessage() {
   //     delete allocated_;
   //   }
   // #else   // !defined(GLOG_THREAD_LOCAL_STORAGE)
-  delete allocated_;
+  ReleaseConfig(data_->config_);
+  if (allocated_->has_dynamic_site_) {
+    delete static_cast<LogMessageDataWithSite*>(allocated_);
+  } else {
+    delete allocated_;
+  }
   allocated_ = nullptr;
   // #endif  // defined(GLOG_THREAD_LOCAL_STORAGE)
 }
@@ -292,26 +354,43 @@ LogMessage::~LogMessage() {
 // that needs to synchronize the log.
 void LogMessage::Flush() {
   if (data_->has_been_flushed_ ||
-      data_->severity_ < GET_ROO_FLAG(roo_logging_minloglevel)) {
+      data_->site_->severity < data_->config_->minloglevel) {
     return;
   }
 
-  data_->num_chars_to_log_ = data_->stream_.pos_;  // data_->stream_.pcount();
+  Stream& s = data_->stream_;
+  if (s.truncated() > 0 && s.overflow_enabled()) {
+    s.writeTruncationMarker();
+  }
+  data_->num_field_chars_ = 0;
+  if (s.has_fields()) {
+    // Render the structured fields as text, right after the message.
+    if (s.pos_ > data_->num_prefix_chars_ && s.buf_[s.pos_ - 1] == '\n') {
+      --s.pos_;
+    }
+    size_t fields_start = s.pos_;
+    if (s.pos_ > data_->num_prefix_chars_) s.write(' ');
+    WriteFieldsLogfmt(s,
+                      LogFields(s.fields_begin(), s.fields_end(), nullptr, 0));
+    data_->num_field_chars_ = s.pos_ - fields_start;
+  }
+
+  data_->num_chars_to_log_ = s.pos_;  // data_->stream_.pcount();
 
   // Do we need to add a \n to the end of this message?
-  bool append_newline =
-      (data_->message_text_[data_->num_chars_to_log_ - 1] != '\n');
+  bool append_newline = (s.buf_[data_->num_chars_to_log_ - 1] != '\n');
 
   if (append_newline) {
-    data_->message_text_[data_->num_chars_to_log_++] = '\n';
+    s.buf_[data_->num_chars_to_log_++] = '\n';
   }
 
   // Prevent any subtle race conditions by wrapping a mutex lock around
   // the actual logging action per se.
   {
     roo::lock_guard<roo::mutex> l{log_mutex()};
+    if (s.truncated() > 0) ++num_truncated_messages_;
     (this->*(data_->send_method_))();
-    ++num_messages_[static_cast<int>(data_->severity_)];
+    ++num_messages_[static_cast<int>(data_->site_->severity)];
   }
   // LogDestination::WaitForSinks(data_);
 
@@ -321,6 +400,7 @@ void LogMessage::Flush() {
 }
 
 void LogMessage::SendToLog() /*EXCLUSIVE_LOCKS_REQUIRED(log_mutex)*/ {
+  const LogSite& site = *data_->site_;
   // Messages of a given severity get logged to lower severity logs, too
 
   if (true) {
@@ -328,20 +408,39 @@ void LogMessage::SendToLog() /*EXCLUSIVE_LOCKS_REQUIRED(log_mutex)*/ {
     // LogToAllLogfiles(data_->severity_, data_->timestamp_,
     // data_->message_text_,
     //                  data_->num_chars_to_log_);
-    data_->message_text_[data_->num_chars_to_log_] = '\0';
-    MaybeLogToStderr(data_->severity_, data_->message_text_,
-                     data_->num_chars_to_log_, data_->from_static_initializer_);
-    MaybeLogToSink(data_->severity_, data_->fullname_, data_->basename_,
-                   data_->line_, data_->uptime_, data_->walltime_,
-                   data_->message_text_ + data_->num_prefix_chars_,
-                   (data_->num_chars_to_log_ - data_->num_prefix_chars_ - 1));
+    char* text = data_->stream_.buf_;
+    text[data_->num_chars_to_log_] = '\0';
+    roo_time::WallTime walltime = data_->walltime_;
+    const ConfigSnapshot& config = *data_->config_;
+    if (!config.dedup) {
+      EmitPendingRepeatSummary();
+    } else if (SuppressRepeatedMessage(
+                   site.severity, site.fullname(), site.basename(), site.line,
+                   data_->uptime_, walltime, text + data_->num_prefix_chars_,
+                   (data_->num_chars_to_log_ - data_->num_prefix_chars_ -
+                    1))) {
+      return;
+    }
+    MaybeLogToStderr(config, site.severity, text, data_->num_chars_to_log_,
+                     data_->from_static_initializer_);
     // NOTE: -1 removes trailing \n
+    size_t message_len = data_->num_chars_to_log_ - data_->num_prefix_chars_ -
+                         data_->num_field_chars_ - 1;
+    const char* message = text + data_->num_prefix_chars_;
+    MaybeLogToSink(
+        config,
+        LogRecord{data_->sequence_, site.severity, site.fullname(),
+                  site.basename(), site.line, data_->uptime_, walltime,
+                  message, message_len,
+                  LogFields(data_->stream_.fields_begin(),
+                            data_->stream_.fields_end(), message + message_len,
+                            data_->num_field_chars_)});
   }
 
   // If we log a FATAL message, flush all the log destinations, then toss
   // a signal for others to catch. We leave the logs in a state that
   // someone else can use them (as long as they flush afterwards)
-  if (data_->severity_ == ROO_LOGGING_FATAL && exit_on_dfatal) {
+  if (site.severity == ROO_LOGGING_FATAL && exit_on_dfatal) {
     // if (GET_ROO_FLAG(alsologtologfiles)) {
     //   // for (int i = 0; i < NUM_SEVERITIES; ++i) {
     //   //   if (LogDestination::log_destinations_[i])
@@ -366,6 +465,12 @@ LogMessageFatal::LogMessageFatal(const char* file, int line,
                                  const CheckOpString& result)
     : LogMessage(file, line, result) {}
 
+LogMessageFatal::LogMessageFatal(const LogSite* site) : LogMessage(site) {}
+
+LogMessageFatal::LogMessageFatal(const LogSite* site,
+                                 const CheckOpString& result)
+    : LogMessage(site, result) {}
+
 LogMessageFatal::~LogMessageFatal() {
   Flush();
   Fail();
@@ -33,6 +33,7 @@
 
 #include "roo_logging/base.h"
 #include "roo_logging/log_severity.h"
+#include "roo_logging/log_site.h"
 
 namespace roo_logging {
 
@@ -83,6 +84,13 @@ class LogMessage {
   // A special constructor used for check failures
   LogMessage(const char* file, int line, const CheckOpString& result);
 
+  // Constructors used by the LOG macros, taking a static call site
+  // descriptor (see ROO_LOGGING_SITE). The severity is taken from the site.
+  // Passing a single pointer makes for the least code at the call site.
+  explicit LogMessage(const LogSite* site);
+  LogMessage(const LogSite* site, int ctr, SendMethod send_method);
+  LogMessage(const LogSite* site, const CheckOpString& result);
+
   ~LogMessage();
 
   // Flush a buffered message to the sink set in the constructor.  Always
@@ -94,12 +102,30 @@ class LogMessage {
 
   Stream& stream();
 
+  // Number of messages that have been cut, because they did not fit in the
+  // buffer (including the spill buffer, in the overflow mode).
+  static int64_t num_truncated_messages();
+
+  // Returns the call site descriptor of this message.
+  const LogSite& site() const;
+
+  // Returns the global sequence number of this message, assigned when it was
+  // created (starting at 1). Unlike the order of output, it reflects the order
+  // in which messages from different threads were created.
+  uint64_t sequence() const;
+
   struct LogMessageData;
 
  private:
+  // Used by the (file, line) constructors; creates a per-message site.
   void Init(const char* file, int line, LogSeverity severity,
             void (LogMessage::*send_method)());
 
+  void Init(const LogSite* site, void (LogMessage::*send_method)());
+
+  void Init(const LogSite* site, LogMessageData* data,
+            void (LogMessage::*send_method)());
+
   // We keep the data in a separate struct so that each instance of
   // LogMessage uses less stack space.
   LogMessageData* allocated_;
@@ -113,6 +139,8 @@ class LogMessageFatal : public LogMessage {
  public:
   LogMessageFatal(const char* file, int line);
   LogMessageFatal(const char* file, int line, const CheckOpString& result);
+  explicit LogMessageFatal(const LogSite* site);
+  LogMessageFatal(const LogSite* site, const CheckOpString& result);
   __attribute__((noreturn)) ~LogMessageFatal();
 };
 
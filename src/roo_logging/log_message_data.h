@@ -0,0 +1,51 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "roo_logging/config.h"
+#include "roo_logging/log_message.h"
+#include "roo_logging/stream.h"
+#include "roo_time.h"
+
+namespace roo_logging {
+
+// The state of a LogMessage, allocated when the message is created. Kept
+// compact, since it's on the heap for every message in flight: lengths are
+// 16-bit (see StreamBuffer), the flags are bits, and they come last, right
+// before the text buffer, so that no padding follows them.
+//
+// Internal; exposed in a header only so that its size can be reported (see
+// benchmarks/struct_size_report.cpp).
+struct LogMessage::LogMessageData {
+  LogMessageData()
+      : stream_(message_text_, kMaxLogMessageLen),
+        has_been_flushed_(false),
+        first_fatal_(false),
+        from_static_initializer_(false),
+        has_dynamic_site_(false) {}
+
+  Stream stream_;
+  void (LogMessage::*send_method_)();  // Call this in destructor to send
+  roo_time::Uptime uptime_;            // Time of creation of LogMessage
+  roo_time::WallTime walltime_;        // Same, or the epoch if no clock
+  const ConfigSnapshot* config_;       // Flags, as of the creation
+  uint64_t sequence_;                  // Global sequence number
+  const LogSite* site_;                // call site: file, line, severity
+  uint16_t num_prefix_chars_;  // # of chars of prefix in this message
+  uint16_t num_chars_to_log_;  // # of chars of msg to send to log
+  uint16_t num_field_chars_;   // # of chars of rendered structured fields
+  bool has_been_flushed_ : 1;         // false => data has not been flushed
+  bool first_fatal_ : 1;              // true => this was first fatal msg
+  bool from_static_initializer_ : 1;  // true => logging before main()
+  bool has_dynamic_site_ : 1;         // true => allocated with the site
+
+  // Buffer space; contains complete message text (unless it spilled into a
+  // larger buffer; see StreamBuffer).
+  char message_text_[kMaxLogMessageLen + 1];
+
+ private:
+  LogMessageData(const LogMessageData&);
+  void operator=(const LogMessageData&);
+};
+
+}  // namespace roo_logging
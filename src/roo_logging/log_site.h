@@ -0,0 +1,82 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "roo_logging/log_severity.h"
+
+namespace roo_logging {
+
+namespace internal {
+
+// Returns the offset just past the last '/' in path[begin, end), or `none` if
+// there is no '/' in that range. Splits the range in halves, so that the
+// constexpr recursion depth is logarithmic in the path length (C++11
+// constexpr functions can't loop, and absolute __FILE__ paths can be long).
+constexpr size_t BasenameOffsetIn(const char* path, size_t begin, size_t end,
+                                  size_t none) {
+  return end - begin == 0   ? none
+         : end - begin == 1 ? (path[begin] == '/' ? end : none)
+                            : BasenameOffsetIn(
+                                  path, begin + (end - begin) / 2, end,
+                                  BasenameOffsetIn(path, begin,
+                                                   begin + (end - begin) / 2,
+                                                   none));
+}
+
+}  // namespace internal
+
+/// Returns the offset of the basename in the specified path of the specified
+/// length, i.e. the offset just past the last '/', or 0 if there is none.
+constexpr size_t BasenameOffset(const char* path, size_t len) {
+  return internal::BasenameOffsetIn(path, 0, len, 0);
+}
+
+/// Static descriptor of a logging call site. The LOG macros create one per
+/// call site, as a constexpr function-local static (see ROO_LOGGING_SITE), and
+/// pass it to LogMessage as a single pointer. Everything about the site,
+/// including the basename of the file, is thus computed at compile time, and
+/// the descriptor's address is a stable identity of the call site, usable
+/// e.g. for rate limiting or per-site statistics.
+///
+/// Messages created with the (file, line) LogMessage constructors (e.g. by
+/// LOG_AT_LEVEL, where the severity is not a compile-time constant) get a
+/// per-message descriptor, whose id() is not stable.
+struct LogSite {
+  LogSite() = default;
+
+  constexpr LogSite(const char* file, size_t basename_offset, int line,
+                    LogSeverity severity)
+      : file(file),
+        line(line),
+        basename_offset(basename_offset),
+        severity(severity) {}
+
+  /// Full name of the file that contains the call site.
+  const char* fullname() const { return file; }
+
+  /// Base name of the file that contains the call site.
+  const char* basename() const { return file + basename_offset; }
+
+  /// Identity of the call site.
+  uintptr_t id() const { return reinterpret_cast<uintptr_t>(this); }
+
+  const char* file;
+  int line;
+  uint16_t basename_offset;
+  uint8_t severity;
+};
+
+}  // namespace roo_logging
+
+// Evaluates to a pointer to the static LogSite descriptor of the enclosing
+// call site, with the specified severity (which must be a constant
+// expression).
+#define ROO_LOGGING_SITE(severity)                                     \
+  ([]() -> const ::roo_logging::LogSite* {                             \
+    static constexpr ::roo_logging::LogSite roo_logging_log_site(      \
+        __FILE__, ::roo_logging::BasenameOffset(__FILE__,              \
+                                                sizeof(__FILE__) - 1), \
+        __LINE__, (severity));                                         \
+    return &roo_logging_log_site;                                      \
+  }())
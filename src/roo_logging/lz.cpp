@@ -0,0 +1,152 @@
+#include "roo_logging/lz.h"
+
+#include <string.h>
+
+namespace roo_logging {
+namespace lz {
+
+namespace {
+
+static constexpr size_t kMaxOffset = 65535;
+
+inline uint32_t Read32(const uint8_t* p) {
+  uint32_t v;
+  memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+inline size_t MatchLength(const uint8_t* a, const uint8_t* b, size_t limit) {
+  size_t len = 0;
+  while (len < limit && a[len] == b[len]) ++len;
+  return len;
+}
+
+inline uint8_t* WriteLength(uint8_t* out, size_t len) {
+  while (len >= 255) {
+    *out++ = 255;
+    len -= 255;
+  }
+  *out++ = (uint8_t)len;
+  return out;
+}
+
+// Reads an extension length. Returns false if the input ends prematurely, or
+// if the length exceeds the limit.
+inline bool ReadLength(const uint8_t*& in, const uint8_t* end, size_t limit,
+                       size_t& len) {
+  while (true) {
+    if (in == end) return false;
+    uint8_t b = *in++;
+    len += b;
+    if (len > limit) return false;
+    if (b != 255) return true;
+  }
+}
+
+uint8_t* WriteSequence(uint8_t* out, const uint8_t* literals,
+                       size_t literal_len, size_t offset, size_t match_len) {
+  uint8_t* token = out++;
+  *token = (uint8_t)((literal_len < 15 ? literal_len : 15) << 4);
+  if (literal_len >= 15) out = WriteLength(out, literal_len - 15);
+  memcpy(out, literals, literal_len);
+  out += literal_len;
+  if (match_len == 0) return out;
+  *out++ = (uint8_t)offset;
+  *out++ = (uint8_t)(offset >> 8);
+  match_len -= kMinMatch;
+  *token |= (uint8_t)(match_len < 15 ? match_len : 15);
+  if (match_len >= 15) out = WriteLength(out, match_len - 15);
+  return out;
+}
+
+}  // namespace
+
+Compressor::Compressor() {}
+
+inline void Compressor::insert(const uint8_t* in, size_t pos) {
+  uint32_t hash = (Read32(in + pos) * 2654435761u) >> (32 - kHashBits);
+  int32_t prev = head_[hash];
+  chain_[pos] = (prev >= 0 && pos - prev <= kMaxOffset) ? pos - prev : 0;
+  head_[hash] = (int32_t)pos;
+}
+
+size_t Compressor::compress(const uint8_t* in, size_t len, uint8_t* out) {
+  for (int32_t& h : head_) h = -1;
+  uint8_t* op = out;
+  size_t anchor = 0;
+  size_t pos = 0;
+  while (pos + kMinMatch <= len) {
+    uint32_t hash = (Read32(in + pos) * 2654435761u) >> (32 - kHashBits);
+    size_t best_len = 0;
+    size_t best_offset = 0;
+    int32_t candidate = head_[hash];
+    size_t limit = len - pos;
+    for (int i = 0; candidate >= 0 && i < kMaxChainLength; ++i) {
+      size_t offset = pos - candidate;
+      if (offset > kMaxOffset) break;
+      // Cheap rejection: a longer match must extend past the best one.
+      if (in[candidate + best_len] == in[pos + best_len]) {
+        size_t match_len = MatchLength(in + candidate, in + pos, limit);
+        if (match_len > best_len) {
+          best_len = match_len;
+          best_offset = offset;
+          if (best_len == limit) break;
+        }
+      }
+      if (chain_[candidate] == 0) break;
+      candidate -= chain_[candidate];
+    }
+    insert(in, pos);
+    if (best_len < kMinMatch) {
+      ++pos;
+      continue;
+    }
+    op = WriteSequence(op, in + anchor, pos - anchor, best_offset, best_len);
+    size_t end = pos + best_len;
+    for (++pos; pos < end && pos + kMinMatch <= len; ++pos) insert(in, pos);
+    pos = end;
+    anchor = pos;
+  }
+  return WriteSequence(op, in + anchor, len - anchor, 0, 0) - out;
+}
+
+bool Decompress(const uint8_t* in, size_t in_len, uint8_t* out,
+                size_t out_len) {
+  const uint8_t* end = in + in_len;
+  size_t op = 0;
+  while (true) {
+    if (in == end) return false;
+    uint8_t token = *in++;
+    size_t literal_len = token >> 4;
+    if (literal_len == 15 && !ReadLength(in, end, out_len, literal_len)) {
+      return false;
+    }
+    if (literal_len > (size_t)(end - in) || literal_len > out_len - op) {
+      return false;
+    }
+    memcpy(out + op, in, literal_len);
+    in += literal_len;
+    op += literal_len;
+    if (in == end) return op == out_len;
+    if (end - in < 2) return false;
+    size_t offset = in[0] | (in[1] << 8);
+    in += 2;
+    size_t match_len = token & 15;
+    if (match_len == 15 && !ReadLength(in, end, out_len, match_len)) {
+      return false;
+    }
+    match_len += kMinMatch;
+    if (offset == 0 || offset > op || match_len > out_len - op) return false;
+    const uint8_t* src = out + op - offset;
+    if (offset >= match_len) {
+      memcpy(out + op, src, match_len);
+    } else {
+      // Overlapping; repeats the last offset bytes.
+      for (size_t i = 0; i < match_len; ++i) out[op + i] = src[i];
+    }
+    op += match_len;
+  }
+}
+
+}  // namespace lz
+}  // namespace roo_logging
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace roo_logging {
+
+/// A small, dependency-free LZ77 block compressor, used for compressed log
+/// files (see compressed_file_sink.h).
+///
+/// The format is LZ4-like: a sequence of (literal run, back-reference) pairs,
+/// each starting with a token byte, whose high nibble is the literal length,
+/// and the low nibble the match length minus kMinMatch (15 in either meaning
+/// "followed by extension bytes, each adding up to 255"). Back-references use
+/// 16-bit little-endian offsets. The last sequence has literals only.
+///
+/// The compressor searches a short hash chain for the longest match, rather
+/// than taking the first one. Log text repeats the same prefixes (severity,
+/// date, file names) and message templates, line after line, at varying
+/// distances, so the longer search pays off for it.
+namespace lz {
+
+/// Blocks can't be larger than this, so that all offsets fit in 16 bits.
+static constexpr size_t kMaxBlockSize = 64 * 1024;
+
+static constexpr size_t kMinMatch = 4;
+
+/// Returns the size of the buffer that Compress() needs, in the worst case
+/// (incompressible input), for len bytes of input.
+constexpr size_t MaxCompressedSize(size_t len) { return len + len / 255 + 16; }
+
+/// Keeps the match-finder tables. Around 150 KB; reusable for any number of
+/// blocks, but not thread-safe.
+class Compressor {
+ public:
+  Compressor();
+
+  /// Compresses len (at most kMaxBlockSize) bytes from in, into out, which
+  /// must have room for MaxCompressedSize(len) bytes. Returns the compressed
+  /// size.
+  size_t compress(const uint8_t* in, size_t len, uint8_t* out);
+
+ private:
+  static constexpr int kHashBits = 12;
+  static constexpr int kMaxChainLength = 16;
+
+  void insert(const uint8_t* in, size_t pos);
+
+  // Most recent position for each hash; -1 if none.
+  int32_t head_[1 << kHashBits];
+
+  // For each position, the distance to the previous position with the same
+  // hash; 0 if none.
+  uint16_t chain_[kMaxBlockSize];
+};
+
+/// Decompresses a block, which must decompress to exactly out_len bytes.
+/// Returns false if the input is malformed. Never reads or writes out of
+/// bounds, regardless of the input.
+bool Decompress(const uint8_t* in, size_t in_len, uint8_t* out,
+                size_t out_len);
+
+}  // namespace lz
+
+}  // namespace roo_logging
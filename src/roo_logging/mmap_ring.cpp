@@ -0,0 +1,232 @@
+#if defined(__linux__)
+
+#include "roo_logging/mmap_ring.h"
+
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+
+namespace roo_logging {
+
+namespace {
+
+using mmap_ring::Header;
+using mmap_ring::RecordHeader;
+using mmap_ring::kAlignment;
+using mmap_ring::kDataOffset;
+
+inline size_t AlignUp(size_t size) {
+  return (size + kAlignment - 1) & ~(kAlignment - 1);
+}
+
+// FNV-1a.
+uint32_t Hash(uint32_t hash, const uint8_t* data, size_t len) {
+  for (size_t i = 0; i < len; ++i) {
+    hash ^= data[i];
+    hash *= 16777619u;
+  }
+  return hash;
+}
+
+uint32_t RecordChecksum(RecordHeader header, const uint8_t* payload) {
+  header.checksum = 0;
+  uint32_t hash = Hash(2166136261u, reinterpret_cast<const uint8_t*>(&header),
+                       sizeof(header));
+  return Hash(hash, payload, header.file_len + header.message_len);
+}
+
+bool IsIntact(const uint8_t* record, size_t available,
+              const RecordHeader& header) {
+  if (header.magic != mmap_ring::kRecordMagic ||
+      header.size < sizeof(RecordHeader) || header.size > available ||
+      header.size % kAlignment != 0 ||
+      sizeof(RecordHeader) + header.file_len + header.message_len >
+          header.size) {
+    return false;
+  }
+  return RecordChecksum(header, record + sizeof(RecordHeader)) ==
+         header.checksum;
+}
+
+// Calls fn(offset, header) for each intact record in the data area. Skips
+// over damaged ones, by looking for a record at each aligned offset.
+template <typename Fn>
+void ScanRecords(const uint8_t* data, size_t capacity, Fn fn) {
+  size_t pos = 0;
+  while (pos + sizeof(RecordHeader) <= capacity) {
+    RecordHeader header;
+    memcpy(&header, data + pos, sizeof(header));
+    if (IsIntact(data + pos, capacity - pos, header)) {
+      fn(pos, header);
+      pos += header.size;
+    } else {
+      pos += kAlignment;
+    }
+  }
+}
+
+}  // namespace
+
+MmapRingSink::MmapRingSink(const char* path, size_t capacity)
+    : capacity_(AlignUp(capacity)),
+      mapping_(nullptr),
+      data_(nullptr),
+      mapped_size_(0),
+      pos_(0),
+      seq_(0) {
+  open(path);
+}
+
+MmapRingSink::~MmapRingSink() {
+  if (mapping_ != nullptr) munmap(mapping_, mapped_size_);
+}
+
+bool MmapRingSink::open(const char* path) {
+  int fd = ::open(path, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+  if (fd < 0) return false;
+  size_t size = kDataOffset + capacity_;
+  struct stat st;
+  // Allocates the blocks up front, so that running out of disk space can't
+  // kill the process with SIGBUS on a write to the mapping.
+  if (fstat(fd, &st) != 0 || posix_fallocate(fd, 0, size) != 0 ||
+      ((size_t)st.st_size > size && ftruncate(fd, size) != 0)) {
+    close(fd);
+    return false;
+  }
+  void* mem = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+  if (mem == MAP_FAILED) return false;
+  mapping_ = static_cast<uint8_t*>(mem);
+  mapped_size_ = size;
+  data_ = mapping_ + kDataOffset;
+
+  Header* header = reinterpret_cast<Header*>(mapping_);
+  if (header->magic == mmap_ring::kMagic &&
+      header->version == mmap_ring::kVersion &&
+      header->capacity == capacity_) {
+    // Continues after the newest intact record.
+    bool found = false;
+    ScanRecords(data_, capacity_, [&](size_t pos, const RecordHeader& r) {
+      if (!found || r.seq >= seq_) {
+        found = true;
+        seq_ = r.seq + 1;
+        pos_ = pos + r.size;
+      }
+    });
+  } else {
+    // New, or laid out differently; stale records would confuse the reader.
+    memset(data_, 0, capacity_);
+    header->version = mmap_ring::kVersion;
+    header->capacity = capacity_;
+    header->magic = mmap_ring::kMagic;
+  }
+  return true;
+}
+
+uint64_t MmapRingSink::next_seq() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return seq_;
+}
+
+void MmapRingSink::send(LogSeverity severity, const char* full_filename,
+                        const char* base_filename, int line,
+                        roo_time::Uptime uptime, roo_time::WallTime walltime,
+                        const char* message, size_t message_len) {
+  if (data_ == nullptr) return;
+  RecordHeader header;
+  header.magic = mmap_ring::kRecordMagic;
+  header.reserved = 0;
+  header.severity = (uint8_t)severity;
+  size_t file_len = strlen(base_filename);
+  header.file_len = (uint16_t)(file_len < 255 ? file_len : 255);
+  header.line = line;
+  header.uptime_us = uptime.inMicros();
+  header.walltime_us = walltime.sinceEpoch().inMicros();
+  size_t max_message_len = capacity_ / 4;
+  header.message_len =
+      (uint32_t)(message_len < max_message_len ? message_len : max_message_len);
+  size_t size = AlignUp(sizeof(RecordHeader) + header.file_len +
+                        header.message_len);
+  header.size = (uint32_t)size;
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  // Records never wrap. Whatever remains at the end of the data area is older
+  // than this lap, and, once the next lap overwrites the start of this one,
+  // no longer adjacent to the other records, so it is cleared (the reader
+  // would report the gap as missing records).
+  if (pos_ + size > capacity_) {
+    memset(data_ + pos_, 0, capacity_ - pos_);
+    pos_ = 0;
+  }
+  header.seq = seq_++;
+  uint8_t* record = data_ + pos_;
+  uint8_t* payload = record + sizeof(RecordHeader);
+  memcpy(payload, base_filename, header.file_len);
+  memcpy(payload + header.file_len, message, header.message_len);
+  header.checksum = RecordChecksum(header, payload);
+  memcpy(record, &header, sizeof(header));
+  pos_ += size;
+}
+
+void MmapRingSink::WaitTillSent() {
+  if (mapping_ != nullptr) msync(mapping_, mapped_size_, MS_SYNC);
+}
+
+MmapRingReader::MmapRingReader(const char* path)
+    : mapping_(nullptr), mapped_size_(0), missing_(0) {
+  int fd = ::open(path, O_RDONLY | O_CLOEXEC);
+  if (fd < 0) return;
+  struct stat st;
+  if (fstat(fd, &st) != 0 || (size_t)st.st_size < kDataOffset) {
+    close(fd);
+    return;
+  }
+  size_t size = st.st_size;
+  void* mem = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if (mem == MAP_FAILED) return;
+  const Header* header = static_cast<const Header*>(mem);
+  if (header->magic != mmap_ring::kMagic ||
+      header->version != mmap_ring::kVersion ||
+      header->capacity > size - kDataOffset) {
+    munmap(mem, size);
+    return;
+  }
+  mapping_ = static_cast<const uint8_t*>(mem);
+  mapped_size_ = size;
+  const uint8_t* data = mapping_ + kDataOffset;
+  ScanRecords(data, header->capacity, [&](size_t pos, const RecordHeader& r) {
+    const char* payload =
+        reinterpret_cast<const char*>(data + pos + sizeof(RecordHeader));
+    Record record;
+    record.seq = r.seq;
+    record.severity = r.severity;
+    record.base_filename = payload;
+    record.base_filename_len = r.file_len;
+    record.line = r.line;
+    record.uptime = roo_time::Uptime::Start() + roo_time::Micros(r.uptime_us);
+    record.walltime = roo_time::WallTime(roo_time::Micros(r.walltime_us));
+    record.message = payload + r.file_len;
+    record.message_len = r.message_len;
+    records_.push_back(record);
+  });
+  std::sort(records_.begin(), records_.end(),
+            [](const Record& a, const Record& b) { return a.seq < b.seq; });
+  for (size_t i = 1; i < records_.size(); ++i) {
+    missing_ += records_[i].seq - records_[i - 1].seq - 1;
+  }
+}
+
+MmapRingReader::~MmapRingReader() {
+  if (mapping_ != nullptr) {
+    munmap(const_cast<uint8_t*>(mapping_), mapped_size_);
+  }
+}
+
+}  // namespace roo_logging
+
+#endif  // defined(__linux__)
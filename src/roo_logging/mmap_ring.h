@@ -0,0 +1,155 @@
+#pragma once
+
+#if defined(__linux__)
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <mutex>
+#include <vector>
+
+#include "roo_logging/sink.h"
+#include "roo_time.h"
+
+namespace roo_logging {
+
+/// Crash-persistent ring log file (Linux only). MmapRingSink memory-maps a
+/// fixed-size file, and writes records into it as a circular log, overwriting
+/// the oldest ones. Writing a record is a plain memcpy into the mapping,
+/// without any system calls; the kernel writes the pages back to the file in
+/// its own time. Since the page cache outlives the process, nothing is lost
+/// when the process crashes (unlike with stdio buffers), and when the sink
+/// is flushed (e.g. before the process dies of a FATAL message), the file
+/// survives power loss, too.
+///
+/// Each record carries a sequence number and a checksum. The reader
+/// (MmapRingReader, or the mmap_ring_reader tool; see tools/) scans the whole
+/// file, keeps the records that are intact, and orders them by sequence
+/// number. Records torn by a power cut, or by a crash of the machine, fail
+/// the checksum, and are skipped, and gaps in the sequence are reported.
+namespace mmap_ring {
+
+static constexpr uint32_t kMagic = 0x52524D52;  // "RMRR"
+static constexpr uint32_t kRecordMagic = 0x434552;  // "REC"
+static constexpr uint32_t kVersion = 1;
+
+/// Offset of the data area in the file.
+static constexpr size_t kDataOffset = 64;
+
+/// Records are aligned to, and sized in multiples of, this many bytes.
+static constexpr size_t kAlignment = 8;
+
+/// The header at the start of the file.
+struct Header {
+  uint32_t magic;
+  uint32_t version;
+  uint64_t capacity;  // Size of the data area.
+};
+
+/// The header of each record. Followed by the base file name, and the
+/// message text. Records never wrap around the end of the data area; the
+/// space left at the end when the writer wraps around is zeroed.
+struct RecordHeader {
+  uint32_t magic;  // kRecordMagic.
+  uint32_t size;   // Total, including this header and alignment padding.
+  uint64_t seq;
+  // FNV-1a of the record (up to message_len), with this field set to zero.
+  uint32_t checksum;
+  uint8_t severity;
+  uint8_t reserved;
+  uint16_t file_len;
+  int32_t line;
+  uint32_t message_len;
+  int64_t uptime_us;
+  int64_t walltime_us;
+};
+
+}  // namespace mmap_ring
+
+/// A LogSink that writes to a crash-persistent ring log file. See mmap_ring
+/// above.
+class MmapRingSink : public LogSink {
+ public:
+  /// Opens the file, creating (or resizing) it if necessary, so that its data
+  /// area has the specified capacity. If the file already holds a log with
+  /// the same capacity, new records are appended after the newest intact
+  /// one, so that the log survives restarts.
+  MmapRingSink(const char* path, size_t capacity = 1024 * 1024);
+
+  /// Unmaps the file (without waiting for the write-back).
+  ~MmapRingSink();
+
+  /// Returns true if the file has been successfully mapped.
+  bool ok() const { return data_ != nullptr; }
+
+  /// Returns the sequence number that the next record will get.
+  uint64_t next_seq() const;
+
+  void send(LogSeverity severity, const char* full_filename,
+            const char* base_filename, int line, roo_time::Uptime uptime,
+            roo_time::WallTime walltime, const char* message,
+            size_t message_len) override;
+
+  /// Writes the modified pages back to the file, and waits for the write to
+  /// complete (msync), so that the log survives power loss. Called before the
+  /// process dies of a FATAL message. Not needed for surviving crashes of the
+  /// process itself.
+  void WaitTillSent() override;
+
+ private:
+  bool open(const char* path);
+
+  size_t capacity_;
+  uint8_t* mapping_;
+  uint8_t* data_;
+  size_t mapped_size_;
+
+  mutable std::mutex mutex_;
+  size_t pos_;    // Offset of the next record; guarded by mutex_.
+  uint64_t seq_;  // Guarded by mutex_.
+};
+
+/// Reads a ring log file written by MmapRingSink, typically after the writer
+/// crashed, or exited. (If the writer is still running, records that it
+/// overwrites while the reader is in use get garbled.)
+class MmapRingReader {
+ public:
+  struct Record {
+    uint64_t seq;
+    LogSeverity severity;
+    const char* base_filename;
+    size_t base_filename_len;
+    int line;
+    roo_time::Uptime uptime;
+    roo_time::WallTime walltime;
+    const char* message;
+    size_t message_len;
+  };
+
+  /// Maps the file, and scans it for intact records.
+  explicit MmapRingReader(const char* path);
+
+  ~MmapRingReader();
+
+  /// Returns true if the file exists, and holds a ring log.
+  bool ok() const { return mapping_ != nullptr; }
+
+  /// Returns the intact records, oldest first. The records point into the
+  /// mapping, which stays valid for the lifetime of the reader.
+  const std::vector<Record>& records() const { return records_; }
+
+  /// Returns the number of records missing between the oldest and the newest
+  /// intact records (e.g. torn by a power cut, or overwritten while the file
+  /// was being scanned).
+  uint64_t missing() const { return missing_; }
+
+ private:
+  const uint8_t* mapping_;
+  size_t mapped_size_;
+  std::vector<Record> records_;
+  uint64_t missing_;
+};
+
+}  // namespace roo_logging
+
+#endif  // defined(__linux__)
@@ -0,0 +1,21 @@
+#include "roo_logging/sampling.h"
+
+#include "roo_time.h"
+
+namespace roo_logging {
+namespace internal {
+
+uint32_t NewSamplingSeed(uint32_t salt) {
+  // Mixes the salt (which differs between threads) with the current time,
+  // using the murmur3 finalizer.
+  uint32_t h = salt ^ (uint32_t)roo_time::Uptime::Now().inMicros();
+  h ^= h >> 16;
+  h *= 0x85ebca6b;
+  h ^= h >> 13;
+  h *= 0xc2b2ae35;
+  h ^= h >> 16;
+  return h != 0 ? h : 0x9e3779b9;
+}
+
+}  // namespace internal
+}  // namespace roo_logging
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "roo_logging/predict.h"
+
+namespace roo_logging {
+namespace internal {
+
+// Returns a new, non-zero seed for the sampling PRNG of the calling thread.
+uint32_t NewSamplingSeed(uint32_t salt);
+
+// Converts the sampling rate to the threshold used by ShouldSample(). The
+// LOG_SAMPLED macros call it at the call site, so that a constant rate is
+// converted at compile time, and the per-call check needs no floating-point
+// arithmetic (which is emulated in software on targets without an FPU, such
+// as the RP2040). Rates <= 0 map to 0 (never sample), and rates >= 1 map to
+// UINT32_MAX (always sample).
+constexpr uint32_t SamplingThreshold(float rate) {
+  return !(rate > 0.0f)   ? 0
+         : rate >= 1.0f   ? UINT32_MAX
+                          : (uint32_t)(rate * 4294967296.0f);
+}
+
+// Returns true with the probability threshold / 2^32 (see
+// SamplingThreshold()). Uses a per-thread xorshift32 generator, so it takes
+// no locks; the cost, once the thread's generator is seeded, is a few shifts
+// and a compare.
+inline bool ShouldSample(uint32_t threshold) {
+  static thread_local uint32_t state = 0;
+  uint32_t x = state;
+  if (ROO_PREDICT_FALSE(x == 0)) {
+    x = NewSamplingSeed((uint32_t)(uintptr_t)&state);
+  }
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  state = x;
+  // x is uniform in [1, 2^32).
+  return x <= threshold;
+}
+
+}  // namespace internal
+}  // namespace roo_logging
@@ -0,0 +1,338 @@
+#if defined(__linux__)
+
+#include "roo_logging/shm_ring.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <string.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <new>
+
+namespace roo_logging {
+
+using shm_ring::Header;
+using shm_ring::kAlignment;
+using shm_ring::kDataOffset;
+using shm_ring::RecordHeader;
+
+namespace {
+
+static constexpr size_t kMinCapacity = 4096;
+
+// Messages are truncated so that each record fits in this fraction of the
+// ring, so that a single message can't starve the others.
+static constexpr size_t kMaxRecordFraction = 4;
+
+size_t AlignUp(size_t n) { return (n + kAlignment - 1) & ~(kAlignment - 1); }
+
+size_t RoundUpToPowerOf2(size_t n) {
+  size_t result = kMinCapacity;
+  while (result < n) result <<= 1;
+  return result;
+}
+
+bool ProcessAlive(pid_t pid) {
+  return pid > 0 && (kill(pid, 0) == 0 || errno == EPERM);
+}
+
+RecordHeader* RecordAt(uint8_t* data, uint64_t capacity, uint64_t pos) {
+  return reinterpret_cast<RecordHeader*>(data + (pos & (capacity - 1)));
+}
+
+// Returns the number of bytes between pos and the end of the data area, if
+// they are too few to hold a record header, and thus implicitly skipped;
+// zero otherwise.
+uint64_t ImplicitSkip(uint64_t capacity, uint64_t pos) {
+  uint64_t tail = capacity - (pos & (capacity - 1));
+  return tail < sizeof(RecordHeader) ? tail : 0;
+}
+
+// Commits [pos, pos + size) as padding. The range must not wrap.
+void WritePadding(uint8_t* data, uint64_t capacity, uint64_t pos,
+                  uint64_t size) {
+  if (size < sizeof(RecordHeader)) return;
+  RecordHeader* record = RecordAt(data, capacity, pos);
+  record->size = (uint32_t)size;
+  record->type = shm_ring::kPadding;
+  record->commit.store(pos + 1, std::memory_order_release);
+}
+
+}  // namespace
+
+ShmRingSink::ShmRingSink(const char* name, size_t capacity,
+                         OverflowPolicy policy,
+                         roo_time::Duration block_timeout)
+    : capacity_(RoundUpToPowerOf2(capacity)),
+      policy_(policy),
+      block_timeout_(block_timeout),
+      fd_(-1),
+      header_(nullptr),
+      data_(nullptr),
+      mapped_size_(kDataOffset + capacity_) {
+  if (!open(name)) {
+    if (fd_ >= 0) close(fd_);
+    fd_ = -1;
+    header_ = nullptr;
+    data_ = nullptr;
+  }
+}
+
+ShmRingSink::~ShmRingSink() {
+  if (header_ != nullptr) munmap(header_, mapped_size_);
+  if (fd_ >= 0) close(fd_);
+}
+
+bool ShmRingSink::open(const char* name) {
+  fd_ = shm_open(name, O_RDWR | O_CREAT, 0644);
+  if (fd_ < 0) return false;
+  // Records reserved, but not yet committed, by a live producer would be
+  // indistinguishable from the torn records of a dead one (see recover()),
+  // so there can only be one producer process. The lock is released by the
+  // kernel when the producer dies.
+  if (flock(fd_, LOCK_EX | LOCK_NB) != 0) return false;
+  struct stat st;
+  if (fstat(fd_, &st) != 0) return false;
+  bool reuse = false;
+  if ((size_t)st.st_size == mapped_size_) {
+    void* mem = mmap(nullptr, mapped_size_, PROT_READ | PROT_WRITE,
+                     MAP_SHARED, fd_, 0);
+    if (mem == MAP_FAILED) return false;
+    header_ = static_cast<Header*>(mem);
+    reuse = header_->magic.load(std::memory_order_acquire) ==
+                shm_ring::kMagic &&
+            header_->version == shm_ring::kVersion &&
+            header_->capacity == capacity_;
+    if (!reuse) {
+      munmap(mem, mapped_size_);
+      header_ = nullptr;
+    }
+  }
+  if (!reuse) {
+    if (st.st_size != 0) {
+      // Incompatible; replace it with a new object. A reader that still has
+      // the old one open will notice (see ShmRingReader::replaced()).
+      close(fd_);
+      shm_unlink(name);
+      fd_ = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0644);
+      if (fd_ < 0) return false;
+      if (flock(fd_, LOCK_EX | LOCK_NB) != 0) return false;
+    }
+    if (ftruncate(fd_, mapped_size_) != 0) return false;
+    void* mem = mmap(nullptr, mapped_size_, PROT_READ | PROT_WRITE,
+                     MAP_SHARED, fd_, 0);
+    if (mem == MAP_FAILED) return false;
+    // The new object is zero-filled.
+    header_ = new (mem) Header();
+    header_->version = shm_ring::kVersion;
+    header_->capacity = capacity_;
+  }
+  data_ = reinterpret_cast<uint8_t*>(header_) + kDataOffset;
+  // Holding the lock, we are the only producer; anything in flight belongs
+  // to a previous one, which is gone.
+  if (reuse) recover();
+  header_->producer_pid.store(getpid(), std::memory_order_relaxed);
+  header_->magic.store(shm_ring::kMagic, std::memory_order_release);
+  return true;
+}
+
+void ShmRingSink::recover() {
+  // Walks the records not yet consumed. The first uncommitted one, if any,
+  // was torn by the death of the previous producer; since its size can't be
+  // trusted, everything from there on is replaced by padding.
+  uint64_t end = header_->write_pos.load(std::memory_order_acquire);
+  uint64_t pos = header_->read_pos.load(std::memory_order_acquire);
+  while (pos < end) {
+    uint64_t skip = ImplicitSkip(capacity_, pos);
+    if (skip > 0) {
+      pos += skip;
+      continue;
+    }
+    RecordHeader* record = RecordAt(data_, capacity_, pos);
+    if (record->commit.load(std::memory_order_acquire) == pos + 1) {
+      pos += record->size;
+      continue;
+    }
+    uint64_t tail = capacity_ - (pos & (capacity_ - 1));
+    if (end - pos > tail) {
+      WritePadding(data_, capacity_, pos, tail);
+      pos += tail;
+    }
+    WritePadding(data_, capacity_, pos, end - pos);
+    header_->dropped.fetch_add(1, std::memory_order_relaxed);
+    break;
+  }
+}
+
+uint64_t ShmRingSink::dropped() const {
+  if (header_ == nullptr) return 0;
+  return header_->dropped.load(std::memory_order_relaxed);
+}
+
+bool ShmRingSink::reserve(size_t size, uint64_t& pos) {
+  roo_time::Uptime deadline;
+  bool waiting = false;
+  pos = header_->write_pos.load(std::memory_order_relaxed);
+  while (true) {
+    uint64_t tail = capacity_ - (pos & (capacity_ - 1));
+    uint64_t total = (tail < size ? tail : 0) + size;
+    uint64_t read_pos = header_->read_pos.load(std::memory_order_acquire);
+    if (pos + total - read_pos > capacity_) {
+      if (policy_ == kDropNewest) return false;
+      if (!waiting) {
+        deadline = roo_time::Uptime::Now() + block_timeout_;
+        waiting = true;
+      } else if (roo_time::Uptime::Now() >= deadline) {
+        return false;
+      }
+      usleep(100);
+      pos = header_->write_pos.load(std::memory_order_relaxed);
+      continue;
+    }
+    if (header_->write_pos.compare_exchange_weak(pos, pos + total,
+                                                 std::memory_order_relaxed)) {
+      if (tail < size) {
+        WritePadding(data_, capacity_, pos, tail);
+        pos += tail;
+      }
+      return true;
+    }
+  }
+}
+
+void ShmRingSink::send(LogSeverity severity, const char* full_filename,
+                       const char* base_filename, int line,
+                       roo_time::Uptime uptime, roo_time::WallTime walltime,
+                       const char* message, size_t message_len) {
+  if (header_ == nullptr) return;
+  size_t file_len = strlen(base_filename);
+  if (file_len > 255) file_len = 255;
+  size_t max_size = capacity_ / kMaxRecordFraction;
+  size_t size = AlignUp(sizeof(RecordHeader) + file_len + message_len);
+  if (size > max_size) {
+    message_len -= (size - max_size);
+    size = max_size;
+  }
+  uint64_t pos;
+  if (!reserve(size, pos)) {
+    header_->dropped.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+  RecordHeader* record = RecordAt(data_, capacity_, pos);
+  record->size = (uint32_t)size;
+  record->type = shm_ring::kMessage;
+  record->severity = (uint8_t)severity;
+  record->file_len = (uint16_t)file_len;
+  record->line = line;
+  record->message_len = (uint32_t)message_len;
+  record->uptime_us = uptime.inMicros();
+  record->walltime_us = walltime.sinceEpoch().inMicros();
+  char* payload = reinterpret_cast<char*>(record + 1);
+  memcpy(payload, base_filename, file_len);
+  memcpy(payload + file_len, message, message_len);
+  record->commit.store(pos + 1, std::memory_order_release);
+}
+
+ShmRingReader::ShmRingReader(const char* name)
+    : name_(name),
+      header_(nullptr),
+      data_(nullptr),
+      mapped_size_(0),
+      capacity_(0),
+      inode_(0),
+      pos_(0) {
+  int fd = shm_open(name, O_RDWR, 0);
+  if (fd < 0) return;
+  struct stat st;
+  if (fstat(fd, &st) != 0 || (size_t)st.st_size < kDataOffset) {
+    close(fd);
+    return;
+  }
+  void* mem = mmap(nullptr, st.st_size, PROT_READ | PROT_WRITE, MAP_SHARED,
+                   fd, 0);
+  close(fd);
+  if (mem == MAP_FAILED) return;
+  Header* header = static_cast<Header*>(mem);
+  if (header->magic.load(std::memory_order_acquire) != shm_ring::kMagic ||
+      header->version != shm_ring::kVersion ||
+      kDataOffset + header->capacity != (size_t)st.st_size) {
+    munmap(mem, st.st_size);
+    return;
+  }
+  header_ = header;
+  data_ = static_cast<uint8_t*>(mem) + kDataOffset;
+  mapped_size_ = st.st_size;
+  capacity_ = header->capacity;
+  inode_ = st.st_ino;
+  pos_ = header->read_pos.load(std::memory_order_relaxed);
+}
+
+ShmRingReader::~ShmRingReader() {
+  if (header_ == nullptr) return;
+  header_->read_pos.store(pos_, std::memory_order_release);
+  munmap(header_, mapped_size_);
+}
+
+bool ShmRingReader::next(Record& record) {
+  if (header_ == nullptr) return false;
+  // Releases the previously returned record to the producers.
+  header_->read_pos.store(pos_, std::memory_order_release);
+  uint64_t end = header_->write_pos.load(std::memory_order_acquire);
+  while (pos_ < end) {
+    uint64_t skip = ImplicitSkip(capacity_, pos_);
+    if (skip > 0) {
+      pos_ += skip;
+      continue;
+    }
+    RecordHeader* r = RecordAt(data_, capacity_, pos_);
+    if (r->commit.load(std::memory_order_acquire) != pos_ + 1) {
+      // Not yet complete.
+      return false;
+    }
+    pos_ += r->size;
+    if (r->type != shm_ring::kMessage) continue;
+    const char* payload = reinterpret_cast<const char*>(r + 1);
+    record.severity = r->severity;
+    record.base_filename = payload;
+    record.base_filename_len = r->file_len;
+    record.line = r->line;
+    record.uptime = roo_time::Uptime::Start() + roo_time::Micros(r->uptime_us);
+    record.walltime = roo_time::WallTime(roo_time::Micros(r->walltime_us));
+    record.message = payload + r->file_len;
+    record.message_len = r->message_len;
+    return true;
+  }
+  return false;
+}
+
+uint64_t ShmRingReader::dropped() const {
+  if (header_ == nullptr) return 0;
+  return header_->dropped.load(std::memory_order_relaxed);
+}
+
+uint64_t ShmRingReader::pending() const {
+  if (header_ == nullptr) return 0;
+  return header_->write_pos.load(std::memory_order_acquire) - pos_;
+}
+
+bool ShmRingReader::producer_alive() const {
+  if (header_ == nullptr) return false;
+  return ProcessAlive(header_->producer_pid.load(std::memory_order_relaxed));
+}
+
+bool ShmRingReader::replaced() const {
+  int fd = shm_open(name_, O_RDONLY, 0);
+  if (fd < 0) return false;
+  struct stat st;
+  bool result = fstat(fd, &st) == 0 && st.st_ino != inode_;
+  close(fd);
+  return result;
+}
+
+}  // namespace roo_logging
+
+#endif  // defined(__linux__)
@@ -0,0 +1,195 @@
+#pragma once
+
+#if defined(__linux__)
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+#include <atomic>
+
+#include "roo_logging/sink.h"
+#include "roo_time.h"
+
+namespace roo_logging {
+
+/// Shared-memory log ring (Linux only). ShmRingSink writes log records into a
+/// POSIX shared memory object (shm_open + mmap); a separate process, typically
+/// the shm_log_consumer tool (see tools/), drains it using ShmRingReader. Log
+/// emission is thus fully decoupled from I/O. Since the shared memory outlives
+/// the producer, the consumer still reads everything that was committed
+/// before the producer crashed.
+///
+/// There is a single producer process: the one that has the ring open with
+/// ShmRingSink, which holds an exclusive lock (flock) on the shared memory
+/// object while open, so that a second one fails to open the ring. Its
+/// threads reserve space with a CAS on the write position, so they never
+/// take a lock. There is one consumer, which only ever moves the read
+/// position. Records are committed by stamping them with their own position,
+/// so stale bytes from previous laps never look committed, and the consumer
+/// does not need to clear the memory it has read.
+namespace shm_ring {
+
+static constexpr uint32_t kMagic = 0x524F4F4C;  // "ROOL"
+static constexpr uint32_t kVersion = 1;
+
+/// Offset of the data area in the shared memory object.
+static constexpr size_t kDataOffset = 128;
+
+/// Records are aligned to, and sized in multiples of, this many bytes.
+static constexpr size_t kAlignment = 8;
+
+/// The header at the start of the shared memory object.
+struct Header {
+  std::atomic<uint32_t> magic;  // Set to kMagic once initialized.
+  uint32_t version;
+  uint64_t capacity;  // Size of the data area; a power of 2.
+
+  // Monotonic byte positions. The offset in the data area is
+  // position & (capacity - 1).
+  std::atomic<uint64_t> write_pos;  // Reserved by producers.
+  std::atomic<uint64_t> read_pos;   // Consumed by the consumer.
+
+  // Number of records that producers dropped, because the ring was full.
+  std::atomic<uint64_t> dropped;
+
+  // Pid of the producer process (or the most recent one, if it exited).
+  std::atomic<int32_t> producer_pid;
+};
+
+static_assert(sizeof(Header) <= kDataOffset, "Header too large");
+static_assert(ATOMIC_LLONG_LOCK_FREE == 2,
+              "64-bit atomics must be lock-free to be used in shared memory");
+
+enum RecordType : uint8_t { kPadding = 0, kMessage = 1 };
+
+/// The header of each record in the data area. Followed by the base file
+/// name, and the message text. Records never wrap around the end of the data
+/// area; the producer skips the tail with a padding record (or, if the tail
+/// is too short to hold a record header, implicitly).
+struct RecordHeader {
+  // Position of this record + 1, stored (with release semantics) once the
+  // record is complete.
+  std::atomic<uint64_t> commit;
+  uint32_t size;  // Total, including this header and alignment padding.
+  uint8_t type;
+  uint8_t severity;
+  uint16_t file_len;
+  int32_t line;
+  uint32_t message_len;
+  int64_t uptime_us;
+  int64_t walltime_us;
+};
+
+}  // namespace shm_ring
+
+/// A LogSink that writes to a shared-memory ring. See shm_ring above.
+class ShmRingSink : public LogSink {
+ public:
+  /// What to do when the ring is full.
+  enum OverflowPolicy {
+    /// Drop the new record, and increment the drop counter.
+    kDropNewest,
+
+    /// Wait (up to block_timeout) for the consumer to make room; then drop.
+    kBlock,
+  };
+
+  /// Opens the shared memory object with the specified name (e.g.
+  /// "/myapp_log"), creating it if necessary. The capacity is rounded up to a
+  /// power of 2. If the object exists and has the same capacity, it is reused,
+  /// so that records not yet read by the consumer are preserved across
+  /// restarts; if the previous producer died, records that it had in flight
+  /// are discarded (and counted as dropped). Fails (see ok()) if another
+  /// ShmRingSink, in this or another process, has the ring open.
+  ShmRingSink(const char* name, size_t capacity = 256 * 1024,
+              OverflowPolicy policy = kDropNewest,
+              roo_time::Duration block_timeout = roo_time::Millis(100));
+
+  /// Unmaps the ring, and releases it to other producers. Does not remove
+  /// the shared memory object, since the consumer may still be reading from
+  /// it.
+  ~ShmRingSink();
+
+  /// Returns true if the ring has been successfully opened.
+  bool ok() const { return header_ != nullptr; }
+
+  /// Returns the number of records dropped so far (by all producers).
+  uint64_t dropped() const;
+
+  void send(LogSeverity severity, const char* full_filename,
+            const char* base_filename, int line, roo_time::Uptime uptime,
+            roo_time::WallTime walltime, const char* message,
+            size_t message_len) override;
+
+ private:
+  bool open(const char* name);
+  void recover();
+  bool reserve(size_t size, uint64_t& pos);
+
+  size_t capacity_;
+  OverflowPolicy policy_;
+  roo_time::Duration block_timeout_;
+  int fd_;  // Holds the producer lock.
+  shm_ring::Header* header_;
+  uint8_t* data_;
+  size_t mapped_size_;
+};
+
+/// Reads records from a shared-memory ring written by ShmRingSink. There must
+/// be at most one reader per ring.
+class ShmRingReader {
+ public:
+  struct Record {
+    LogSeverity severity;
+    const char* base_filename;
+    size_t base_filename_len;
+    int line;
+    roo_time::Uptime uptime;
+    roo_time::WallTime walltime;  // The epoch if the producer had no clock.
+    const char* message;
+    size_t message_len;
+  };
+
+  /// Opens the shared memory object with the specified name, which must
+  /// outlive the reader. Fails (see ok()) if the object does not exist yet,
+  /// or if it has not been initialized.
+  explicit ShmRingReader(const char* name);
+
+  ~ShmRingReader();
+
+  bool ok() const { return header_ != nullptr; }
+
+  /// Reads the next committed record, and returns true; or returns false if
+  /// there is none (yet). The record remains valid until the next call.
+  bool next(Record& record);
+
+  /// Returns the number of records dropped by producers.
+  uint64_t dropped() const;
+
+  /// Returns the number of bytes reserved by producers, but not yet read.
+  /// When the producer is gone, non-zero means that its last records have
+  /// been torn by the crash.
+  uint64_t pending() const;
+
+  /// Returns true if the producer process (or the most recent one) is alive.
+  bool producer_alive() const;
+
+  /// Returns true if the name now refers to a different shared memory object
+  /// than the one this reader has open (e.g. because a producer re-created it
+  /// with a different capacity). The reader should then be re-opened.
+  bool replaced() const;
+
+ private:
+  const char* name_;
+  shm_ring::Header* header_;
+  uint8_t* data_;
+  size_t mapped_size_;
+  uint64_t capacity_;
+  ino_t inode_;
+  uint64_t pos_;  // Consumed up to here; published to the header lazily.
+};
+
+}  // namespace roo_logging
+
+#endif  // defined(__linux__)
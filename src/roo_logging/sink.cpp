@@ -1,19 +1,166 @@
 #include "roo_logging/sink.h"
 
+#include "roo_logging/config.h"
+#include "roo_logging/early_log.h"
+#include "roo_logging/stderr.h"
+#include "roo_logging/stream.h"
+#include "roo_threads.h"
+#include "roo_threads/mutex.h"
+
 namespace roo_logging {
 
+// Defined in log_message.cpp.
+roo::mutex& log_mutex();
+
 LogSink* sink_ = nullptr;
 
-void SetSink(LogSink* sink) { sink_ = sink; }
+namespace {
+
+// The slow-sink watchdog. Guarded by the log mutex.
+struct SinkWatchdog {
+  // Consecutive sends over the latency budget.
+  uint8_t slow_in_row;
+  // When tripped, the time of the next probe, and the current retry interval.
+  roo_time::Uptime retry_at;
+  roo_time::Duration backoff;
+  // Messages dropped since the last trip.
+  uint64_t unreported_drops;
+  SinkHealth health;
+};
 
-void MaybeLogToSink(LogSeverity severity, const char* full_filename,
-                    const char* base_filename, int line,
-                    roo_time::Uptime uptime, roo_time::WallTime walltime,
-                    const char* message, size_t message_len) {
+SinkWatchdog watchdog;
+
+// Writes a watchdog diagnostic to stderr, and optionally to the sink.
+void EmitDiagnostic(LogSeverity severity, int line, const char* text,
+                    bool to_sink) {
+  ConfigRef config;
+  roo_time::Uptime uptime = roo_time::Uptime::Now();
+  roo_time::WallTimeClock* clock = config->wall_time_clock;
+  roo_time::WallTime walltime =
+      clock == nullptr ? roo_time::WallTime() : clock->now();
+  char buf[200];
+  Stream s(buf, sizeof(buf) - 1);
+  if (config->prefix) {
+    s << LogSeverityNames[severity][0];
+    if (clock == nullptr) {
+      s << uptime;
+    } else {
+      s << roo_time::DateTime(walltime, config->timezone);
+    }
+    s << " sink.cpp:" << line << "] ";
+  }
+  size_t prefix_len = s.pcount();
+  s << text;
+  size_t len = s.pcount();
+  buf[len++] = '\n';
+  buf[len] = '\0';
+  MaybeLogToStderr(*config, severity, buf, len, false);
+  if (to_sink) {
+    sink_->sendRecord(LogRecord{0, severity, __FILE__, "sink.cpp", line,
+                                uptime, walltime, buf + prefix_len,
+                                len - prefix_len - 1, LogFields()});
+  }
+}
+
+// Updates the watchdog after a send that took the specified time.
+void CheckLatency(roo_time::Duration latency, roo_time::Duration budget) {
+  if (latency > watchdog.health.max_latency) {
+    watchdog.health.max_latency = latency;
+  }
+  bool slow = latency > budget;
+  if (watchdog.health.tripped) {
+    // The send was a probe.
+    if (slow) {
+      roo_time::Duration max_backoff =
+          roo_time::Millis(GET_ROO_FLAG(roo_logging_sink_retry_ms) * 64LL);
+      watchdog.backoff = watchdog.backoff + watchdog.backoff;
+      if (watchdog.backoff > max_backoff) watchdog.backoff = max_backoff;
+      watchdog.retry_at = roo_time::Uptime::Now() + watchdog.backoff;
+      return;
+    }
+    watchdog.health.tripped = false;
+    watchdog.slow_in_row = 0;
+    char text[80];
+    Stream s(text, sizeof(text) - 1);
+    s << "Log sink recovered; " << (unsigned long long)watchdog.unreported_drops
+      << " messages dropped";
+    text[s.pcount()] = '\0';
+    EmitDiagnostic(ROO_LOGGING_WARNING, __LINE__, text, true);
+    return;
+  }
+  if (!slow) {
+    watchdog.slow_in_row = 0;
+    return;
+  }
+  if (++watchdog.slow_in_row < GET_ROO_FLAG(roo_logging_sink_trip_count)) {
+    return;
+  }
+  watchdog.health.tripped = true;
+  ++watchdog.health.trips;
+  watchdog.unreported_drops = 0;
+  watchdog.backoff = roo_time::Millis(GET_ROO_FLAG(roo_logging_sink_retry_ms));
+  watchdog.retry_at = roo_time::Uptime::Now() + watchdog.backoff;
+  char text[120];
+  Stream s(text, sizeof(text) - 1);
+  s << "Log sink stalled (last send took "
+    << (unsigned long long)latency.inMillis() << " ms); dropping messages";
+  text[s.pcount()] = '\0';
+  EmitDiagnostic(ROO_LOGGING_WARNING, __LINE__, text, false);
+}
+
+}  // namespace
+
+void SetSink(LogSink* sink) {
+  roo::lock_guard<roo::mutex> l{log_mutex()};
+  sink_ = sink;
+  watchdog = SinkWatchdog();
+  if (sink != nullptr) ReplayEarlyMessages(sink);
+}
+
+void LogSink::sendRecord(const LogRecord& record) {
+  // The text rendering of the fields directly follows the message.
+  send(record.severity, record.full_filename, record.base_filename,
+       record.line, record.uptime, record.walltime, record.message,
+       record.message_len + record.fields.text_size());
+}
+
+void MaybeLogToSink(const ConfigSnapshot& config, const LogRecord& record) {
   if (sink_ != nullptr) {
-    sink_->send(severity, full_filename, base_filename, line, uptime, walltime,
-                message, message_len);
+    uint32_t budget_ms = config.sink_latency_budget_ms;
+    if (budget_ms == 0) {
+      sink_->sendRecord(record);
+      return;
+    }
+    roo_time::Uptime start = roo_time::Uptime::Now();
+    if (watchdog.health.tripped && start < watchdog.retry_at) {
+      if (record.severity < ROO_LOGGING_ERROR) {
+        ++watchdog.health.dropped;
+        ++watchdog.unreported_drops;
+        return;
+      }
+      // Errors always go to the sink, but are not probes.
+      sink_->sendRecord(record);
+      roo_time::Duration latency = roo_time::Uptime::Now() - start;
+      if (latency > watchdog.health.max_latency) {
+        watchdog.health.max_latency = latency;
+      }
+      return;
+    }
+    sink_->sendRecord(record);
+    CheckLatency(roo_time::Uptime::Now() - start,
+                 roo_time::Millis(budget_ms));
+  } else {
+    CaptureEarlyMessage(record.sequence, record.severity,
+                        record.full_filename, record.base_filename,
+                        record.line, record.uptime, record.walltime,
+                        record.message,
+                        record.message_len + record.fields.text_size());
   }
 }
 
+SinkHealth GetSinkHealth() {
+  roo::lock_guard<roo::mutex> l{log_mutex()};
+  return watchdog.health;
+}
+
 };  // namespace roo_logging
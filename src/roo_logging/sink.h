@@ -1,9 +1,38 @@
 #pragma once
 
 #include "roo_logging.h"
+#include "roo_logging/fields.h"
 
 namespace roo_logging {
 
+/// A log message, as passed to LogSink::sendRecord(). The pointers are only
+/// valid for the duration of the call.
+struct LogRecord {
+  /// The global sequence number of the message (see LogMessage::sequence()).
+  /// It reflects the order in which messages were created, which may differ
+  /// from the order in which they are sent, when several threads log. It is
+  /// zero for messages generated by the library itself (e.g. summaries of
+  /// repeated messages).
+  uint64_t sequence;
+
+  LogSeverity severity;
+  const char* full_filename;
+  const char* base_filename;
+  int line;
+  roo_time::Uptime uptime;
+  roo_time::WallTime walltime;  // The epoch if there is no wall time clock.
+
+  /// The message text, excluding '\n' at the end, and excluding the
+  /// rendering of the structured fields (key=value), which directly follows
+  /// it (see LogFields::text_size()).
+  const char* message;
+  size_t message_len;
+
+  /// Zero-copy access to the typed values of the structured fields (see
+  /// Stream::kv(), and roo_logging/encoders.h for JSON and logfmt encoders).
+  LogFields fields;
+};
+
 /// Used to send logs to some other kind of destination
 /// Users should subclass LogSink and override send to do whatever they want.
 class LogSink {
@@ -17,6 +46,15 @@ class LogSink {
                     roo_time::Uptime uptime, roo_time::WallTime walltime,
                     const char* message, size_t message_len) = 0;
 
+  /// Called for every message, with everything that is known about it,
+  /// including the structured fields and the sequence number. Override it
+  /// instead of send() to get these. Like send(), this method can't use
+  /// LOG() or CHECK().
+  ///
+  /// The default implementation calls send(), with the text rendering of the
+  /// fields included in the message.
+  virtual void sendRecord(const LogRecord& record);
+
   /// Redefine this to implement waiting for
   /// the sink's logging logic to complete.
   /// It will be called after each send() returns,
@@ -29,9 +67,28 @@ extern LogSink* sink_;
 
 void SetSink(LogSink* sink);
 
-void MaybeLogToSink(LogSeverity severity, const char* full_filename,
-                    const char* base_filename, int line,
-                    roo_time::Uptime uptime, roo_time::WallTime walltime,
-                    const char* message, size_t message_len);
+/// Statistics of the slow-sink watchdog (see the
+/// roo_logging_sink_latency_budget_ms flag), since the sink was set.
+///
+/// The watchdog catches slow sinks, not hung ones. The sink is called, and
+/// timed, under the logging mutex, so the watchdog can only act after a send
+/// returns; a send that never returns blocks every thread that logs. If the
+/// sink can hang (e.g. on a socket without a timeout), wrap it in AsyncSink,
+/// so that the sink is called from the writer thread, and the logging threads
+/// never wait for it.
+struct SinkHealth {
+  // Whether the sink is currently considered stalled.
+  bool tripped;
+  // Number of times the sink was found stalled.
+  uint32_t trips;
+  // Number of messages not sent to the sink, because it was stalled.
+  uint64_t dropped;
+  // The longest time that a single send took.
+  roo_time::Duration max_latency;
+};
+
+SinkHealth GetSinkHealth();
+
+void MaybeLogToSink(const ConfigSnapshot& config, const LogRecord& record);
 
 }  // namespace roo_logging
\ No newline at end of file
@@ -0,0 +1,251 @@
+#if defined(__linux__)
+
+#include "roo_logging/socket_sink.h"
+
+#include <errno.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <chrono>
+
+namespace roo_logging {
+
+namespace socket_batch {
+
+void AppendFrame(std::vector<uint8_t>& out, const Frame& frame) {
+  FrameHeader header;
+  memset(&header, 0, sizeof(header));
+  header.size =
+      (uint32_t)FrameSize(frame.base_filename_len, frame.message_len);
+  header.severity = (uint8_t)frame.severity;
+  header.file_len = (uint16_t)frame.base_filename_len;
+  header.line = frame.line;
+  header.uptime_us = frame.uptime.inMicros();
+  header.walltime_us = frame.walltime.sinceEpoch().inMicros();
+  const uint8_t* h = reinterpret_cast<const uint8_t*>(&header);
+  out.insert(out.end(), h, h + sizeof(header));
+  const uint8_t* file = reinterpret_cast<const uint8_t*>(frame.base_filename);
+  out.insert(out.end(), file, file + frame.base_filename_len);
+  const uint8_t* message = reinterpret_cast<const uint8_t*>(frame.message);
+  out.insert(out.end(), message, message + frame.message_len);
+}
+
+bool DecodeBatch(const uint8_t* data, size_t len, BatchHeader& header,
+                 std::vector<Frame>& frames) {
+  frames.clear();
+  if (len < sizeof(BatchHeader)) return false;
+  memcpy(&header, data, sizeof(header));
+  if (header.magic != kMagic) return false;
+  size_t pos = sizeof(BatchHeader);
+  while (pos < len) {
+    if (len - pos < sizeof(FrameHeader)) return false;
+    FrameHeader fh;
+    memcpy(&fh, data + pos, sizeof(fh));
+    if (fh.size < sizeof(FrameHeader) || fh.size > len - pos ||
+        fh.file_len > fh.size - sizeof(FrameHeader)) {
+      return false;
+    }
+    const char* payload = reinterpret_cast<const char*>(data + pos) +
+                          sizeof(FrameHeader);
+    Frame frame;
+    frame.severity = fh.severity;
+    frame.base_filename = payload;
+    frame.base_filename_len = fh.file_len;
+    frame.line = fh.line;
+    frame.uptime = roo_time::Uptime::Start() + roo_time::Micros(fh.uptime_us);
+    frame.walltime = roo_time::WallTime(roo_time::Micros(fh.walltime_us));
+    frame.message = payload + fh.file_len;
+    frame.message_len = fh.size - sizeof(FrameHeader) - fh.file_len;
+    frames.push_back(frame);
+    pos += fh.size;
+  }
+  return true;
+}
+
+}  // namespace socket_batch
+
+namespace {
+
+// How long the sender retries a datagram that the aggregator can't take yet,
+// before dropping it.
+static constexpr int kSendRetries = 100;
+static constexpr useconds_t kSendRetryDelayUs = 1000;
+
+roo_time::WallTime RealTimeNow() {
+  timespec ts;
+  clock_gettime(CLOCK_REALTIME, &ts);
+  return roo_time::WallTime(
+      roo_time::Micros((int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000));
+}
+
+static_assert(SocketSink::kMinBatch >
+                  sizeof(socket_batch::BatchHeader) +
+                      socket_batch::FrameSize(255, 0),
+              "kMinBatch leaves no room for the message");
+
+}  // namespace
+
+constexpr size_t SocketSink::kMinBatch;
+
+SocketSink::SocketSink(const char* socket_path, size_t queue_capacity,
+                       size_t max_batch, roo_time::Duration flush_interval)
+    : fd_(socket(AF_UNIX, SOCK_DGRAM | SOCK_CLOEXEC, 0)),
+      socket_path_(socket_path, socket_path + strlen(socket_path) + 1),
+      queue_capacity_(queue_capacity),
+      max_batch_(max_batch < kMinBatch ? kMinBatch : max_batch),
+      flush_interval_(flush_interval),
+      queued_count_(0),
+      done_count_(0),
+      flush_requested_(false),
+      stopping_(false),
+      dropped_(0),
+      batches_sent_(0) {
+  if (fd_ < 0) return;
+  queue_.reserve(queue_capacity_);
+  thread_ = std::thread(&SocketSink::run, this);
+}
+
+SocketSink::~SocketSink() {
+  if (fd_ < 0) return;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopping_ = true;
+  }
+  wakeup_.notify_one();
+  thread_.join();
+  close(fd_);
+}
+
+void SocketSink::send(LogSeverity severity, const char* full_filename,
+                      const char* base_filename, int line,
+                      roo_time::Uptime uptime, roo_time::WallTime walltime,
+                      const char* message, size_t message_len) {
+  if (fd_ < 0) return;
+  socket_batch::Frame frame;
+  frame.severity = severity;
+  frame.base_filename = base_filename;
+  frame.base_filename_len = strlen(base_filename);
+  if (frame.base_filename_len > 255) frame.base_filename_len = 255;
+  frame.line = line;
+  frame.uptime = uptime;
+  frame.walltime =
+      (walltime == roo_time::WallTime()) ? RealTimeNow() : walltime;
+  frame.message = message;
+  frame.message_len = message_len;
+  // Each frame must fit in a single batch.
+  size_t max_frame = max_batch_ - sizeof(socket_batch::BatchHeader);
+  size_t size = socket_batch::FrameSize(frame.base_filename_len, message_len);
+  if (size > max_frame) {
+    frame.message_len -= (size - max_frame);
+    size = max_frame;
+  }
+  bool wake;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (queue_.size() + size > queue_capacity_) {
+      dropped_.fetch_add(1, std::memory_order_relaxed);
+      return;
+    }
+    socket_batch::AppendFrame(queue_, frame);
+    ++queued_count_;
+    wake = queue_.size() >= max_batch_ / 2;
+  }
+  if (wake) wakeup_.notify_one();
+}
+
+void SocketSink::WaitTillSent() {
+  if (fd_ < 0) return;
+  std::unique_lock<std::mutex> lock(mutex_);
+  uint64_t target = queued_count_;
+  flush_requested_ = true;
+  wakeup_.notify_one();
+  sent_.wait_for(lock, std::chrono::seconds(1),
+                 [&] { return done_count_ >= target; });
+}
+
+void SocketSink::run() {
+  std::vector<uint8_t> sending;
+  sending.reserve(queue_capacity_);
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (true) {
+    wakeup_.wait_for(
+        lock, std::chrono::microseconds(flush_interval_.inMicros()), [&] {
+          return stopping_ || flush_requested_ ||
+                 queue_.size() >= max_batch_ / 2;
+        });
+    bool stop = stopping_;
+    flush_requested_ = false;
+    sending.swap(queue_);
+    uint64_t count = queued_count_ - done_count_;
+    lock.unlock();
+    if (!sending.empty()) sendBatches(sending);
+    sending.clear();
+    lock.lock();
+    done_count_ += count;
+    sent_.notify_all();
+    if (stop && queue_.empty()) break;
+  }
+}
+
+void SocketSink::sendBatches(const std::vector<uint8_t>& frames) {
+  sockaddr_un addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  strncpy(addr.sun_path, socket_path_.data(), sizeof(addr.sun_path) - 1);
+
+  size_t pos = 0;
+  while (pos < frames.size()) {
+    // Collects as many whole frames as fit in a batch.
+    size_t end = pos;
+    uint64_t count = 0;
+    size_t limit = max_batch_ - sizeof(socket_batch::BatchHeader);
+    while (end < frames.size()) {
+      uint32_t size;
+      memcpy(&size, frames.data() + end, sizeof(size));
+      if (end + size - pos > limit) break;
+      end += size;
+      ++count;
+    }
+    socket_batch::BatchHeader header;
+    header.magic = socket_batch::kMagic;
+    header.pid = (uint32_t)getpid();
+    header.dropped = dropped_.load(std::memory_order_relaxed);
+    iovec iov[2];
+    iov[0].iov_base = &header;
+    iov[0].iov_len = sizeof(header);
+    iov[1].iov_base = const_cast<uint8_t*>(frames.data() + pos);
+    iov[1].iov_len = end - pos;
+    msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_name = &addr;
+    msg.msg_namelen = sizeof(addr);
+    msg.msg_iov = iov;
+    msg.msg_iovlen = 2;
+    bool sent = false;
+    for (int attempt = 0; attempt < kSendRetries; ++attempt) {
+      if (sendmsg(fd_, &msg, MSG_DONTWAIT | MSG_NOSIGNAL) >= 0) {
+        sent = true;
+        break;
+      }
+      if (errno != EAGAIN && errno != EWOULDBLOCK && errno != ENOBUFS &&
+          errno != EINTR) {
+        // E.g. no aggregator listening.
+        break;
+      }
+      usleep(kSendRetryDelayUs);
+    }
+    if (sent) {
+      batches_sent_.fetch_add(1, std::memory_order_relaxed);
+    } else {
+      dropped_.fetch_add(count, std::memory_order_relaxed);
+    }
+    pos = end;
+  }
+}
+
+}  // namespace roo_logging
+
+#endif  // defined(__linux__)
@@ -0,0 +1,148 @@
+#pragma once
+
+#if defined(__linux__)
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "roo_logging/sink.h"
+#include "roo_time.h"
+
+namespace roo_logging {
+
+/// Batch format used by SocketSink. Each datagram carries one batch: a
+/// BatchHeader, followed by frames, each consisting of a FrameHeader, the base
+/// file name, and the message. Integers are in the host byte order, since
+/// both ends are on the same machine.
+namespace socket_batch {
+
+static constexpr uint32_t kMagic = 0x31424C52;  // "RLB1"
+
+struct BatchHeader {
+  uint32_t magic;
+  uint32_t pid;
+  // Total number of records dropped by the sender so far.
+  uint64_t dropped;
+};
+
+struct FrameHeader {
+  uint32_t size;  // Total, including this header.
+  uint8_t severity;
+  uint8_t reserved;
+  uint16_t file_len;
+  int32_t line;
+  int32_t reserved2;
+  int64_t uptime_us;
+  int64_t walltime_us;
+};
+
+/// A decoded frame. Points into the batch it was decoded from.
+struct Frame {
+  LogSeverity severity;
+  const char* base_filename;
+  size_t base_filename_len;
+  int line;
+  roo_time::Uptime uptime;
+  roo_time::WallTime walltime;
+  const char* message;
+  size_t message_len;
+};
+
+/// Returns the encoded size of a frame with the specified payload lengths.
+constexpr size_t FrameSize(size_t file_len, size_t message_len) {
+  return sizeof(FrameHeader) + file_len + message_len;
+}
+
+/// Appends the encoded frame to the specified buffer.
+void AppendFrame(std::vector<uint8_t>& out, const Frame& frame);
+
+/// Decodes a batch. Returns false if it is malformed.
+bool DecodeBatch(const uint8_t* data, size_t len, BatchHeader& header,
+                 std::vector<Frame>& frames);
+
+}  // namespace socket_batch
+
+/// A LogSink (Linux only) that ships records, in batches, over a Unix
+/// datagram socket, to a local aggregator, such as the log_aggregator tool
+/// (see tools/), which merges records from many processes into a single file.
+///
+/// send() only appends the encoded record to a bounded in-memory queue; a
+/// background thread sends the queue contents in datagrams of up to
+/// max_batch bytes, when the queue reaches half of max_batch, or every
+/// flush_interval. The producer never waits for I/O: if the queue is full
+/// (e.g. the aggregator is slow, or not running), records are dropped and
+/// counted, and the count is reported to the aggregator.
+///
+/// Records with no wall time (because no wall time clock is configured) are
+/// stamped with the system real-time clock, so that the aggregator can order
+/// them.
+class SocketSink : public LogSink {
+ public:
+  /// Smallest max_batch; each batch must fit at least one frame, with the
+  /// longest file name.
+  static constexpr size_t kMinBatch = 512;
+
+  /// Starts the sender thread. socket_path is the path of the aggregator's
+  /// socket. queue_capacity bounds the memory used by the queue. max_batch is
+  /// raised to kMinBatch if smaller.
+  SocketSink(const char* socket_path, size_t queue_capacity = 64 * 1024,
+             size_t max_batch = 16 * 1024,
+             roo_time::Duration flush_interval = roo_time::Millis(50));
+
+  /// Sends what remains in the queue (best effort), and stops the sender
+  /// thread.
+  ~SocketSink();
+
+  /// Returns true if the socket has been successfully created.
+  bool ok() const { return fd_ >= 0; }
+
+  /// Returns the number of records dropped so far.
+  uint64_t dropped() const { return dropped_.load(std::memory_order_relaxed); }
+
+  /// Returns the number of datagrams sent so far.
+  uint64_t batches_sent() const {
+    return batches_sent_.load(std::memory_order_relaxed);
+  }
+
+  void send(LogSeverity severity, const char* full_filename,
+            const char* base_filename, int line, roo_time::Uptime uptime,
+            roo_time::WallTime walltime, const char* message,
+            size_t message_len) override;
+
+  /// Waits (for up to a second) until everything queued so far has been sent
+  /// or dropped. Called before the process dies of a FATAL message.
+  void WaitTillSent() override;
+
+ private:
+  void run();
+  void sendBatches(const std::vector<uint8_t>& frames);
+
+  int fd_;
+  std::vector<char> socket_path_;
+  size_t queue_capacity_;
+  size_t max_batch_;
+  roo_time::Duration flush_interval_;
+
+  std::mutex mutex_;
+  std::condition_variable wakeup_;
+  std::condition_variable sent_;
+  std::vector<uint8_t> queue_;  // Encoded frames; guarded by mutex_.
+  uint64_t queued_count_;       // Frames ever queued; guarded by mutex_.
+  uint64_t done_count_;         // Frames ever sent or dropped; ditto.
+  bool flush_requested_;        // Guarded by mutex_.
+  bool stopping_;               // Guarded by mutex_.
+
+  std::atomic<uint64_t> dropped_;
+  std::atomic<uint64_t> batches_sent_;
+  std::thread thread_;
+};
+
+}  // namespace roo_logging
+
+#endif  // defined(__linux__)
@@ -44,13 +44,14 @@
 namespace roo_logging {
 namespace {
 
-void ColoredWriteToStderr(LogSeverity severity, const char* message, size_t len,
+void ColoredWriteToStderr(const ConfigSnapshot& config, LogSeverity severity,
+                          const char* message, size_t len,
                           bool from_static_initializer) {
-  bool coloring = GET_ROO_FLAG(roo_logging_colorlogtostderr);
+  bool coloring = config.colorlogtostderr;
   LogColor color = coloring ? SeverityToColor(severity) : COLOR_DEFAULT;
   if (color == COLOR_DEFAULT) {
-#if (defined ESP_PLATFORM)
-#if !defined(__linux__)
+#if (defined ESP_PLATFORM) || !defined(ARDUINO)
+#if (defined ESP_PLATFORM) && !defined(__linux__)
     // Note: emulated ets_printf would write to stdout, not stderr.
     if (from_static_initializer) {
       // stderr might not yet be initialized. Write directly to UART.
@@ -67,12 +68,14 @@ void ColoredWriteToStderr(LogSeverity severity, const char* message, size_t len,
     return;
 #endif
   }
+#if (defined ESP_PLATFORM) || !defined(ARDUINO)
 #if (defined ESP_PLATFORM)
   if (from_static_initializer) {
     // stderr might not yet be initialized. Write directly to UART.
     ets_printf("\033[0;3%sm%s\033[m", GetAnsiColorCode(color), message);
     return;
   }
+#endif
   fwrite("\033[0;3", 5, 1, stderr);
   fwrite(GetAnsiColorCode(color), 1, 1, stderr);
   fwrite("m", 1, 1, stderr);
@@ -88,11 +91,13 @@ void ColoredWriteToStderr(LogSeverity severity, const char* message, size_t len,
 
 // Take a log message of a particular severity and log it to stderr
 // iff it's of a high enough severity to deserve it.
-void MaybeLogToStderr(LogSeverity severity, const char* message, size_t len,
+void MaybeLogToStderr(const ConfigSnapshot& config, LogSeverity severity,
+                      const char* message, size_t len,
                       bool from_static_initializer) {
   //   if ((severity >= GET_ROO_FLAG(stderrthreshold)) ||
   //   GET_ROO_FLAG(alsologtostderr)) {
-  ColoredWriteToStderr(severity, message, len, from_static_initializer);
+  ColoredWriteToStderr(config, severity, message, len,
+                       from_static_initializer);
 }
 
 }  // namespace roo_logging
\ No newline at end of file
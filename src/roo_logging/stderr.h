@@ -33,11 +33,13 @@
 
 #include <stddef.h>
 
+#include "roo_logging/config.h"
 #include "roo_logging/log_severity.h"
 
 namespace roo_logging {
 
-void MaybeLogToStderr(LogSeverity severity, const char* message, size_t len,
+void MaybeLogToStderr(const ConfigSnapshot& config, LogSeverity severity,
+                      const char* message, size_t len,
                       bool from_static_initializer);
 
 }  // namespace roo_logging
\ No newline at end of file
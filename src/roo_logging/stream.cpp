@@ -38,12 +38,46 @@
 
 namespace roo_logging {
 
+void DefaultLogStream::addField(LogFieldType type, roo::string_view key,
+                                const void* value, size_t value_size,
+                                roo::string_view str) {
+  size_t key_len = key.size() > 255 ? 255 : key.size();
+  size_t str_len = str.size();
+  size_t fixed_size =
+      2 + key_len + value_size + (type == LOG_FIELD_STRING ? 2 : 0) + 2;
+  // The record ends where the previous one begins, and must leave room for
+  // the spare byte below it.
+  size_t top = has_fields() ? cap_ + 1 : fields_end_;
+  // The text, and the spare byte after it, plus one more.
+  size_t bottom = (size_t)pos_ + 2;
+  if (top < bottom || top - bottom < fixed_size) return;
+  // Long strings may take at most half of the remaining space, so that they
+  // don't starve the message text and the subsequent fields.
+  size_t available = (top - bottom - fixed_size) / 2;
+  if (str_len > available) str_len = available;
+  if (str_len > 0xFFFF - fixed_size) str_len = 0xFFFF - fixed_size;
+  size_t size = fixed_size + str_len;
+  char* p = buf_ + top - size;
+  *p++ = (char)type;
+  *p++ = (char)key_len;
+  memcpy(p, key.data(), key_len);
+  p += key_len;
+  if (type == LOG_FIELD_STRING) {
+    *p++ = (char)(str_len & 0xFF);
+    *p++ = (char)(str_len >> 8);
+    memcpy(p, str.data(), str_len);
+    p += str_len;
+  } else {
+    memcpy(p, value, value_size);
+    p += value_size;
+  }
+  *p++ = (char)(size & 0xFF);
+  *p++ = (char)(size >> 8);
+  cap_ = top - size - 1;
+}
+
 DefaultLogStream& operator<<(DefaultLogStream& s, const char* val) {
-  size_t len = strlen(val);
-  size_t cap = s.remaining_capacity();
-  if (len > cap) len = cap;
-  memcpy(&s.buf_[s.pos_], val, len);
-  s.pos_ += len;
+  s.write(val, strlen(val));
   return s;
 }
 
@@ -109,11 +143,7 @@ DefaultLogStream& operator<<(DefaultLogStream& s, roo_time::DateTime dt) {
 
 roo_logging::DefaultLogStream& operator<<(roo_logging::DefaultLogStream& s,
                                           const ::String& val) {
-  size_t len = val.length();
-  size_t cap = s.remaining_capacity();
-  if (len > cap) len = cap;
-  memcpy(&s.buf_[s.pos_], val.c_str(), len);
-  s.pos_ += len;
+  s.write(val.c_str(), val.length());
   return s;
 }
 
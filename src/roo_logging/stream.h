@@ -36,6 +36,8 @@
 #include "roo_backport.h"
 #include "roo_backport/string_view.h"
 #include "roo_logging/config.h"
+#include "roo_logging/dtoa.h"
+#include "roo_logging/fields.h"
 #include "roo_logging/predict.h"
 #include "roo_time.h"
 
@@ -49,6 +51,11 @@ using StreamBase = roo_logging::ArduinoLogStream;
 
 using StreamBase = roo_logging::EspidfLogStream;
 
+#else
+#include "roo_logging/stream_posix.h"
+
+using StreamBase = roo_logging::PosixLogStream;
+
 #endif
 
 namespace roo_logging {
@@ -57,12 +64,126 @@ namespace roo_logging {
 enum PRIVATE_Counter { COUNTER };
 
 // An arbitrary limit on the length of a single log message. This
-// is so that streaming can be done more efficiently.
-static constexpr size_t kMaxLogMessageLen = 1024;
+// is so that streaming can be done more efficiently. Configurable with
+// ROO_LOGGING_MAX_MESSAGE_LEN.
+static constexpr size_t kMaxLogMessageLen = ROO_LOGGING_MAX_MESSAGE_LEN;
+
+static_assert(kMaxLogMessageLen >= 64 &&
+                  kMaxLogMessageLen <= kMaxStreamBufferLen,
+              "ROO_LOGGING_MAX_MESSAGE_LEN must be between 64 and 65534");
 
 class DefaultLogStream : public StreamBase {
  public:
-  DefaultLogStream(char* buf, size_t cap) : StreamBase(buf, cap) {}
+  DefaultLogStream(char* buf, size_t cap)
+      : StreamBase(buf, cap), float_decimals_(-1) {}
+
+  /// Records a structured key/value field, e.g.:
+  ///
+  ///   LOG(INFO).kv("temp", t).kv("id", id) << "Reading";
+  ///
+  /// The value is stored in its binary form, in the tail of the message
+  /// buffer. It is rendered as key=value (after the message text) when the
+  /// message is written to stderr, and it is available to sinks as a typed
+  /// field (see LogSink::sendRecord()). Keys longer than 255 characters
+  /// are truncated. String values are truncated to at most half of the
+  /// remaining buffer space; other fields are dropped if they do not fit.
+  DefaultLogStream& kv(roo::string_view key, bool val) {
+    uint8_t v = val ? 1 : 0;
+    addField(LOG_FIELD_BOOL, key, &v, 1);
+    return *this;
+  }
+  DefaultLogStream& kv(roo::string_view key, int val) {
+    return kvInt(key, val);
+  }
+  DefaultLogStream& kv(roo::string_view key, long val) {
+    return kvInt(key, val);
+  }
+  DefaultLogStream& kv(roo::string_view key, long long val) {
+    return kvInt(key, val);
+  }
+  DefaultLogStream& kv(roo::string_view key, unsigned int val) {
+    return kvUint(key, val);
+  }
+  DefaultLogStream& kv(roo::string_view key, unsigned long val) {
+    return kvUint(key, val);
+  }
+  DefaultLogStream& kv(roo::string_view key, unsigned long long val) {
+    return kvUint(key, val);
+  }
+  DefaultLogStream& kv(roo::string_view key, double val) {
+    addField(LOG_FIELD_DOUBLE, key, &val, sizeof(val));
+    return *this;
+  }
+  DefaultLogStream& kv(roo::string_view key, const char* val) {
+    return kv(key, roo::string_view(val));
+  }
+  DefaultLogStream& kv(roo::string_view key, roo::string_view val) {
+    addField(LOG_FIELD_STRING, key, nullptr, 0, val);
+    return *this;
+  }
+  DefaultLogStream& kv(roo::string_view key, const StringType& val) {
+    return kv(key, roo::string_view(val.c_str(), val.length()));
+  }
+
+  // Other string types, e.g. std::string.
+  template <typename S, typename = decltype(std::declval<const S&>().data()),
+            typename = decltype(std::declval<const S&>().size())>
+  DefaultLogStream& kv(roo::string_view key, const S& val) {
+    return kv(key, roo::string_view(val.data(), val.size()));
+  }
+
+  // Prevents pointers from silently converting to bool.
+  template <typename T>
+  DefaultLogStream& kv(roo::string_view key, const T* val) = delete;
+
+  bool has_fields() const { return cap_ < fields_end_; }
+
+  // The raw region of the buffer holding the fields (see LogFields).
+  const char* fields_begin() const {
+    return has_fields() ? buf_ + cap_ + 1 : buf_ + fields_end_;
+  }
+  const char* fields_end() const { return buf_ + fields_end_; }
+
+  /// Number of decimals used for floating-point values, or -1 for the
+  /// shortest representation that round-trips. See fixed() and shortest().
+  int float_decimals() const { return float_decimals_; }
+  void setFloatDecimals(int decimals) {
+    float_decimals_ = decimals < 0 ? -1
+                      : decimals > kMaxFixedDecimals ? kMaxFixedDecimals
+                                                     : decimals;
+  }
+
+  // Formats the value into the buffer, without going through printf.
+  void writeFloat(float val) {
+    if (float_decimals_ >= 0) {
+      writeDouble(val);
+      return;
+    }
+    char tmp[kMaxFloatChars];
+    write(tmp, FormatFloat(val, tmp));
+  }
+
+  void writeDouble(double val) {
+    char tmp[kMaxFloatChars];
+    write(tmp, float_decimals_ >= 0 ? FormatFixed(val, float_decimals_, tmp)
+                                    : FormatDouble(val, tmp));
+  }
+
+ private:
+  DefaultLogStream& kvInt(roo::string_view key, int64_t val) {
+    addField(LOG_FIELD_INT, key, &val, sizeof(val));
+    return *this;
+  }
+
+  DefaultLogStream& kvUint(roo::string_view key, uint64_t val) {
+    addField(LOG_FIELD_UINT, key, &val, sizeof(val));
+    return *this;
+  }
+
+  void addField(LogFieldType type, roo::string_view key, const void* value,
+                size_t value_size, roo::string_view str = roo::string_view());
+
+  int8_t float_decimals_;
 };
 
 DefaultLogStream& operator<<(DefaultLogStream& s, const char* val);
@@ -113,12 +234,12 @@ inline DefaultLogStream& operator<<(DefaultLogStream& s, unsigned long val) {
 }
 
 inline DefaultLogStream& operator<<(DefaultLogStream& s, float val) {
-  s.printf("%g", val);
+  s.writeFloat(val);
   return s;
 }
 
 inline DefaultLogStream& operator<<(DefaultLogStream& s, double val) {
-  s.printf("%g", val);
+  s.writeDouble(val);
   return s;
 }
 
@@ -155,7 +276,11 @@ inline DefaultLogStream& operator<<(DefaultLogStream& os,
 }
 
 inline DefaultLogStream& operator<<(DefaultLogStream& os, const void* ptr) {
+#if defined(ARDUINO)
   os.printf("%p", ptr);
+#else
+  os.printPointer(ptr);
+#endif
   return os;
 }
 
@@ -179,6 +304,27 @@ inline DefaultLogStream& bin(DefaultLogStream& stream) {
   return stream;
 }
 
+// Floating-point values are written with the shortest representation that
+// round-trips (e.g. "0.1", "21.5", "1e+20"). This is the default.
+inline DefaultLogStream& shortest(DefaultLogStream& stream) {
+  stream.setFloatDecimals(-1);
+  return stream;
+}
+
+struct FixedPrecision {
+  int decimals;
+};
+
+// Floating-point values are written in fixed-point notation, with the
+// specified number of decimals, e.g.: LOG(INFO) << fixed(2) << 21.5 prints
+// "21.50".
+inline FixedPrecision fixed(int decimals) { return FixedPrecision{decimals}; }
+
+inline DefaultLogStream& operator<<(DefaultLogStream& s, FixedPrecision p) {
+  s.setFloatDecimals(p.decimals);
+  return s;
+}
+
 inline DefaultLogStream& operator<<(
     DefaultLogStream& s, DefaultLogStream& (*fn)(DefaultLogStream& stream)) {
   return fn(s);
@@ -217,6 +363,11 @@ class NullStream : public Stream {
   //     : Stream(message_buffer_, 1) {}
   NullStream& stream() { return *this; }
 
+  template <class T>
+  NullStream& kv(roo::string_view, const T&) {
+    return *this;
+  }
+
  private:
   // A very short buffer for messages (which we discard anyway). This
   // will be needed if NullStream& converted to LogStream& (e.g. as a
@@ -273,16 +424,16 @@ inline roo_logging::DefaultLogStream& operator<<(
 
 inline roo_logging::DefaultLogStream& operator<<(
     roo_logging::DefaultLogStream& s, roo::string_view val) {
-  size_t len = val.size();
-  size_t cap = s.remaining_capacity();
-  if (len > cap) len = cap;
-  memcpy(&s.buf_[s.pos_], val.data(), len);
-  s.pos_ += len;
+  s.write(val.data(), val.size());
   return s;
 }
 
 inline DefaultLogStream& operator<<(DefaultLogStream& s, std::nullptr_t t) {
+#if defined(ARDUINO)
   s.printf("%p", t);
+#else
+  s.printPointer(nullptr);
+#endif
   return s;
 }
 
@@ -295,11 +446,7 @@ namespace roo_logging {
 
 inline roo_logging::DefaultLogStream& operator<<(
     roo_logging::DefaultLogStream& s, const ::std::string& val) {
-  size_t len = val.size();
-  size_t cap = s.remaining_capacity();
-  if (len > cap) len = cap;
-  memcpy(&s.buf_[s.pos_], val.data(), len);
-  s.pos_ += len;
+  s.write(val.data(), val.size());
   return s;
 }
 
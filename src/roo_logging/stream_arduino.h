@@ -7,27 +7,21 @@
 #include "roo_backport/string_view.h"
 #include "roo_logging/config.h"
 #include "roo_logging/predict.h"
+#include "roo_logging/stream_buffer.h"
 #include "roo_time.h"
 
 namespace roo_logging {
 
-class ArduinoLogStream : public Print {
+class ArduinoLogStream : public Print, public StreamBuffer {
  public:
-  ArduinoLogStream(char* buf, size_t cap)
-      : buf_(buf), pos_(0), cap_(cap), number_base_(10), ctr_(0) {}
-  size_t remaining_capacity() const { return cap_ - pos_ - 1; }
-  bool full() const { return remaining_capacity() == 0; }
+  ArduinoLogStream(char* buf, size_t cap) : StreamBuffer(buf, cap) {}
 
-  void setBase(int base) {
-    if (base < 2) base = 10;
-    number_base_ = base;
-  }
+  // Integers are formatted by Print; printf formats straight into the
+  // buffer (see StreamBuffer).
+  using Print::print;
+  using StreamBuffer::printf;
 
-  bool write(char b) {
-    if (full()) return false;
-    buf_[pos_++] = b;
-    return true;
-  }
+  bool write(char b) { return StreamBuffer::write(b); }
 
   size_t write(uint8_t b) override { return write((char)b) ? 1 : 0; }
 
@@ -36,30 +30,8 @@ class ArduinoLogStream : public Print {
   }
 
   size_t write(const char* buf, size_t len) {
-    size_t cap = remaining_capacity();
-    if (len > cap) len = cap;
-    memcpy(&buf_[pos_], buf, len);
-    pos_ += len;
-    return len;
+    return StreamBuffer::write(buf, len);
   }
-
-#if defined(ESP32) || defined(ROO_TESTING)
-  // Optimized version of printf.
-  size_t printf(const char* format, ...);
-#endif
-
-  int number_base() const { return number_base_; }
-
-  int pcount() const { return pos_; }
-
-  int ctr() const { return ctr_; }
-  void set_ctr(int ctr) { ctr_ = ctr; }
-
-  char* buf_;
-  size_t pos_;
-  size_t cap_;
-  int number_base_;
-  int ctr_;
 };
 
 }  // namespace roo_logging
@@ -0,0 +1,157 @@
+#include "roo_logging/stream_buffer.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "roo_logging/itoa.h"
+#include "roo_threads.h"
+#include "roo_threads/mutex.h"
+
+namespace roo_logging {
+
+namespace {
+
+// Released spill buffers are kept for reuse, so that a burst of long
+// messages doesn't hit the allocator every time.
+static constexpr int kSpillPoolCapacity = 2;
+
+struct SpillPool {
+  roo::mutex mutex;
+  char* buffers[kSpillPoolCapacity];
+  int count;
+  // Size of the pooled buffers. All have the same size.
+  size_t size;
+};
+
+SpillPool& spill_pool() {
+  static SpillPool pool;
+  return pool;
+}
+
+char* AcquireSpillBuffer(size_t size) {
+  SpillPool& pool = spill_pool();
+  {
+    roo::lock_guard<roo::mutex> lock(pool.mutex);
+    if (pool.count > 0 && pool.size == size) {
+      return pool.buffers[--pool.count];
+    }
+  }
+  return (char*)malloc(size);
+}
+
+void ReleaseSpillBuffer(char* buf, size_t size) {
+  SpillPool& pool = spill_pool();
+  {
+    roo::lock_guard<roo::mutex> lock(pool.mutex);
+    if (pool.count == 0) pool.size = size;
+    if (pool.size == size && pool.count < kSpillPoolCapacity) {
+      pool.buffers[pool.count++] = buf;
+      return;
+    }
+  }
+  free(buf);
+}
+
+}  // namespace
+
+size_t StreamBuffer::overflow(size_t len) {
+  if (spill_ == nullptr && overflow_limit_ > fields_end_) spill();
+  size_t available = remaining_capacity();
+  if (len > available) {
+    addTruncated(len - available);
+    len = available;
+  }
+  return len;
+}
+
+bool StreamBuffer::spill() {
+  char* buf = AcquireSpillBuffer(overflow_limit_ + 1);
+  if (buf == nullptr) return false;
+  // The spare byte, and the fields (if any).
+  size_t tail = fields_end_ - cap_;
+  memcpy(buf, buf_, pos_);
+  memcpy(buf + overflow_limit_ - tail, buf_ + cap_, tail);
+  buf_ = buf;
+  spill_ = buf;
+  cap_ = overflow_limit_ - tail;
+  fields_end_ = overflow_limit_;
+  return true;
+}
+
+void StreamBuffer::releaseSpill() {
+  ReleaseSpillBuffer(spill_, fields_end_ + 1);
+  spill_ = nullptr;
+}
+
+size_t StreamBuffer::vprintf(const char* format, va_list arg) {
+  va_list copy;
+  va_copy(copy, arg);
+  size_t cap = remaining_capacity();
+  int len = vsnprintf(buf_ + pos_, cap + 1, format, arg);
+  if (len < 0) {
+    va_end(copy);
+    return 0;
+  }
+  if ((size_t)len > cap) {
+    // On overflow, vsnprintf returns the length it would have written. Try
+    // to make room, and retry.
+    size_t fit = reserve(len);
+    if (fit > cap) vsnprintf(buf_ + pos_, fit + 1, format, copy);
+    len = fit;
+  }
+  va_end(copy);
+  pos_ += len;
+  return len;
+}
+
+size_t StreamBuffer::printf(const char* format, ...) {
+  va_list arg;
+  va_start(arg, format);
+  size_t len = vprintf(format, arg);
+  va_end(arg);
+  return len;
+}
+
+size_t StreamBuffer::printNumber(uint64_t n, bool negative, uint8_t base,
+                                 bool lowercase) {
+  if (base < 2 || base > 36) base = 10;
+  size_t len = CountDigits(n, base) + (negative ? 1 : 0);
+  if (ROO_PREDICT_FALSE(len > remaining_capacity())) {
+    // Does not fit; write as much as possible.
+    char tmp[kMaxIntegerChars];
+    return write(tmp, FormatInteger(n, negative, base, tmp));
+  }
+  char* p = buf_ + pos_;
+  if (negative) *p = '-';
+  WriteDigits(n, base, p + len, lowercase);
+  pos_ += len;
+  return len;
+}
+
+size_t StreamBuffer::printPointer(const void* ptr) {
+  size_t len = write("0x", 2);
+  return len + printNumber((uintptr_t)ptr, false, 16, true);
+}
+
+void StreamBuffer::writeTruncationMarker() {
+  char marker[48];
+  size_t overwrite = 0;
+  int len;
+  while (true) {
+    len = snprintf(marker, sizeof(marker), "...[truncated %lu bytes]",
+                   (unsigned long)(truncated_ + overwrite));
+    size_t room = remaining_capacity();
+    size_t needed = (size_t)len > room ? len - room : 0;
+    if (needed > pos_) needed = pos_;
+    // The count may have gained a digit; repeat until stable.
+    if (needed <= overwrite) break;
+    overwrite = needed;
+  }
+  pos_ -= overwrite;
+  addTruncated(overwrite);
+  size_t room = remaining_capacity();
+  memcpy(buf_ + pos_, marker, (size_t)len < room ? len : room);
+  pos_ += (size_t)len < room ? len : room;
+}
+
+}  // namespace roo_logging
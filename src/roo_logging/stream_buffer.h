@@ -0,0 +1,173 @@
+#pragma once
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "roo_logging/predict.h"
+
+namespace roo_logging {
+
+static constexpr size_t kMaxStreamBufferLen = 65534;
+
+/// The largest number of dropped characters that a stream counts (well past
+/// kMaxStreamBufferLen).
+static constexpr size_t kMaxTruncatedCount = (1 << 18) - 1;
+
+/// The character buffer underlying each of the stream backends, with the
+/// formatting that they share (integers, pointers, printf).
+///
+/// Text is appended at buf_ + pos_, up to cap_ - 1 characters (the byte at
+/// buf_[cap_] is kept spare for a terminator). The region [cap_ + 1,
+/// fields_end_) holds the structured fields, if any (see DefaultLogStream).
+///
+/// Writes that do not fit are truncated, and the number of dropped characters
+/// is recorded. If overflow is enabled, the first write that does not fit
+/// moves the message to a larger, pooled spill buffer, of up to the specified
+/// hard limit. The fast path (the write fits) is unaffected.
+///
+/// Positions are 16-bit, to keep the per-message footprint small; buffers
+/// (including spill buffers) are limited to kMaxStreamBufferLen.
+class StreamBuffer {
+ public:
+  StreamBuffer(char* buf, size_t cap)
+      : buf_(buf),
+        pos_(0),
+        cap_(cap),
+        fields_end_(cap),
+        overflow_limit_(0),
+        spill_(nullptr),
+        ctr_(0),
+        truncated_(0),
+        number_base_(10) {}
+
+  ~StreamBuffer() {
+    if (spill_ != nullptr) releaseSpill();
+  }
+
+  StreamBuffer(const StreamBuffer&) = delete;
+  StreamBuffer& operator=(const StreamBuffer&) = delete;
+
+  size_t remaining_capacity() const { return cap_ - pos_ - 1; }
+  bool full() const { return remaining_capacity() == 0; }
+
+  /// Returns the number of characters, up to len, that can be appended at
+  /// buf_ + pos_, spilling to a larger buffer if needed and allowed. Counts
+  /// the remaining ones as truncated.
+  size_t reserve(size_t len) {
+    if (ROO_PREDICT_TRUE(len <= remaining_capacity())) return len;
+    return overflow(len);
+  }
+
+  bool write(char b) {
+    if (ROO_PREDICT_FALSE(full()) && reserve(1) == 0) return false;
+    buf_[pos_++] = b;
+    return true;
+  }
+
+  size_t write(const char* buf, size_t len) {
+    len = reserve(len);
+    memcpy(&buf_[pos_], buf, len);
+    pos_ += len;
+    return len;
+  }
+
+  /// Appends printf-formatted text, truncating it if it doesn't fit.
+  size_t vprintf(const char* format, va_list arg);
+
+  size_t printf(const char* format, ...);
+
+  void setBase(int base) {
+    if (base < 2 || base > 36) base = 10;
+    number_base_ = base;
+  }
+
+  int number_base() const { return number_base_; }
+
+  // Integers are formatted directly into the buffer, without printf. Signed
+  // values are written with a '-' in base 10, and as their two's complement
+  // (of their own width) in other bases.
+  size_t print(int n, uint8_t base) {
+    return printSigned(n, (unsigned int)n, base);
+  }
+  size_t print(long n, uint8_t base) {
+    return printSigned(n, (unsigned long)n, base);
+  }
+  size_t print(long long n, uint8_t base) {
+    return printSigned(n, (unsigned long long)n, base);
+  }
+  size_t print(unsigned int n, uint8_t base) {
+    return printNumber(n, false, base);
+  }
+  size_t print(unsigned long n, uint8_t base) {
+    return printNumber(n, false, base);
+  }
+  size_t print(unsigned long long n, uint8_t base) {
+    return printNumber(n, false, base);
+  }
+
+  // Writes the pointer as "0x" followed by lower-case hex digits.
+  size_t printPointer(const void* ptr);
+
+  int pcount() const { return pos_; }
+
+  int ctr() const { return ctr_; }
+  void set_ctr(int ctr) { ctr_ = ctr; }
+
+  /// Enables the overflow mode: messages that do not fit in the initial
+  /// buffer spill into a pooled buffer, of up to `limit` characters, and
+  /// truncated messages get a visible marker (see writeTruncationMarker()).
+  void enableOverflow(size_t limit) {
+    overflow_limit_ =
+        limit > kMaxStreamBufferLen ? kMaxStreamBufferLen : (uint16_t)limit;
+  }
+
+  bool overflow_enabled() const { return overflow_limit_ > 0; }
+
+  /// Number of characters dropped so far, because they didn't fit (capped at
+  /// kMaxTruncatedCount).
+  size_t truncated() const { return truncated_; }
+
+  /// Appends "...[truncated N bytes]", overwriting the tail of the text if
+  /// needed. N includes the characters overwritten by the marker.
+  void writeTruncationMarker();
+
+  char* buf_;
+  uint16_t pos_;
+  uint16_t cap_;
+
+ protected:
+  uint16_t fields_end_;
+
+ private:
+  size_t overflow(size_t len);
+  bool spill();
+  void releaseSpill();
+
+  void addTruncated(size_t count) {
+    size_t total = truncated_ + count;
+    truncated_ = total > kMaxTruncatedCount ? kMaxTruncatedCount : total;
+  }
+
+  size_t printSigned(long long n, unsigned long long as_unsigned,
+                     uint8_t base) {
+    if (n < 0 && base == 10) {
+      return printNumber(0 - (unsigned long long)n, true, base);
+    }
+    return printNumber(as_unsigned, false, base);
+  }
+
+  size_t printNumber(uint64_t n, bool negative, uint8_t base,
+                     bool lowercase = false);
+
+  uint16_t overflow_limit_;
+  char* spill_;
+  int ctr_;
+  // Packed into 3 bytes, leaving the last one of the word to the subclass
+  // (see DefaultLogStream).
+  uint32_t truncated_ : 18;
+  uint32_t number_base_ : 6;
+};
+
+}  // namespace roo_logging
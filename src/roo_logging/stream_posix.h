@@ -0,0 +1,20 @@
+#pragma once
+
+#if !defined(ARDUINO) && !defined(ESP_PLATFORM)
+
+#include "roo_logging/stream_buffer.h"
+
+namespace roo_logging {
+
+/// Stream backend for native (Linux, macOS) builds, selected when neither
+/// ARDUINO nor ESP_PLATFORM is defined. Formats directly into the message
+/// buffer (see StreamBuffer), without the Arduino emulation layer and
+/// without virtual dispatch.
+class PosixLogStream : public StreamBuffer {
+ public:
+  PosixLogStream(char* buf, size_t cap) : StreamBuffer(buf, cap) {}
+};
+
+}  // namespace roo_logging
+
+#endif
@@ -35,6 +35,7 @@
 #include <cstring>
 #include <limits>
 
+#include "roo_logging/debug_line.h"
 #include "roo_logging/demangle.h"
 
 #ifdef HAVE___ATTRIBUTE__
@@ -59,7 +60,11 @@ static int AssertFail() {
 
 #ifdef ROO_LOGGING_HAVE_SYMBOLIZE
 
+#if defined(__ELF__) && ROO_LOGGING_SYMBOLIZE_DEBUG_LINE
+static SymbolizeCallback g_symbolize_callback = DebugLineSymbolizeCallback;
+#else
 static SymbolizeCallback g_symbolize_callback = NULL;
+#endif
 void InstallSymbolizeCallback(SymbolizeCallback callback) {
   g_symbolize_callback = callback;
 }
@@ -77,7 +82,7 @@ void InstallSymbolizeOpenObjectFileCallback(
 // get inlined.
 static ATTRIBUTE_NOINLINE void DemangleInplace(char *out, int out_size) {
   char demangled[256];  // Big enough for sane demangled symbols.
-  if (Demangle(out, demangled, sizeof(demangled))) {
+  if (DemangleCached(out, demangled, sizeof(demangled))) {
     // Demangling succeeded. Copy to out if the space allows.
     size_t len = strlen(demangled);
     if (len + 1 <= (size_t)out_size) {  // +1 for '\0'.
@@ -786,8 +791,8 @@ static ATTRIBUTE_NOINLINE bool SymbolizeAndDemangle(void *pc, char *out,
   if (g_symbolize_callback) {
     // Run the call back if it's installed.
     // Note: relocation (and much of the rest of this code) will be
-    // wrong for prelinked shared libraries and PIE executables.
-    uint64_t relocation = (elf_type == ET_DYN) ? start_address : 0;
+    // wrong for prelinked shared libraries.
+    uint64_t relocation = (elf_type == ET_DYN) ? base_address : 0;
     int num_bytes_written = g_symbolize_callback(wrapped_object_fd.get(), pc,
                                                  out, out_size, relocation);
     if (num_bytes_written > 0) {
@@ -122,9 +122,13 @@ namespace roo_logging {
 // is printed. The callback is intended to be used for showing a file name and a
 // line number preceding a symbol name.
 // "fd" is a file descriptor of the object file containing the program
-// counter "pc". The callback function should write output to "out"
-// and return the size of the output written. On error, the callback
-// function should return -1.
+// counter "pc", and "relocation" is the address at which the object file
+// was loaded (zero for non-PIE executables); i.e., "pc" - "relocation"
+// is the address in the object file. The callback function should write
+// output to "out" and return the size of the output written. On error, the
+// callback function should return -1.
+// By default, DebugLineSymbolizeCallback (see debug_line.h) is installed
+// (unless ROO_LOGGING_SYMBOLIZE_DEBUG_LINE is 0).
 typedef int (*SymbolizeCallback)(int fd, void *pc, char *out, size_t out_size,
                                  uint64_t relocation);
 void InstallSymbolizeCallback(SymbolizeCallback callback);
@@ -0,0 +1,235 @@
+#include "roo_logging/timestamp.h"
+
+#include <atomic>
+
+#if (defined __FREERTOS || defined ESP_PLATFORM)
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#elif (defined __linux__)
+#include <time.h>
+#endif
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+namespace roo_logging {
+
+namespace {
+
+constexpr int64_t kMicrosPerSecond = 1000000;
+
+// Offsets are calibrated on first use; this value means 'not yet'.
+constexpr int64_t kUncalibrated = INT64_MIN;
+
+roo_time::Uptime UptimeFromMicros(int64_t micros) {
+  return roo_time::Uptime::Start() + roo_time::Micros(micros);
+}
+
+#if (defined __FREERTOS || defined ESP_PLATFORM)
+
+#define ROO_LOGGING_HAVE_COARSE_CLOCK 1
+
+// The FreeRTOS tick count, which the tick interrupt keeps up to date,
+// extended to 64 bits. Assumes that it is read at least once every 2^31
+// ticks (24 days, at 1 kHz).
+int64_t CoarseMicros() {
+  // Wraparounds in the high 32 bits; the last seen tick count in the low.
+  static std::atomic<uint64_t> extended(0);
+  uint32_t ticks = (uint32_t)xTaskGetTickCount();
+  uint64_t previous = extended.load(std::memory_order_relaxed);
+  uint64_t next;
+  do {
+    uint32_t last = (uint32_t)previous;
+    if ((int32_t)(ticks - last) <= 0) {
+      // No tick since, or a stale reading that raced with another thread.
+      next = previous;
+      break;
+    }
+    uint64_t wraps = (previous >> 32) + (ticks < last ? 1 : 0);
+    next = (wraps << 32) | ticks;
+  } while (!extended.compare_exchange_weak(previous, next,
+                                           std::memory_order_relaxed));
+  return (int64_t)(next * kMicrosPerSecond / configTICK_RATE_HZ);
+}
+
+#elif (defined __linux__)
+
+#define ROO_LOGGING_HAVE_COARSE_CLOCK 1
+
+int64_t CoarseMicros() {
+  timespec ts;
+  clock_gettime(CLOCK_MONOTONIC_COARSE, &ts);
+  return ts.tv_sec * kMicrosPerSecond + ts.tv_nsec / 1000;
+}
+
+#endif
+
+#if defined(ROO_LOGGING_HAVE_COARSE_CLOCK)
+
+// Difference between the uptime and the coarse clock, measured on first use.
+std::atomic<int64_t> coarse_offset(kUncalibrated);
+
+roo_time::Uptime CoarseNow() {
+  int64_t offset = coarse_offset.load(std::memory_order_relaxed);
+  if (offset == kUncalibrated) {
+    int64_t calibrated =
+        roo_time::Uptime::Now().inMicros() - CoarseMicros();
+    // If another thread got there first, uses its value.
+    offset = coarse_offset.compare_exchange_strong(offset, calibrated,
+                                                   std::memory_order_relaxed)
+                 ? calibrated
+                 : offset;
+  }
+  return UptimeFromMicros(CoarseMicros() + offset);
+}
+
+#endif
+
+#if defined(__x86_64__) || defined(__i386__)
+
+#define ROO_LOGGING_HAVE_CYCLE_COUNTER 1
+
+inline uint64_t ReadCycles() { return __rdtsc(); }
+
+#elif defined(__aarch64__)
+
+#define ROO_LOGGING_HAVE_CYCLE_COUNTER 1
+
+inline uint64_t ReadCycles() {
+  uint64_t value;
+  asm volatile("mrs %0, cntvct_el0" : "=r"(value));
+  return value;
+}
+
+#endif
+
+#if defined(ROO_LOGGING_HAVE_CYCLE_COUNTER)
+
+// The counter frequency is not known up front (and, for the TSC, not
+// reported by the CPU), so it is measured against the precise clock: first
+// over kInitialCalibrationMicros, during which the precise clock is used,
+// and then over the entire run so far, each time the anchor is refreshed.
+constexpr int64_t kInitialCalibrationMicros = 10000;
+
+struct CycleCalibration {
+  // A recent reading of the counter, and the uptime at that moment.
+  uint64_t cycles;
+  int64_t micros;
+  double micros_per_cycle;
+  // When to take a new anchor.
+  uint64_t refresh_at;
+};
+
+// Calibrations are written round-robin, so that a reader still using an
+// older one is not affected by the next few refreshes.
+constexpr int kCalibrationSlots = 4;
+
+CycleCalibration calibrations[kCalibrationSlots];
+std::atomic<const CycleCalibration*> current_calibration(nullptr);
+
+// Set while a thread is (re)calibrating; others keep using the current
+// calibration, or the precise clock if there is none yet.
+std::atomic<bool> calibrating(false);
+
+// The first reading of the counter and of the uptime, written once under
+// `calibrating`.
+uint64_t first_cycles;
+int64_t first_micros = kUncalibrated;
+int next_slot = 0;
+
+// Takes a new anchor, and returns the corresponding uptime. Called with
+// `calibrating` set.
+int64_t Recalibrate() {
+  uint64_t cycles = ReadCycles();
+  int64_t micros = roo_time::Uptime::Now().inMicros();
+  if (first_micros == kUncalibrated) {
+    first_cycles = cycles;
+    first_micros = micros;
+    return micros;
+  }
+  int64_t elapsed = micros - first_micros;
+  if (elapsed < kInitialCalibrationMicros || cycles <= first_cycles) {
+    return micros;
+  }
+  CycleCalibration& calibration = calibrations[next_slot];
+  next_slot = (next_slot + 1) % kCalibrationSlots;
+  calibration.cycles = cycles;
+  calibration.micros = micros;
+  calibration.micros_per_cycle =
+      (double)elapsed / (double)(cycles - first_cycles);
+  calibration.refresh_at =
+      cycles + (uint64_t)(kMicrosPerSecond / calibration.micros_per_cycle);
+  current_calibration.store(&calibration, std::memory_order_release);
+  return micros;
+}
+
+roo_time::Uptime CyclesNow() {
+  uint64_t cycles = ReadCycles();
+  const CycleCalibration* calibration =
+      current_calibration.load(std::memory_order_acquire);
+  if (calibration == nullptr || cycles >= calibration->refresh_at) {
+    if (!calibrating.exchange(true, std::memory_order_acquire)) {
+      int64_t micros = Recalibrate();
+      calibrating.store(false, std::memory_order_release);
+      return UptimeFromMicros(micros);
+    }
+    if (calibration == nullptr) return roo_time::Uptime::Now();
+  }
+  int64_t delta = (int64_t)(cycles - calibration->cycles);
+  return UptimeFromMicros(calibration->micros +
+                          (int64_t)(delta * calibration->micros_per_cycle));
+}
+
+#endif
+
+// Difference between the wall time and the uptime, for the clock it was
+// measured with, and when to measure it again. The fields are updated
+// independently; a reader that races with an update may see a mix of the
+// old and the new values, which are both valid.
+std::atomic<roo_time::WallTimeClock*> offset_clock(nullptr);
+std::atomic<int64_t> wall_offset(0);
+std::atomic<int64_t> wall_offset_refresh_at(0);
+
+}  // namespace
+
+roo_time::Uptime TimestampNow(TimestampSource source) {
+  switch (source) {
+#if defined(ROO_LOGGING_HAVE_COARSE_CLOCK)
+    case TIMESTAMP_COARSE:
+      return CoarseNow();
+#endif
+#if defined(ROO_LOGGING_HAVE_CYCLE_COUNTER)
+    case TIMESTAMP_CYCLES:
+      return CyclesNow();
+#endif
+    default:
+      return roo_time::Uptime::Now();
+  }
+}
+
+roo_time::WallTime WallTimeAt(roo_time::WallTimeClock* clock,
+                              TimestampSource source,
+                              roo_time::Uptime uptime) {
+  if (clock == nullptr) return roo_time::WallTime();
+  if (source != TIMESTAMP_PRECISE &&
+      offset_clock.load(std::memory_order_acquire) == clock &&
+      uptime.inMicros() <
+          wall_offset_refresh_at.load(std::memory_order_relaxed)) {
+    return roo_time::WallTime(roo_time::Micros(
+        uptime.inMicros() + wall_offset.load(std::memory_order_relaxed)));
+  }
+  // The uptime was taken just before, so the wall time is read as of then,
+  // and no other clock is read.
+  roo_time::WallTime now = clock->now();
+  if (source != TIMESTAMP_PRECISE) {
+    wall_offset.store(now.sinceEpoch().inMicros() - uptime.inMicros(),
+                      std::memory_order_relaxed);
+    wall_offset_refresh_at.store(uptime.inMicros() + kMicrosPerSecond,
+                                 std::memory_order_relaxed);
+    offset_clock.store(clock, std::memory_order_release);
+  }
+  return now;
+}
+
+}  // namespace roo_logging
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "roo_time.h"
+
+namespace roo_logging {
+
+/// Where messages get their timestamps from. Selected with the
+/// roo_logging_timestamp_source flag.
+enum TimestampSource : uint8_t {
+  /// roo_time::Uptime::Now() for every message, and, in the wall time mode,
+  /// the wall time clock as well (default).
+  TIMESTAMP_PRECISE = 0,
+
+  /// A coarse monotonic clock, with a resolution of a few milliseconds:
+  /// CLOCK_MONOTONIC_COARSE on Linux, or the FreeRTOS tick count. Wall time
+  /// is derived from uptime, with an offset that is refreshed from the wall
+  /// time clock at most once per second.
+  TIMESTAMP_COARSE = 1,
+
+  /// The CPU cycle counter (the x86 TSC, or the ARMv8 virtual counter),
+  /// converted to uptime with a ratio that is calibrated against the precise
+  /// clock, and re-anchored at most once per second. Wall time as in
+  /// TIMESTAMP_COARSE.
+  TIMESTAMP_CYCLES = 2,
+};
+
+/// Returns the current uptime, as measured by the specified source. Sources
+/// not available on the platform fall back to TIMESTAMP_PRECISE.
+roo_time::Uptime TimestampNow(TimestampSource source);
+
+/// Returns the wall time corresponding to the specified uptime, which must
+/// have just been taken with TimestampNow(source), as per the specified
+/// clock, or the epoch if the clock is nullptr. With TIMESTAMP_PRECISE, reads
+/// the wall time clock on every call; otherwise, adds an offset to the
+/// uptime, and reads the wall time clock to refresh the offset at most once
+/// per second.
+roo_time::WallTime WallTimeAt(roo_time::WallTimeClock* clock,
+                              TimestampSource source, roo_time::Uptime uptime);
+
+}  // namespace roo_logging
@@ -0,0 +1,162 @@
+#include "roo_logging/vlog.h"
+
+#include <string.h>
+
+#include "roo_threads.h"
+#include "roo_threads/mutex.h"
+
+namespace roo_logging {
+
+namespace internal {
+
+std::atomic<uint32_t> vlog_generation(1);
+
+}  // namespace internal
+
+namespace {
+
+// The registry is a list of glob patterns set at run time, so it is not kept
+// in roo_flags: a roo_flags flag is a single named value declared at compile
+// time, and cannot hold an open-ended set of patterns. (The enabling switch,
+// ROO_LOGGING_RUNTIME_VLOG, stays a compile-time macro, like the other
+// options that change what the logging macros expand to.) The list is small,
+// and only scanned when a call site re-resolves after a change.
+//
+// A single pattern -> level entry. Entries are never freed; ResetVLOGLevels()
+// merely deactivates them, and setting the same pattern again reuses the entry.
+struct VModuleInfo {
+  const char* pattern;
+  bool is_module;
+  bool active;
+  int8_t level;
+  VModuleInfo* next;
+};
+
+// Guards the registry, and serializes resolution with updates.
+static roo::mutex& vmodule_mutex() {
+  static roo::mutex m;
+  return m;
+}
+
+// Most recently added entries first.
+VModuleInfo* vmodule_list = nullptr;
+
+int8_t ClampLevel(int level) {
+  return level < -128 ? -128 : level > 127 ? 127 : (int8_t)level;
+}
+
+void BumpGeneration() {
+  uint32_t gen =
+      (internal::vlog_generation.load(std::memory_order_relaxed) + 1) &
+      0xFFFFFF;
+  if (gen == 0) gen = 1;
+  internal::vlog_generation.store(gen, std::memory_order_relaxed);
+}
+
+// Glob matching, supporting '*' and '?'.
+bool GlobMatch(const char* pattern, size_t patt_len, const char* str,
+               size_t str_len) {
+  size_t p = 0;
+  size_t s = 0;
+  // Position just after the last '*' seen, and the corresponding position
+  // in str, for backtracking.
+  size_t star_p = (size_t)-1;
+  size_t star_s = 0;
+  while (s < str_len) {
+    if (p < patt_len && (pattern[p] == '?' || pattern[p] == str[s])) {
+      ++p;
+      ++s;
+    } else if (p < patt_len && pattern[p] == '*') {
+      star_p = ++p;
+      star_s = s;
+    } else if (star_p != (size_t)-1) {
+      p = star_p;
+      s = ++star_s;
+    } else {
+      return false;
+    }
+  }
+  while (p < patt_len && pattern[p] == '*') ++p;
+  return p == patt_len;
+}
+
+bool FileMatches(const char* pattern, const char* file) {
+  if (strchr(pattern, '/') != nullptr) {
+    return GlobMatch(pattern, strlen(pattern), file, strlen(file));
+  }
+  const char* base = strrchr(file, '/');
+  base = (base != nullptr) ? base + 1 : file;
+  const char* ext = strchr(base, '.');
+  size_t len = (ext != nullptr) ? ext - base : strlen(base);
+  return GlobMatch(pattern, strlen(pattern), base, len);
+}
+
+int SetLevel(const char* pattern, int level, bool is_module) {
+  roo::lock_guard<roo::mutex> lock(vmodule_mutex());
+  int previous = -1;
+  VModuleInfo* info = nullptr;
+  for (VModuleInfo** prev = &vmodule_list; *prev != nullptr;
+       prev = &(*prev)->next) {
+    if ((*prev)->is_module == is_module &&
+        strcmp((*prev)->pattern, pattern) == 0) {
+      info = *prev;
+      if (info->active) previous = info->level;
+      // Unlink; re-added at the front below.
+      *prev = info->next;
+      break;
+    }
+  }
+  if (info == nullptr) {
+    size_t len = strlen(pattern);
+    char* copy = new char[len + 1];
+    memcpy(copy, pattern, len + 1);
+    info = new VModuleInfo();
+    info->pattern = copy;
+    info->is_module = is_module;
+  }
+  info->level = ClampLevel(level);
+  info->active = true;
+  info->next = vmodule_list;
+  vmodule_list = info;
+  BumpGeneration();
+  return previous;
+}
+
+}  // namespace
+
+int SetVLOGLevel(const char* file_pattern, int level) {
+  return SetLevel(file_pattern, level, false);
+}
+
+int SetMLOGLevel(const char* module_pattern, int level) {
+  return SetLevel(module_pattern, level, true);
+}
+
+void ResetVLOGLevels() {
+  roo::lock_guard<roo::mutex> lock(vmodule_mutex());
+  for (VModuleInfo* info = vmodule_list; info != nullptr; info = info->next) {
+    info->active = false;
+  }
+  BumpGeneration();
+}
+
+int VLogSite::resolve() {
+  roo::lock_guard<roo::mutex> lock(vmodule_mutex());
+  uint32_t gen = internal::vlog_generation.load(std::memory_order_relaxed);
+  int8_t level = ClampLevel(default_level_);
+  for (VModuleInfo* info = vmodule_list; info != nullptr; info = info->next) {
+    if (!info->active || info->is_module != (module_ != nullptr)) continue;
+    bool match = info->is_module
+                     ? GlobMatch(info->pattern, strlen(info->pattern), module_,
+                                 strlen(module_))
+                     : FileMatches(info->pattern, file_);
+    if (match) {
+      level = info->level;
+      break;
+    }
+  }
+  state_.store((gen << 8) | (uint8_t)level, std::memory_order_relaxed);
+  return level;
+}
+
+}  // namespace roo_logging
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <atomic>
+#include <stdint.h>
+
+#include "roo_logging/predict.h"
+
+/// Run-time control of verbose (VLOG) and per-module (MLOG) logging.
+///
+/// Enabled by building with ROO_LOGGING_RUNTIME_VLOG=1. In that mode, the
+/// compile-time VLOG_LEVEL and MLOG_<module> values only provide the initial
+/// levels, which can then be overridden at run time:
+///
+///   roo_logging::SetVLOGLevel("wifi_*", 2);     // VLOG(<=2) in wifi_*.cpp.
+///   roo_logging::SetMLOGLevel("my_library", 1);  // Enables MLOG(my_library).
+///
+/// Each VLOG / MLOG call site caches its resolved level, tagged with a global
+/// generation number that is bumped on every change. In the steady state, the
+/// check is a single load and compare; the pattern registry is only consulted
+/// when the generation changes.
+///
+/// Verbose messages above ROO_LOGGING_MAX_VLOG_LEVEL are still compiled out.
+
+#ifndef ROO_LOGGING_MAX_VLOG_LEVEL
+#define ROO_LOGGING_MAX_VLOG_LEVEL 127
+#endif
+
+namespace roo_logging {
+
+/// Sets the verbosity level for VLOG call sites in files matching the
+/// specified glob pattern ('*' and '?' are supported). If the pattern
+/// contains '/', it is matched against the full __FILE__ path; otherwise, it
+/// is matched against the file's base name, without the extension. For
+/// example, both "wifi*" and "*/net/*" match "src/net/wifi_manager.cpp".
+///
+/// If more than one pattern matches, the most recently set one wins. Returns
+/// the previous level set for that same pattern, or -1 if there was none.
+int SetVLOGLevel(const char* file_pattern, int level);
+
+/// Sets the level for MLOG call sites of modules whose name matches the
+/// specified glob pattern. MLOG messages are emitted if the level is > 0.
+///
+/// If more than one pattern matches, the most recently set one wins. Returns
+/// the previous level set for that same pattern, or -1 if there was none.
+int SetMLOGLevel(const char* module_pattern, int level);
+
+/// Removes all levels set by SetVLOGLevel and SetMLOGLevel, reverting all
+/// call sites to their compile-time defaults.
+void ResetVLOGLevels();
+
+namespace internal {
+
+// Bumped whenever the pattern registry changes. Never zero, so that
+// zero-initialized call sites always resolve on first use.
+extern std::atomic<uint32_t> vlog_generation;
+
+}  // namespace internal
+
+/// Per-call-site cache of the resolved verbosity level. Instances are created
+/// by the VLOG_IS_ON and MLOG_IS_ON macros as function-local statics. The
+/// constructor is constexpr, so the statics get constant-initialized, without
+/// any guard variables.
+class VLogSite {
+ public:
+  constexpr VLogSite(const char* file, const char* module, int default_level)
+      : file_(file),
+        module_(module),
+        default_level_(default_level),
+        state_(0) {}
+
+  /// Returns the current level for this call site.
+  int level() {
+    uint32_t state = state_.load(std::memory_order_relaxed);
+    if (ROO_PREDICT_TRUE(
+            (state >> 8) ==
+            internal::vlog_generation.load(std::memory_order_relaxed))) {
+      return (int8_t)(state & 0xFF);
+    }
+    return resolve();
+  }
+
+ private:
+  int resolve();
+
+  const char* file_;
+  const char* module_;  // nullptr for VLOG sites.
+  int default_level_;
+
+  // Generation number (upper 24 bits) and the resolved level (lower 8 bits).
+  std::atomic<uint32_t> state_;
+};
+
+}  // namespace roo_logging
+
+// Evaluates to the current level of the enclosing call site.
+#define ROO_LOGGING_SITE_LEVEL(module, default_level)                       \
+  ([]() -> ::roo_logging::VLogSite& {                                       \
+    static ::roo_logging::VLogSite roo_logging_site(__FILE__, module,       \
+                                                    (default_level));       \
+    return roo_logging_site;                                                \
+  }()                                                                       \
+       .level())
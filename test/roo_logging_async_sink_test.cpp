@@ -0,0 +1,190 @@
+#include <unistd.h>
+
+#include <algorithm>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "roo_logging.h"
+#include "roo_logging/async_sink.h"
+
+namespace roo_logging {
+namespace {
+
+// Records the messages it receives. Can be paused, to let the queues fill up.
+class RecordingSink : public LogSink {
+ public:
+  void send(LogSeverity severity, const char* full_filename,
+            const char* base_filename, int line, roo_time::Uptime uptime,
+            roo_time::WallTime walltime, const char* message,
+            size_t message_len) override {
+    std::unique_lock<std::mutex> lock(mutex_);
+    ++entered_;
+    cv_.notify_all();
+    cv_.wait(lock, [this] { return !paused_; });
+    messages.push_back(std::string(1, LogSeverityNames[severity][0]) + " " +
+                       std::string(message, message_len));
+  }
+
+  void sendRecord(const LogRecord& record) override {
+    sequences.push_back(record.sequence);
+    LogSink::sendRecord(record);
+  }
+
+  void WaitTillSent() override {
+    std::lock_guard<std::mutex> lock(mutex_);
+    ++waits;
+  }
+
+  void pause() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    paused_ = true;
+  }
+
+  void resume() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    paused_ = false;
+    cv_.notify_all();
+  }
+
+  // Waits until the specified number of send() calls have started.
+  void waitEntered(int count) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    cv_.wait(lock, [&] { return entered_ >= count; });
+  }
+
+  std::vector<std::string> messages;
+  std::vector<uint64_t> sequences;
+  int waits = 0;
+
+ private:
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  bool paused_ = false;
+  int entered_ = 0;
+};
+
+void Send(LogSink& sink, LogSeverity severity, const std::string& message) {
+  sink.send(severity, "/foo/bar.cpp", "bar.cpp", 12, roo_time::Uptime::Now(),
+            roo_time::WallTime(), message.data(), message.size());
+}
+
+TEST(AsyncSink, DeliversInOrderWithinSeverity) {
+  RecordingSink target;
+  {
+    AsyncSink sink(target);
+    for (int i = 0; i < 10; ++i) {
+      Send(sink, ROO_LOGGING_INFO, "Message " + std::to_string(i));
+    }
+    sink.WaitTillSent();
+    EXPECT_EQ(10u, sink.stats(AsyncSink::kInfoLane).delivered);
+    EXPECT_EQ(0u, sink.stats(AsyncSink::kInfoLane).depth);
+    EXPECT_EQ(1, target.waits);
+  }
+  ASSERT_EQ(10u, target.messages.size());
+  for (int i = 0; i < 10; ++i) {
+    EXPECT_EQ("I Message " + std::to_string(i), target.messages[i]);
+  }
+}
+
+TEST(AsyncSink, ErrorsJumpTheQueue) {
+  RecordingSink target;
+  AsyncSink sink(target);
+  target.pause();
+  Send(sink, ROO_LOGGING_INFO, "Blocker");
+  target.waitEntered(1);
+  for (int i = 0; i < 5; ++i) Send(sink, ROO_LOGGING_INFO, "Info");
+  Send(sink, ROO_LOGGING_WARNING, "Warning");
+  Send(sink, ROO_LOGGING_ERROR, "Error");
+  EXPECT_EQ(5u, sink.stats(AsyncSink::kInfoLane).depth);
+  EXPECT_EQ(1u, sink.stats(AsyncSink::kErrorLane).depth);
+  target.resume();
+  sink.WaitTillSent();
+  ASSERT_EQ(8u, target.messages.size());
+  EXPECT_EQ("I Blocker", target.messages[0]);
+  EXPECT_EQ("E Error", target.messages[1]);
+  EXPECT_EQ("W Warning", target.messages[2]);
+  EXPECT_EQ("I Info", target.messages[3]);
+}
+
+TEST(AsyncSink, InfoBurstDoesNotDropErrors) {
+  RecordingSink target;
+  AsyncSink sink(target, 1024, 1024, 1024);
+  target.pause();
+  Send(sink, ROO_LOGGING_INFO, "Blocker");
+  target.waitEntered(1);
+  for (int i = 0; i < 100; ++i) Send(sink, ROO_LOGGING_INFO, "Info");
+  Send(sink, ROO_LOGGING_ERROR, "Error");
+  AsyncSink::LaneStats info = sink.stats(AsyncSink::kInfoLane);
+  EXPECT_GT(info.dropped, 0u);
+  EXPECT_EQ(100u, info.depth + info.dropped);
+  EXPECT_LE(info.bytes, info.capacity);
+  EXPECT_EQ(0u, sink.stats(AsyncSink::kErrorLane).dropped);
+  target.resume();
+  sink.WaitTillSent();
+  ASSERT_GE(target.messages.size(), 3u);
+  EXPECT_EQ("E Error", target.messages[1]);
+  // Drops are reported before the next delivered message of the lane.
+  EXPECT_EQ("I [" + std::to_string(info.dropped) + " messages dropped]",
+            target.messages[2]);
+  // Like all deliveries, the note goes through sendRecord().
+  EXPECT_EQ(target.messages.size(), target.sequences.size());
+  EXPECT_EQ(0u, target.sequences[2]);
+}
+
+TEST(AsyncSink, KeepsSequenceNumbers) {
+  RecordingSink target;
+  AsyncSink sink(target);
+  std::string message = "Message";
+  for (uint64_t sequence : {7, 8, 10}) {
+    sink.sendRecord(LogRecord{sequence, ROO_LOGGING_INFO, "/foo/bar.cpp",
+                              "bar.cpp", 12, roo_time::Uptime::Now(),
+                              roo_time::WallTime(), message.data(),
+                              message.size(), LogFields()});
+  }
+  sink.WaitTillSent();
+  EXPECT_EQ(std::vector<uint64_t>({7, 8, 10}), target.sequences);
+}
+
+TEST(AsyncSink, FatalIsSynchronous) {
+  RecordingSink target;
+  AsyncSink sink(target);
+  Send(sink, ROO_LOGGING_FATAL, "Fatal");
+  // Delivered, and flushed, before send() returns.
+  ASSERT_EQ(1u, target.messages.size());
+  EXPECT_EQ("F Fatal", target.messages[0]);
+  EXPECT_EQ(1, target.waits);
+  EXPECT_EQ(1u, sink.fatal_delivered());
+}
+
+TEST(AsyncSink, FatalDeliversQueuedErrorsFirst) {
+  RecordingSink target;
+  AsyncSink sink(target);
+  target.pause();
+  Send(sink, ROO_LOGGING_INFO, "Blocker");
+  target.waitEntered(1);
+  Send(sink, ROO_LOGGING_INFO, "Info");
+  Send(sink, ROO_LOGGING_WARNING, "Warning");
+  Send(sink, ROO_LOGGING_ERROR, "Error");
+  std::thread fatal([&] { Send(sink, ROO_LOGGING_FATAL, "Fatal"); });
+  // Gives the FATAL send time to start waiting for the blocker.
+  usleep(20000);
+  target.resume();
+  fatal.join();
+  sink.WaitTillSent();
+  std::vector<std::string>& messages = target.messages;
+  ASSERT_EQ(5u, messages.size());
+  auto position = [&](const std::string& message) {
+    return std::find(messages.begin(), messages.end(), message) -
+           messages.begin();
+  };
+  EXPECT_EQ(0, position("I Blocker"));
+  EXPECT_LT(position("E Error"), position("W Warning"));
+  EXPECT_LT(position("W Warning"), position("F Fatal"));
+}
+
+}  // namespace
+}  // namespace roo_logging
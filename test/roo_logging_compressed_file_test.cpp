@@ -0,0 +1,283 @@
+#include <stdio.h>
+#include <unistd.h>
+
+#include <random>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "roo_logging.h"
+#include "roo_logging/compressed_file_sink.h"
+#include "roo_logging/log_line.h"
+#include "roo_logging/lz.h"
+
+namespace roo_logging {
+namespace {
+
+std::string RoundTrip(const std::string& input, size_t* compressed_size) {
+  static lz::Compressor compressor;
+  std::vector<uint8_t> compressed(lz::MaxCompressedSize(input.size()));
+  size_t len = compressor.compress(
+      reinterpret_cast<const uint8_t*>(input.data()), input.size(),
+      compressed.data());
+  EXPECT_LE(len, compressed.size());
+  if (compressed_size != nullptr) *compressed_size = len;
+  std::string output(input.size(), '\0');
+  EXPECT_TRUE(lz::Decompress(compressed.data(), len,
+                             reinterpret_cast<uint8_t*>(&output[0]),
+                             output.size()));
+  return output;
+}
+
+std::string LogText(int lines) {
+  std::string text;
+  for (int i = 0; i < lines; ++i) {
+    text += "I2026-10-18T12:34:" + std::to_string(10 + i % 50) + "." +
+            std::to_string(100000 + i * 37) +
+            " server.cpp:" + std::to_string(100 + i % 7) +
+            "] Handled request " + std::to_string(i) + " in " +
+            std::to_string(i % 13) + " ms\n";
+  }
+  return text;
+}
+
+std::string TempPath() {
+  return "/tmp/roo_logging_test_" + std::to_string(getpid()) + ".rlz";
+}
+
+std::string ReadAll(const std::string& path, uint64_t* damaged = nullptr,
+                    bool* truncated = nullptr) {
+  FILE* in = fopen(path.c_str(), "rb");
+  EXPECT_NE(nullptr, in);
+  if (in == nullptr) return "";
+  compressed_log::Reader reader(in);
+  std::string text;
+  while (reader.next(text)) {
+  }
+  fclose(in);
+  if (damaged != nullptr) *damaged = reader.damaged();
+  if (truncated != nullptr) *truncated = reader.truncated();
+  return text;
+}
+
+void Send(CompressedFileSink& sink, const std::string& message) {
+  sink.send(ROO_LOGGING_INFO, "/foo/bar.cpp", "bar.cpp", 12,
+            roo_time::Uptime::Start() + roo_time::Micros(1500000),
+            roo_time::WallTime(), message.data(), message.size());
+}
+
+TEST(Lz, RoundTrip) {
+  EXPECT_EQ("", RoundTrip("", nullptr));
+  EXPECT_EQ("a", RoundTrip("a", nullptr));
+  EXPECT_EQ("abcd", RoundTrip("abcd", nullptr));
+  std::string repeated(1000, 'x');
+  EXPECT_EQ(repeated, RoundTrip(repeated, nullptr));
+  std::string long_literals;
+  std::mt19937 rng(1);
+  for (int i = 0; i < 60000; ++i) long_literals.push_back((char)rng());
+  EXPECT_EQ(long_literals, RoundTrip(long_literals, nullptr));
+  std::string mixed = long_literals.substr(0, 300) + LogText(200) +
+                      long_literals.substr(0, 300);
+  EXPECT_EQ(mixed, RoundTrip(mixed, nullptr));
+}
+
+TEST(Lz, CompressesLogText) {
+  std::string text = LogText(800);
+  ASSERT_LE(text.size(), lz::kMaxBlockSize);
+  size_t compressed_size;
+  EXPECT_EQ(text, RoundTrip(text, &compressed_size));
+  EXPECT_LT(compressed_size * 4, text.size());
+}
+
+TEST(Lz, RejectsMalformedInput) {
+  std::string text = LogText(50);
+  lz::Compressor compressor;
+  std::vector<uint8_t> compressed(lz::MaxCompressedSize(text.size()));
+  size_t len =
+      compressor.compress(reinterpret_cast<const uint8_t*>(text.data()),
+                          text.size(), compressed.data());
+  std::vector<uint8_t> out(text.size());
+  // Wrong size.
+  EXPECT_FALSE(lz::Decompress(compressed.data(), len, out.data(),
+                              out.size() - 1));
+  // Truncated.
+  EXPECT_FALSE(lz::Decompress(compressed.data(), len / 2, out.data(),
+                              out.size()));
+  // Garbage never reads or writes out of bounds (checked by sanitizers).
+  std::mt19937 rng(2);
+  for (int i = 0; i < 1000; ++i) {
+    std::vector<uint8_t> garbage(compressed.begin(), compressed.begin() + len);
+    garbage[rng() % len] = (uint8_t)rng();
+    lz::Decompress(garbage.data(), garbage.size(), out.data(), out.size());
+  }
+}
+
+TEST(CompressedFileSink, WritesCompressedLog) {
+  unlink(TempPath().c_str());
+  std::string expected;
+  {
+    CompressedFileSink sink(TempPath().c_str(), 4096, 64);
+    ASSERT_TRUE(sink.ok());
+    for (int i = 0; i < 1000; ++i) {
+      std::string message = "Handled request " + std::to_string(i);
+      Send(sink, message);
+      expected += "IS+000000.00:00:01.500000 bar.cpp:12] " + message + "\n";
+    }
+    sink.WaitTillSent();
+    EXPECT_EQ(expected.size(), sink.bytes_in());
+    EXPECT_LT(sink.bytes_out() * 3, sink.bytes_in());
+    EXPECT_EQ(0u, sink.dropped());
+  }
+  EXPECT_EQ(expected, ReadAll(TempPath()));
+  unlink(TempPath().c_str());
+}
+
+TEST(CompressedFileSink, ClampsTinyBlockSize) {
+  unlink(TempPath().c_str());
+  uint64_t dropped;
+  {
+    CompressedFileSink sink(TempPath().c_str(), 16, 1);
+    ASSERT_TRUE(sink.ok());
+    for (int i = 0; i < 100; ++i) Send(sink, std::string(1000, 'x'));
+    sink.WaitTillSent();
+    dropped = sink.dropped();
+  }
+  uint64_t damaged;
+  std::string text = ReadAll(TempPath(), &damaged);
+  EXPECT_EQ(0u, damaged);
+  // Each message is cut to fit in a block, along with its prefix.
+  std::string line =
+      "IS+000000.00:00:01.500000 bar.cpp:12] " + std::string(1000, 'x');
+  size_t pos = text.find('\n');
+  ASSERT_NE(std::string::npos, pos);
+  EXPECT_LT(pos, CompressedFileSink::kMinBlockSize);
+  EXPECT_EQ(line.substr(0, pos), text.substr(0, pos));
+  if (dropped == 0) {
+    EXPECT_EQ(100 * (pos + 1), text.size());
+  }
+  unlink(TempPath().c_str());
+}
+
+TEST(CompressedFileSink, AppendsToExistingFile) {
+  unlink(TempPath().c_str());
+  {
+    CompressedFileSink sink(TempPath().c_str());
+    Send(sink, "First");
+  }
+  {
+    CompressedFileSink sink(TempPath().c_str());
+    Send(sink, "Second");
+  }
+  EXPECT_EQ(
+      "IS+000000.00:00:01.500000 bar.cpp:12] First\n"
+      "IS+000000.00:00:01.500000 bar.cpp:12] Second\n",
+      ReadAll(TempPath()));
+  unlink(TempPath().c_str());
+}
+
+TEST(CompressedFileSink, FlushesPeriodically) {
+  unlink(TempPath().c_str());
+  CompressedFileSink sink(TempPath().c_str(), 64 * 1024, 8,
+                          roo_time::Millis(10));
+  Send(sink, "Hello");
+  for (int i = 0; i < 100 && sink.bytes_in() == 0; ++i) usleep(10000);
+  EXPECT_EQ("IS+000000.00:00:01.500000 bar.cpp:12] Hello\n",
+            ReadAll(TempPath()));
+  unlink(TempPath().c_str());
+}
+
+// The tools that search logs (log_grep, log_query, log_merge) must be able
+// to read what log_cat prints.
+TEST(CompressedFileSink, WritesParsableLines) {
+  unlink(TempPath().c_str());
+  // 2026-10-18T12:34:56.000123Z.
+  int64_t walltime_us = 1792326896000123LL;
+  {
+    CompressedFileSink sink(TempPath().c_str());
+    Send(sink, "By uptime");
+    sink.send(ROO_LOGGING_WARNING, "/foo/baz.cpp", "baz.cpp", 34,
+              roo_time::Uptime::Start() + roo_time::Micros(2000000),
+              roo_time::WallTime(roo_time::Micros(walltime_us)), "By date",
+              7);
+  }
+  std::string text = ReadAll(TempPath());
+  size_t eol = text.find('\n');
+  ASSERT_NE(std::string::npos, eol);
+  LogLine line;
+  ASSERT_TRUE(ParseLogLine(text.data(), eol, line));
+  EXPECT_EQ(ROO_LOGGING_INFO, line.severity);
+  EXPECT_FALSE(line.has_walltime);
+  EXPECT_EQ(1500000, line.time_us);
+  EXPECT_EQ("bar.cpp", std::string(line.file, line.file_len));
+  EXPECT_EQ(12, line.line);
+  EXPECT_EQ("By uptime", std::string(line.message, line.message_len));
+  ASSERT_TRUE(
+      ParseLogLine(text.data() + eol + 1, text.size() - eol - 2, line));
+  EXPECT_EQ(ROO_LOGGING_WARNING, line.severity);
+  EXPECT_TRUE(line.has_walltime);
+  EXPECT_EQ(walltime_us, line.time_us);
+  EXPECT_EQ("baz.cpp", std::string(line.file, line.file_len));
+  EXPECT_EQ(34, line.line);
+  EXPECT_EQ("By date", std::string(line.message, line.message_len));
+  unlink(TempPath().c_str());
+}
+
+TEST(CompressedFileSink, ReadsTruncatedAndDamagedFiles) {
+  unlink(TempPath().c_str());
+  {
+    CompressedFileSink sink(TempPath().c_str(), 1024, 64);
+    for (int i = 0; i < 100; ++i) Send(sink, "Message " + std::to_string(i));
+  }
+  std::string intact = ReadAll(TempPath());
+  FILE* f = fopen(TempPath().c_str(), "rb");
+  std::string contents;
+  char buf[4096];
+  size_t n;
+  while ((n = fread(buf, 1, sizeof(buf), f)) > 0) contents.append(buf, n);
+  fclose(f);
+
+  // Truncated in the middle of the last block.
+  f = fopen(TempPath().c_str(), "wb");
+  fwrite(contents.data(), 1, contents.size() - 10, f);
+  fclose(f);
+  uint64_t damaged;
+  bool truncated;
+  std::string text = ReadAll(TempPath(), &damaged, &truncated);
+  EXPECT_EQ(0u, damaged);
+  EXPECT_TRUE(truncated);
+  EXPECT_FALSE(text.empty());
+  EXPECT_EQ(0u, intact.find(text));
+  EXPECT_LT(text.size(), intact.size());
+
+  // A byte flipped in the middle of the file.
+  std::string corrupted = contents;
+  corrupted[contents.size() / 2] ^= 0x55;
+  f = fopen(TempPath().c_str(), "wb");
+  fwrite(corrupted.data(), 1, corrupted.size(), f);
+  fclose(f);
+  text = ReadAll(TempPath(), &damaged, &truncated);
+  EXPECT_EQ(1u, damaged);
+  EXPECT_FALSE(truncated);
+  EXPECT_LT(text.size(), intact.size());
+  EXPECT_NE(std::string::npos, text.find("Message 0\n"));
+  EXPECT_NE(std::string::npos, text.find("Message 99\n"));
+  unlink(TempPath().c_str());
+}
+
+TEST(CompressedFileSink, DropsWhenWriterFallsBehind) {
+  unlink(TempPath().c_str());
+  uint64_t dropped;
+  {
+    CompressedFileSink sink(TempPath().c_str(), 1024, 1);
+    for (int i = 0; i < 10000; ++i) Send(sink, std::string(100, 'x'));
+    dropped = sink.dropped();
+  }
+  std::string text = ReadAll(TempPath());
+  if (dropped > 0) {
+    EXPECT_NE(std::string::npos, text.find(" records dropped]\n"));
+  }
+  unlink(TempPath().c_str());
+}
+
+}  // namespace
+}  // namespace roo_logging
@@ -0,0 +1,134 @@
+#include <elf.h>
+#include <fcntl.h>
+#include <link.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "roo_logging/debug_line.h"
+#include "roo_logging/symbolize.h"
+
+namespace roo_logging {
+namespace {
+
+constexpr int kMarkerLine = __LINE__ + 1;
+__attribute__((noinline)) int Marker(int x) { return x * 3 + 1; }
+
+// The load address of the executable.
+uintptr_t LoadBias() {
+  uintptr_t bias = 0;
+  dl_iterate_phdr(
+      [](dl_phdr_info* info, size_t, void* data) {
+        // The executable comes first.
+        *static_cast<uintptr_t*>(data) = info->dlpi_addr;
+        return 1;
+      },
+      &bias);
+  return bias;
+}
+
+// Returns the (object file) addresses of all the functions defined in the
+// executable, from its symbol table.
+std::vector<uint64_t> FunctionAddresses(int fd) {
+  std::vector<uint64_t> result;
+  struct stat st;
+  if (fstat(fd, &st) != 0) return result;
+  void* map = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  if (map == MAP_FAILED) return result;
+  const uint8_t* base = static_cast<const uint8_t*>(map);
+  const ElfW(Ehdr)* ehdr = reinterpret_cast<const ElfW(Ehdr)*>(base);
+  const ElfW(Shdr)* shdrs =
+      reinterpret_cast<const ElfW(Shdr)*>(base + ehdr->e_shoff);
+  for (int i = 0; i < ehdr->e_shnum; ++i) {
+    if (shdrs[i].sh_type != SHT_SYMTAB) continue;
+    const ElfW(Sym)* syms =
+        reinterpret_cast<const ElfW(Sym)*>(base + shdrs[i].sh_offset);
+    size_t count = shdrs[i].sh_size / sizeof(ElfW(Sym));
+    for (size_t j = 0; j < count; ++j) {
+      if (ELF64_ST_TYPE(syms[j].st_info) == STT_FUNC &&
+          syms[j].st_shndx != SHN_UNDEF && syms[j].st_value != 0) {
+        result.push_back(syms[j].st_value);
+      }
+    }
+  }
+  munmap(map, st.st_size);
+  return result;
+}
+
+class DebugLineTest : public testing::Test {
+ protected:
+  DebugLineTest() : fd_(open("/proc/self/exe", O_RDONLY)) {}
+  ~DebugLineTest() { close(fd_); }
+
+  int fd_;
+};
+
+TEST_F(DebugLineTest, LooksUpLine) {
+  ASSERT_GE(fd_, 0);
+  uintptr_t pc = reinterpret_cast<uintptr_t>(&Marker);
+  const char* file;
+  int line;
+  ASSERT_TRUE(LookupDebugLine(fd_, pc - LoadBias(), &file, &line));
+  EXPECT_STREQ("roo_logging_debug_line_test.cpp", file);
+  EXPECT_EQ(kMarkerLine, line);
+  // Again, from the index.
+  ASSERT_TRUE(LookupDebugLine(fd_, pc - LoadBias(), &file, &line));
+  EXPECT_EQ(kMarkerLine, line);
+}
+
+TEST_F(DebugLineTest, LooksUpAllFunctions) {
+  ASSERT_GE(fd_, 0);
+  std::vector<uint64_t> addresses = FunctionAddresses(fd_);
+  ASSERT_GT(addresses.size(), 100u);
+  size_t found = 0;
+  for (uint64_t address : addresses) {
+    const char* file;
+    int line;
+    if (LookupDebugLine(fd_, address, &file, &line)) {
+      EXPECT_GT(strlen(file), 0u);
+      EXPECT_GT(line, 0);
+      ++found;
+    }
+  }
+  // Functions without line info (e.g. from libraries built without -g) are
+  // skipped, but this file has it.
+  EXPECT_GT(found, 0u);
+}
+
+TEST_F(DebugLineTest, UnknownAddress) {
+  ASSERT_GE(fd_, 0);
+  const char* file;
+  int line;
+  EXPECT_FALSE(LookupDebugLine(fd_, 0, &file, &line));
+  EXPECT_FALSE(LookupDebugLine(fd_, UINT64_MAX, &file, &line));
+}
+
+TEST_F(DebugLineTest, Callback) {
+  ASSERT_GE(fd_, 0);
+  void* pc = reinterpret_cast<void*>(&Marker);
+  char out[256];
+  int length =
+      DebugLineSymbolizeCallback(fd_, pc, out, sizeof(out), LoadBias());
+  ASSERT_GT(length, 0);
+  EXPECT_EQ("roo_logging_debug_line_test.cpp:" + std::to_string(kMarkerLine) +
+                " ",
+            std::string(out, length));
+  // Leaves room for the symbol name.
+  EXPECT_EQ(-1, DebugLineSymbolizeCallback(fd_, pc, out, 40, LoadBias()));
+}
+
+TEST_F(DebugLineTest, Symbolize) {
+  char out[256];
+  ASSERT_TRUE(Symbolize(reinterpret_cast<void*>(&Marker), out, sizeof(out)));
+  EXPECT_EQ("roo_logging_debug_line_test.cpp:" + std::to_string(kMarkerLine) +
+                " roo_logging::(anonymous namespace)::Marker()",
+            std::string(out));
+}
+
+}  // namespace
+}  // namespace roo_logging
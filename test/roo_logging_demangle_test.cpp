@@ -0,0 +1,129 @@
+#include <stdio.h>
+#include <string.h>
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "roo_logging/demangle.h"
+
+namespace roo_logging {
+namespace {
+
+// Reads test/demangle_corpus.txt, as (mangled, expected) pairs.
+std::vector<std::pair<std::string, std::string>> ReadCorpus() {
+  std::vector<std::pair<std::string, std::string>> corpus;
+  FILE* in = fopen("test/demangle_corpus.txt", "r");
+  if (in == nullptr) return corpus;
+  char line[8192];
+  while (fgets(line, sizeof(line), in) != nullptr) {
+    line[strcspn(line, "\n")] = '\0';
+    if (line[0] == '#' || line[0] == '\0') continue;
+    char* tab = strchr(line, '\t');
+    if (tab == nullptr) continue;
+    *tab = '\0';
+    corpus.emplace_back(line, tab + 1);
+  }
+  fclose(in);
+  return corpus;
+}
+
+std::string DemangleIt(const char* mangled) {
+  char out[1024];
+  return Demangle(mangled, out, sizeof(out)) ? out : mangled;
+}
+
+TEST(Demangle, Corpus) {
+  auto corpus = ReadCorpus();
+  ASSERT_FALSE(corpus.empty());
+  for (const auto& entry : corpus) {
+    EXPECT_EQ(entry.second, DemangleIt(entry.first.c_str())) << entry.first;
+  }
+}
+
+TEST(Demangle, CachedMatchesUncached) {
+  ClearDemangleCache();
+  auto corpus = ReadCorpus();
+  ASSERT_FALSE(corpus.empty());
+  // Twice, to compare both the misses and the hits.
+  for (int pass = 0; pass < 2; ++pass) {
+    for (const auto& entry : corpus) {
+      const char* mangled = entry.first.c_str();
+      for (size_t out_size : {8, 64, 1024}) {
+        char expected[1024];
+        char actual[1024];
+        bool ok = Demangle(mangled, expected, out_size);
+        ASSERT_EQ(ok, DemangleCached(mangled, actual, out_size))
+            << mangled << " " << out_size;
+        if (ok) {
+          EXPECT_STREQ(expected, actual);
+        }
+      }
+    }
+  }
+}
+
+TEST(Demangle, CacheHits) {
+  ClearDemangleCache();
+  const char* mangled = "_ZNSt6vectorIiSaIiEE9push_backERKi";
+  char out[256];
+  ASSERT_TRUE(DemangleCached(mangled, out, sizeof(out)));
+  EXPECT_STREQ("std::vector<>::push_back()", out);
+  DemangleCacheStats stats = GetDemangleCacheStats();
+  EXPECT_EQ(0u, stats.hits);
+  EXPECT_EQ(ROO_LOGGING_DEMANGLE_CACHE_SIZE > 0 ? 1u : 0u, stats.misses);
+  memset(out, 0, sizeof(out));
+  ASSERT_TRUE(DemangleCached(mangled, out, sizeof(out)));
+  EXPECT_STREQ("std::vector<>::push_back()", out);
+  stats = GetDemangleCacheStats();
+  EXPECT_EQ(ROO_LOGGING_DEMANGLE_CACHE_SIZE > 0 ? 1u : 0u, stats.hits);
+  // Does not fit.
+  EXPECT_FALSE(DemangleCached(mangled, out, 10));
+}
+
+TEST(Demangle, BoundedMatchesRecursive) {
+  auto corpus = ReadCorpus();
+  ASSERT_FALSE(corpus.empty());
+  for (const auto& entry : corpus) {
+    const char* mangled = entry.first.c_str();
+    for (size_t out_size : {8, 64, 1024}) {
+      char expected[1024];
+      char actual[1024];
+      bool ok = Demangle(mangled, expected, out_size);
+      ASSERT_EQ(ok, DemangleBounded(mangled, actual, out_size))
+          << mangled << " " << out_size;
+      if (ok) {
+        EXPECT_STREQ(expected, actual);
+      }
+    }
+  }
+}
+
+TEST(Demangle, BoundedLimits) {
+  const char* mangled = "_ZNSt6vectorIiSaIiEE9push_backERKi";
+  char out[256];
+  ASSERT_TRUE(DemangleBounded(mangled, out, sizeof(out)));
+  EXPECT_STREQ("std::vector<>::push_back()", out);
+  // Too deep.
+  EXPECT_FALSE(DemangleBounded(mangled, out, sizeof(out), 2));
+  // Too many steps.
+  EXPECT_FALSE(DemangleBounded(mangled, out, sizeof(out),
+                               ROO_LOGGING_DEMANGLE_MAX_DEPTH, 3));
+  // Nesting that would take thousands of recursive calls.
+  std::string deep = "_Z1f";
+  deep.append(5000, 'P');
+  deep += "i";
+  EXPECT_FALSE(DemangleBounded(deep.c_str(), out, sizeof(out)));
+  // Within the limits, but not within 10 steps.
+  deep = "_Z1f";
+  deep.append(20, 'P');
+  deep += "i";
+  EXPECT_TRUE(DemangleBounded(deep.c_str(), out, sizeof(out)));
+  EXPECT_STREQ("f()", out);
+  EXPECT_FALSE(DemangleBounded(deep.c_str(), out, sizeof(out),
+                               ROO_LOGGING_DEMANGLE_MAX_DEPTH, 10));
+}
+
+}  // namespace
+}  // namespace roo_logging
@@ -0,0 +1,61 @@
+#include <sstream>
+#include <string>
+
+#include "gtest/gtest.h"
+#include "roo_logging.h"
+#include "roo_logging/sink.h"
+
+// Logged before main(), before any sink is registered.
+struct EarlyLogs {
+  EarlyLogs() {
+    LOG(INFO) << "Early 1";
+    LOG(WARNING).kv("id", 7) << "Early 2";
+  }
+} early_logs;
+
+class LogCapture : public roo_logging::LogSink {
+ public:
+  LogCapture() { roo_logging::SetSink(this); }
+  ~LogCapture() { roo_logging::SetSink(nullptr); }
+  std::string str() const { return ss_.str(); }
+
+  void send(roo_logging::LogSeverity severity, const char* full_filename,
+            const char* base_filename, int line, roo_time::Uptime uptime,
+            roo_time::WallTime walltime, const char* message,
+            size_t message_len) override {
+    ss_ << roo_logging::LogSeverityNames[severity][0] << " " << base_filename
+        << ":" << line << " ";
+    ss_.write(message, message_len);
+    ss_ << "\n";
+    if (count_++ == 0) first_uptime_ = uptime;
+  }
+
+  int count_ = 0;
+  roo_time::Uptime first_uptime_;
+
+ private:
+  std::stringstream ss_;
+};
+
+TEST(EarlyLog, ReplayedToFirstSink) {
+  roo_time::Uptime before = roo_time::Uptime::Now();
+  int line = __LINE__ + 1;
+  LOG(INFO) << "Before the sink";
+  {
+    LogCapture capture;
+    EXPECT_EQ(
+        "I roo_logging_early_test.cpp:11 Early 1\n"
+        "W roo_logging_early_test.cpp:12 Early 2 id=7\n"
+        "I roo_logging_early_test.cpp:" +
+            std::to_string(line) + " Before the sink\n",
+        capture.str());
+    // The original timestamps are preserved.
+    EXPECT_LE(capture.first_uptime_, before);
+    LOG(INFO) << "Live";
+    EXPECT_NE(std::string::npos, capture.str().find("Live"));
+  }
+  // The buffer is closed after the first sink.
+  LOG(INFO) << "Dropped";
+  LogCapture capture;
+  EXPECT_EQ("", capture.str());
+}
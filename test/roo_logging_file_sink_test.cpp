@@ -0,0 +1,274 @@
+#include <stdio.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "roo_logging.h"
+#include "roo_logging/file_sink.h"
+#include "roo_logging/log_line.h"
+
+namespace roo_logging {
+namespace {
+
+// The result points into text.
+LogLine Parse(const std::string& text) {
+  LogLine line;
+  EXPECT_TRUE(ParseLogLine(text.data(), text.size(), line)) << text;
+  return line;
+}
+
+LogLine Parse(std::string&& text) = delete;
+
+std::string Str(const char* data, size_t len) { return std::string(data, len); }
+
+TEST(LogLine, ParsesWallTime) {
+  std::string text = "W2026-10-18T14:02:03.123456 main foo.cpp:12] Hi there";
+  LogLine line = Parse(text);
+  EXPECT_EQ(ROO_LOGGING_WARNING, line.severity);
+  EXPECT_TRUE(line.has_walltime);
+  EXPECT_EQ(1792332123123456LL, line.time_us);
+  EXPECT_EQ("main", Str(line.thread, line.thread_len));
+  EXPECT_EQ("foo.cpp", Str(line.file, line.file_len));
+  EXPECT_EQ(12, line.line);
+  EXPECT_EQ("Hi there", Str(line.message, line.message_len));
+}
+
+TEST(LogLine, ParsesUtcOffset) {
+  std::string text = "I2026-10-18T16:02:03.123456+02:00 foo.cpp:12] Hi";
+  LogLine line = Parse(text);
+  EXPECT_EQ(1792332123123456LL, line.time_us);
+  EXPECT_EQ(0u, line.thread_len);
+  text = "I2026-10-18T09:32:03.123456-04:30 foo.cpp:12] Hi";
+  line = Parse(text);
+  EXPECT_EQ(1792332123123456LL, line.time_us);
+}
+
+TEST(LogLine, ParsesUptime) {
+  std::string text =
+      "ES+000001.02:03:04.000005 loopTask(0x3ffb1234,core1) "
+      "foo.cpp:7] Message: [with] brackets";
+  LogLine line = Parse(text);
+  EXPECT_EQ(ROO_LOGGING_ERROR, line.severity);
+  EXPECT_FALSE(line.has_walltime);
+  EXPECT_EQ(((24 + 2) * 3600 + 3 * 60 + 4) * 1000000LL + 5, line.time_us);
+  EXPECT_EQ("loopTask(0x3ffb1234,core1)", Str(line.thread, line.thread_len));
+  EXPECT_EQ("foo.cpp", Str(line.file, line.file_len));
+  EXPECT_EQ(7, line.line);
+  EXPECT_EQ("Message: [with] brackets", Str(line.message, line.message_len));
+}
+
+TEST(LogLine, ParsesSequenceNumber) {
+  std::string text = "IS+000000.00:00:01.000000 #42 main foo.cpp:7] Hi";
+  LogLine line = Parse(text);
+  EXPECT_EQ(42u, line.sequence);
+  EXPECT_EQ("main", Str(line.thread, line.thread_len));
+  EXPECT_EQ("Hi", Str(line.message, line.message_len));
+  text = "IS+000000.00:00:01.000000 main foo.cpp:7] Hi";
+  line = Parse(text);
+  EXPECT_EQ(0u, line.sequence);
+}
+
+TEST(LogLine, RejectsContinuationLines) {
+  LogLine line;
+  for (const char* text :
+       {"", "  continued", "Xfoo", "I2026-10-18 foo.cpp:1] x",
+        "IS+000000.00:00:01.000000 foo.cpp] no line",
+        "IS+000000.00:00:01.000000 no bracket"}) {
+    EXPECT_FALSE(ParseLogLine(text, strlen(text), line)) << text;
+  }
+}
+
+TEST(LogLine, ParsesTimeArguments) {
+  const char* text = "2026-10-18T14:02";
+  bool walltime;
+  int64_t time_us;
+  EXPECT_FALSE(ParseLogTime(&text, text + strlen(text), walltime, time_us));
+  text = "2026-10-18T14:02:03";
+  ASSERT_TRUE(ParseLogTime(&text, text + strlen(text), walltime, time_us));
+  EXPECT_TRUE(walltime);
+  EXPECT_EQ(1792332123000000LL, time_us);
+  text = "S+0.00:01:30.5";
+  ASSERT_TRUE(ParseLogTime(&text, text + strlen(text), walltime, time_us));
+  EXPECT_FALSE(walltime);
+  EXPECT_EQ(90500000, time_us);
+
+  EXPECT_TRUE(ParseTimeArg("2026-10-18T14:02:03", walltime, time_us));
+  EXPECT_EQ(1792332123000000LL, time_us);
+  EXPECT_FALSE(ParseTimeArg("2026-10-18T14:02:03 ", walltime, time_us));
+  EXPECT_FALSE(ParseTimeArg("", walltime, time_us));
+}
+
+TEST(LogLine, ParsesSeverityArguments) {
+  EXPECT_EQ(ROO_LOGGING_WARNING, ParseSeverity("WARNING"));
+  EXPECT_EQ(ROO_LOGGING_ERROR, ParseSeverity("E"));
+  EXPECT_EQ(-1, ParseSeverity("X"));
+  EXPECT_EQ(-1, ParseSeverity("WARN"));
+  EXPECT_EQ(-1, ParseSeverity(""));
+}
+
+TEST(LogLine, FiltersLines) {
+  std::string text = "W2026-10-18T14:02:03.000000 foo.cpp:7] Hi";
+  LogLine line = Parse(text);
+  LogLineFilter filter;
+  EXPECT_TRUE(filter.matches(line));
+  filter.min_severity = ROO_LOGGING_ERROR;
+  EXPECT_FALSE(filter.matches(line));
+  filter.min_severity = ROO_LOGGING_WARNING;
+  filter.setFile("foo.cpp:7");
+  EXPECT_TRUE(filter.matches(line));
+  filter.setFile("foo.cpp:8");
+  EXPECT_FALSE(filter.matches(line));
+  filter.setFile("fo");
+  EXPECT_FALSE(filter.matches(line));
+  filter.setFile("foo.cpp");
+  EXPECT_TRUE(filter.matches(line));
+  filter.has_time_range = true;
+  filter.from_us = 1792332123000000LL;
+  EXPECT_TRUE(filter.matches(line));
+  filter.from_us += 1;
+  EXPECT_FALSE(filter.matches(line));
+  filter.from_us = 0;
+  filter.walltime = false;
+  EXPECT_FALSE(filter.matches(line));
+}
+
+class FileSinkTest : public testing::Test {
+ protected:
+  FileSinkTest()
+      : path_("/tmp/roo_logging_test_" + std::to_string(getpid()) + ".log") {
+    Cleanup();
+  }
+  ~FileSinkTest() { Cleanup(); }
+
+  void Cleanup() {
+    for (int i = 0; i < 4; ++i) {
+      std::string segment = (i == 0) ? path_ : path_ + "." + std::to_string(i);
+      unlink(segment.c_str());
+      unlink((segment + ".idx").c_str());
+    }
+  }
+
+  static void Send(FileSink& sink, int i) {
+    std::string message = "Message " + std::to_string(i);
+    sink.send(ROO_LOGGING_INFO, "/foo/bar.cpp", "bar.cpp", 12,
+              roo_time::Uptime::Start() + roo_time::Millis(i),
+              roo_time::WallTime(roo_time::Seconds(1792332123) +
+                                 roo_time::Millis(i)),
+              message.data(), message.size());
+  }
+
+  static std::string ReadFile(const std::string& path) {
+    std::string contents;
+    FILE* f = fopen(path.c_str(), "rb");
+    if (f == nullptr) return contents;
+    char buf[4096];
+    size_t n;
+    while ((n = fread(buf, 1, sizeof(buf), f)) > 0) contents.append(buf, n);
+    fclose(f);
+    return contents;
+  }
+
+  // Also checks that the index belongs to the segment.
+  static std::vector<log_index::IndexEntry> ReadIndex(
+      const std::string& path) {
+    std::string contents = ReadFile(path + ".idx");
+    EXPECT_GE(contents.size(), sizeof(log_index::IndexHeader));
+    log_index::IndexHeader header;
+    memcpy(&header, contents.data(), sizeof(header));
+    EXPECT_EQ(log_index::kMagic, header.magic);
+    struct stat st;
+    stat(path.c_str(), &st);
+    EXPECT_EQ((uint64_t)st.st_ino, header.inode);
+    std::vector<log_index::IndexEntry> entries(
+        (contents.size() - sizeof(header)) / sizeof(log_index::IndexEntry));
+    memcpy(entries.data(), contents.data() + sizeof(header),
+           entries.size() * sizeof(log_index::IndexEntry));
+    return entries;
+  }
+
+  std::string path_;
+};
+
+TEST_F(FileSinkTest, WritesParsableLines) {
+  {
+    FileSink sink(path_.c_str());
+    ASSERT_TRUE(sink.ok());
+    Send(sink, 5);
+  }
+  std::string contents = ReadFile(path_);
+  ASSERT_FALSE(contents.empty());
+  EXPECT_EQ('\n', contents.back());
+  std::string text = contents.substr(0, contents.size() - 1);
+  LogLine line = Parse(text);
+  EXPECT_EQ(1792332123005000LL, line.time_us);
+  EXPECT_EQ("bar.cpp", Str(line.file, line.file_len));
+  EXPECT_EQ("Message 5", Str(line.message, line.message_len));
+}
+
+TEST_F(FileSinkTest, IndexesEveryInterval) {
+  {
+    FileSink sink(path_.c_str(), 1 << 20, 4, 1024);
+    for (int i = 0; i < 1000; ++i) Send(sink, i);
+  }
+  std::string contents = ReadFile(path_);
+  std::vector<log_index::IndexEntry> entries = ReadIndex(path_);
+  EXPECT_GE(entries.size(), contents.size() / 1024);
+  EXPECT_LE(entries.size(), contents.size() / 1024 + 1);
+  EXPECT_EQ(0u, entries[0].offset);
+  for (const auto& entry : entries) {
+    // Each entry points at the start of a line with the same timestamp.
+    ASSERT_LT(entry.offset, contents.size());
+    EXPECT_TRUE(entry.offset == 0 || contents[entry.offset - 1] == '\n');
+    size_t eol = contents.find('\n', entry.offset);
+    std::string text = contents.substr(entry.offset, eol - entry.offset);
+    LogLine line = Parse(text);
+    EXPECT_EQ(entry.walltime_us, line.time_us);
+  }
+}
+
+TEST_F(FileSinkTest, KeepsIndexAcrossRestarts) {
+  {
+    FileSink sink(path_.c_str(), 1 << 20, 4, 1024);
+    for (int i = 0; i < 100; ++i) Send(sink, i);
+  }
+  size_t before = ReadIndex(path_).size();
+  {
+    FileSink sink(path_.c_str(), 1 << 20, 4, 1024);
+    Send(sink, 100);
+  }
+  std::vector<log_index::IndexEntry> entries = ReadIndex(path_);
+  ASSERT_EQ(before + 1, entries.size());
+  EXPECT_EQ(1792332123100000LL, entries.back().walltime_us);
+}
+
+TEST_F(FileSinkTest, RotatesWithIndexes) {
+  {
+    FileSink sink(path_.c_str(), 4096, 3, 1024);
+    for (int i = 0; i < 1000; ++i) Send(sink, i);
+  }
+  std::string oldest = path_ + ".2";
+  std::string middle = path_ + ".1";
+  EXPECT_NE("", ReadFile(oldest));
+  EXPECT_EQ("", ReadFile(path_ + ".3"));
+  int64_t last_time = 0;
+  for (const std::string& segment : {oldest, middle, path_}) {
+    std::string contents = ReadFile(segment);
+    EXPECT_LE(contents.size(), 4096u + 100);
+    std::vector<log_index::IndexEntry> entries = ReadIndex(segment);
+    ASSERT_FALSE(entries.empty());
+    EXPECT_EQ(0u, entries[0].offset);
+    std::string text = contents.substr(0, contents.find('\n'));
+    LogLine first = Parse(text);
+    EXPECT_EQ(entries[0].walltime_us, first.time_us);
+    EXPECT_GT(first.time_us, last_time);
+    last_time = first.time_us;
+  }
+  std::string newest = ReadFile(path_);
+  EXPECT_NE(std::string::npos, newest.find("] Message 999\n"));
+}
+
+}  // namespace
+}  // namespace roo_logging
@@ -0,0 +1,178 @@
+#include <fcntl.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <random>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "roo_logging.h"
+#include "roo_logging/mmap_ring.h"
+
+namespace roo_logging {
+namespace {
+
+// A unique file per test, removed at the end.
+class MmapRingTest : public testing::Test {
+ protected:
+  MmapRingTest() {
+    path_ = "/tmp/roo_logging_test_" + std::to_string(getpid()) + "_" +
+            testing::UnitTest::GetInstance()->current_test_info()->name();
+    unlink(path_.c_str());
+  }
+  ~MmapRingTest() { unlink(path_.c_str()); }
+
+  const char* path() const { return path_.c_str(); }
+
+  static void Send(MmapRingSink& sink, const std::string& message,
+                   int line = 1) {
+    sink.send(ROO_LOGGING_WARNING, "/foo/bar.cpp", "bar.cpp", line,
+              roo_time::Uptime::Now(), roo_time::WallTime(), message.data(),
+              message.size());
+  }
+
+  static std::vector<std::string> Messages(const MmapRingReader& reader) {
+    std::vector<std::string> result;
+    for (const auto& record : reader.records()) {
+      result.emplace_back(record.message, record.message_len);
+    }
+    return result;
+  }
+
+ private:
+  std::string path_;
+};
+
+TEST_F(MmapRingTest, WriteAndRead) {
+  {
+    MmapRingSink sink(path());
+    ASSERT_TRUE(sink.ok());
+    Send(sink, "Hello", 42);
+    Send(sink, "World");
+  }
+  MmapRingReader reader(path());
+  ASSERT_TRUE(reader.ok());
+  ASSERT_EQ(2u, reader.records().size());
+  const auto& record = reader.records()[0];
+  EXPECT_EQ(0u, record.seq);
+  EXPECT_EQ(ROO_LOGGING_WARNING, record.severity);
+  EXPECT_EQ("bar.cpp", std::string(record.base_filename,
+                                    record.base_filename_len));
+  EXPECT_EQ(42, record.line);
+  EXPECT_EQ("Hello", std::string(record.message, record.message_len));
+  EXPECT_EQ(1u, reader.records()[1].seq);
+  EXPECT_EQ(0u, reader.missing());
+}
+
+TEST_F(MmapRingTest, ReaderFailsWithoutLog) {
+  MmapRingReader reader(path());
+  EXPECT_FALSE(reader.ok());
+}
+
+TEST_F(MmapRingTest, KeepsTheNewestRecords) {
+  MmapRingSink sink(path(), 4096);
+  for (int i = 0; i < 1000; ++i) Send(sink, "Message " + std::to_string(i));
+  MmapRingReader reader(path());
+  std::vector<std::string> messages = Messages(reader);
+  ASSERT_GT(messages.size(), 10u);
+  EXPECT_LT(messages.size(), 1000u);
+  EXPECT_EQ("Message 999", messages.back());
+  size_t first = 1000 - messages.size();
+  for (size_t i = 0; i < messages.size(); ++i) {
+    EXPECT_EQ("Message " + std::to_string(first + i), messages[i]);
+  }
+  EXPECT_EQ(0u, reader.missing());
+}
+
+TEST_F(MmapRingTest, WrapsWithMixedSizes) {
+  MmapRingSink sink(path(), 4096);
+  std::mt19937 rng(1);
+  for (int i = 0; i < 2000; ++i) {
+    Send(sink, std::string(1 + rng() % 900, 'x'));
+    if (i % 10 != 0) continue;
+    // The records from earlier laps, left past the end of the newest one,
+    // must not show up as gaps.
+    MmapRingReader reader(path());
+    ASSERT_FALSE(reader.records().empty());
+    EXPECT_EQ((uint64_t)i, reader.records().back().seq);
+    EXPECT_EQ(0u, reader.missing()) << "after " << i;
+  }
+}
+
+TEST_F(MmapRingTest, ContinuesAfterRestart) {
+  {
+    MmapRingSink sink(path(), 4096);
+    for (int i = 0; i < 100; ++i) Send(sink, "First " + std::to_string(i));
+  }
+  {
+    MmapRingSink sink(path(), 4096);
+    EXPECT_EQ(100u, sink.next_seq());
+    Send(sink, "Second");
+  }
+  MmapRingReader reader(path());
+  EXPECT_EQ("Second", Messages(reader).back());
+  EXPECT_EQ("First 99", Messages(reader)[Messages(reader).size() - 2]);
+  EXPECT_EQ(0u, reader.missing());
+
+  // A different capacity starts over.
+  {
+    MmapRingSink sink(path(), 8192);
+    EXPECT_EQ(0u, sink.next_seq());
+    Send(sink, "Third");
+  }
+  MmapRingReader reader2(path());
+  EXPECT_EQ(std::vector<std::string>{"Third"}, Messages(reader2));
+}
+
+TEST_F(MmapRingTest, SurvivesCrash) {
+  pid_t pid = fork();
+  ASSERT_GE(pid, 0);
+  if (pid == 0) {
+    MmapRingSink sink(path());
+    Send(sink, "Before the crash");
+    abort();
+  }
+  int status;
+  waitpid(pid, &status, 0);
+  ASSERT_TRUE(WIFSIGNALED(status));
+  MmapRingReader reader(path());
+  EXPECT_EQ(std::vector<std::string>{"Before the crash"}, Messages(reader));
+}
+
+TEST_F(MmapRingTest, SkipsTornRecords) {
+  {
+    MmapRingSink sink(path(), 4096);
+    for (int i = 0; i < 10; ++i) Send(sink, "Message " + std::to_string(i));
+  }
+  // Garbles the middle of the fifth record's message, as if its page never
+  // made it to the disk.
+  MmapRingReader before(path());
+  // The first record is at the start of the data area.
+  const char* data =
+      before.records()[0].base_filename - sizeof(mmap_ring::RecordHeader);
+  off_t offset =
+      mmap_ring::kDataOffset + (before.records()[4].message - data) + 3;
+  int fd = open(path(), O_WRONLY);
+  ASSERT_GE(fd, 0);
+  ASSERT_EQ(1, pwrite(fd, "X", 1, offset));
+  close(fd);
+
+  MmapRingReader reader(path());
+  EXPECT_EQ(1u, reader.missing());
+  std::vector<std::string> messages = Messages(reader);
+  ASSERT_EQ(9u, messages.size());
+  EXPECT_EQ("Message 3", messages[3]);
+  EXPECT_EQ("Message 5", messages[4]);
+}
+
+TEST_F(MmapRingTest, TruncatesLongMessages) {
+  MmapRingSink sink(path(), 4096);
+  Send(sink, std::string(5000, 'x'));
+  MmapRingReader reader(path());
+  ASSERT_EQ(1u, reader.records().size());
+  EXPECT_EQ(1024u, reader.records()[0].message_len);
+}
+
+}  // namespace
+}  // namespace roo_logging
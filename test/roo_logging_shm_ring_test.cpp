@@ -0,0 +1,238 @@
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "roo_logging.h"
+#include "roo_logging/shm_ring.h"
+
+namespace roo_logging {
+namespace {
+
+// A unique shared memory name per test, removed at the end.
+class ShmRingTest : public testing::Test {
+ protected:
+  ShmRingTest() {
+    name_ = "/roo_logging_test_" + std::to_string(getpid()) + "_" +
+            testing::UnitTest::GetInstance()->current_test_info()->name();
+    shm_unlink(name_.c_str());
+  }
+  ~ShmRingTest() { shm_unlink(name_.c_str()); }
+
+  const char* name() const { return name_.c_str(); }
+
+  static void Send(ShmRingSink& sink, const std::string& message,
+                   int line = 1) {
+    sink.send(ROO_LOGGING_WARNING, "/foo/bar.cpp", "bar.cpp", line,
+              roo_time::Uptime::Now(), roo_time::WallTime(), message.data(),
+              message.size());
+  }
+
+  static std::vector<std::string> ReadAll(ShmRingReader& reader) {
+    std::vector<std::string> result;
+    ShmRingReader::Record record;
+    while (reader.next(record)) {
+      result.emplace_back(record.message, record.message_len);
+    }
+    return result;
+  }
+
+ private:
+  std::string name_;
+};
+
+TEST_F(ShmRingTest, WriteAndRead) {
+  ShmRingSink sink(name());
+  ASSERT_TRUE(sink.ok());
+  Send(sink, "Hello", 42);
+
+  ShmRingReader reader(name());
+  ASSERT_TRUE(reader.ok());
+  ShmRingReader::Record record;
+  ASSERT_TRUE(reader.next(record));
+  EXPECT_EQ(ROO_LOGGING_WARNING, record.severity);
+  EXPECT_EQ("bar.cpp", std::string(record.base_filename,
+                                    record.base_filename_len));
+  EXPECT_EQ(42, record.line);
+  EXPECT_EQ("Hello", std::string(record.message, record.message_len));
+  EXPECT_FALSE(reader.next(record));
+
+  Send(sink, "World");
+  ASSERT_TRUE(reader.next(record));
+  EXPECT_EQ("World", std::string(record.message, record.message_len));
+  EXPECT_EQ(0u, reader.pending());
+  EXPECT_TRUE(reader.producer_alive());
+}
+
+TEST_F(ShmRingTest, ReaderFailsWithoutRing) {
+  ShmRingReader reader(name());
+  EXPECT_FALSE(reader.ok());
+}
+
+TEST_F(ShmRingTest, WrapsAround) {
+  ShmRingSink sink(name(), 4096);
+  ShmRingReader reader(name());
+  ASSERT_TRUE(reader.ok());
+  for (int i = 0; i < 1000; ++i) {
+    std::string message = "Message " + std::to_string(i) +
+                          std::string(i % 97, 'x');
+    Send(sink, message);
+    std::vector<std::string> read = ReadAll(reader);
+    ASSERT_EQ(1u, read.size());
+    EXPECT_EQ(message, read[0]);
+  }
+  EXPECT_EQ(0u, sink.dropped());
+}
+
+TEST_F(ShmRingTest, DropsWhenFull) {
+  ShmRingSink sink(name(), 4096);
+  std::string message(100, 'x');
+  for (int i = 0; i < 100; ++i) Send(sink, message);
+  EXPECT_GT(sink.dropped(), 0u);
+
+  ShmRingReader reader(name());
+  EXPECT_EQ(sink.dropped(), reader.dropped());
+  size_t read = ReadAll(reader).size();
+  EXPECT_EQ(100u, read + sink.dropped());
+
+  // Room again.
+  Send(sink, "After");
+  EXPECT_EQ(std::vector<std::string>{"After"}, ReadAll(reader));
+}
+
+TEST_F(ShmRingTest, TruncatesLongMessages) {
+  ShmRingSink sink(name(), 4096);
+  Send(sink, std::string(5000, 'x'));
+  ShmRingReader reader(name());
+  std::vector<std::string> read = ReadAll(reader);
+  ASSERT_EQ(1u, read.size());
+  EXPECT_LT(read[0].size(), 1024u);
+  EXPECT_EQ(0u, sink.dropped());
+}
+
+TEST_F(ShmRingTest, BlockingWaitsForTheConsumer) {
+  ShmRingSink sink(name(), 4096, ShmRingSink::kBlock, roo_time::Millis(5000));
+  ShmRingReader reader(name());
+  std::vector<std::string> read;
+  std::thread consumer([&] {
+    ShmRingReader::Record record;
+    while (read.size() < 200) {
+      if (reader.next(record)) {
+        read.emplace_back(record.message, record.message_len);
+      } else {
+        usleep(100);
+      }
+    }
+  });
+  for (int i = 0; i < 200; ++i) {
+    Send(sink, "Message " + std::to_string(i) + std::string(100, 'x'));
+  }
+  consumer.join();
+  EXPECT_EQ(0u, sink.dropped());
+  for (int i = 0; i < 200; ++i) {
+    EXPECT_EQ("Message " + std::to_string(i) + std::string(100, 'x'), read[i]);
+  }
+}
+
+TEST_F(ShmRingTest, BlockingTimesOut) {
+  ShmRingSink sink(name(), 4096, ShmRingSink::kBlock, roo_time::Millis(1));
+  for (int i = 0; i < 100; ++i) Send(sink, std::string(100, 'x'));
+  EXPECT_GT(sink.dropped(), 0u);
+}
+
+TEST_F(ShmRingTest, ConcurrentProducers) {
+  ShmRingSink sink(name(), 1 << 20);
+  std::vector<std::thread> producers;
+  for (int t = 0; t < 4; ++t) {
+    producers.emplace_back([&sink, t] {
+      for (int i = 0; i < 1000; ++i) {
+        Send(sink, "Thread " + std::to_string(t), i);
+      }
+    });
+  }
+  for (std::thread& producer : producers) producer.join();
+  ShmRingReader reader(name());
+  ShmRingReader::Record record;
+  int next_line[4] = {0, 0, 0, 0};
+  int count = 0;
+  while (reader.next(record)) {
+    std::string message(record.message, record.message_len);
+    int t = message.back() - '0';
+    ASSERT_EQ("Thread " + std::to_string(t), message);
+    // Per-producer order is preserved.
+    EXPECT_EQ(next_line[t]++, record.line);
+    ++count;
+  }
+  EXPECT_EQ(4000, count);
+}
+
+TEST_F(ShmRingTest, SurvivesProducerCrash) {
+  pid_t pid = fork();
+  ASSERT_GE(pid, 0);
+  if (pid == 0) {
+    ShmRingSink sink(name());
+    Send(sink, "Before the crash");
+    abort();
+  }
+  int status;
+  waitpid(pid, &status, 0);
+  ASSERT_TRUE(WIFSIGNALED(status));
+
+  ShmRingReader reader(name());
+  ASSERT_TRUE(reader.ok());
+  EXPECT_FALSE(reader.producer_alive());
+  EXPECT_EQ(std::vector<std::string>{"Before the crash"}, ReadAll(reader));
+}
+
+// A second producer could mistake the records that the first one has in
+// flight for torn ones, and overwrite them.
+TEST_F(ShmRingTest, RejectsSecondProducer) {
+  {
+    ShmRingSink sink(name(), 4096);
+    ASSERT_TRUE(sink.ok());
+    EXPECT_FALSE(ShmRingSink(name(), 4096).ok());
+    pid_t pid = fork();
+    ASSERT_GE(pid, 0);
+    if (pid == 0) _exit(ShmRingSink(name(), 4096).ok() ? 1 : 0);
+    int status;
+    waitpid(pid, &status, 0);
+    EXPECT_TRUE(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+  }
+  EXPECT_TRUE(ShmRingSink(name(), 4096).ok());
+}
+
+TEST_F(ShmRingTest, RecoversTornRecords) {
+  {
+    ShmRingSink sink(name(), 4096);
+    Send(sink, "Committed");
+  }
+  // Simulates a producer that died after reserving a record, but before
+  // committing it.
+  int fd = shm_open(name(), O_RDWR, 0);
+  ASSERT_GE(fd, 0);
+  void* mem = mmap(nullptr, shm_ring::kDataOffset + 4096,
+                   PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+  auto* header = static_cast<shm_ring::Header*>(mem);
+  header->write_pos.fetch_add(64);
+  header->producer_pid.store(0);
+
+  ShmRingReader reader(name());
+  std::vector<std::string> read = ReadAll(reader);
+  EXPECT_EQ(std::vector<std::string>{"Committed"}, read);
+  EXPECT_EQ(64u, reader.pending());
+
+  ShmRingSink sink(name(), 4096);
+  EXPECT_EQ(1u, sink.dropped());
+  Send(sink, "After recovery");
+  EXPECT_EQ(std::vector<std::string>{"After recovery"}, ReadAll(reader));
+  munmap(mem, shm_ring::kDataOffset + 4096);
+}
+
+}  // namespace
+}  // namespace roo_logging
@@ -0,0 +1,182 @@
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "roo_logging.h"
+#include "roo_logging/socket_sink.h"
+
+namespace roo_logging {
+namespace {
+
+// Plays the role of the aggregator.
+class Receiver {
+ public:
+  explicit Receiver(const std::string& path) : path_(path) {
+    fd_ = socket(AF_UNIX, SOCK_DGRAM, 0);
+    sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, path.c_str());
+    unlink(path.c_str());
+    bind(fd_, (sockaddr*)&addr, sizeof(addr));
+  }
+
+  ~Receiver() {
+    close(fd_);
+    unlink(path_.c_str());
+  }
+
+  // Receives batches until the expected number of messages arrive, or until
+  // nothing arrives for a second.
+  std::vector<std::string> receive(size_t expected) {
+    std::vector<std::string> result;
+    std::vector<uint8_t> buf(256 * 1024);
+    std::vector<socket_batch::Frame> frames;
+    while (result.size() < expected) {
+      pollfd pfd = {fd_, POLLIN, 0};
+      if (poll(&pfd, 1, 1000) <= 0) break;
+      ssize_t len = recv(fd_, buf.data(), buf.size(), 0);
+      socket_batch::BatchHeader header;
+      EXPECT_TRUE(socket_batch::DecodeBatch(buf.data(), len, header, frames));
+      EXPECT_EQ((uint32_t)getpid(), header.pid);
+      dropped = header.dropped;
+      ++batches;
+      for (const auto& frame : frames) {
+        result.emplace_back(frame.message, frame.message_len);
+      }
+    }
+    return result;
+  }
+
+  int batches = 0;
+  uint64_t dropped = 0;
+
+ private:
+  std::string path_;
+  int fd_;
+};
+
+std::string SocketPath() {
+  return "/tmp/roo_logging_test_" + std::to_string(getpid()) + ".sock";
+}
+
+void Send(SocketSink& sink, const std::string& message) {
+  sink.send(ROO_LOGGING_INFO, "/foo/bar.cpp", "bar.cpp", 12,
+            roo_time::Uptime::Now(), roo_time::WallTime(), message.data(),
+            message.size());
+}
+
+TEST(SocketBatch, RoundTrip) {
+  std::vector<uint8_t> batch(sizeof(socket_batch::BatchHeader));
+  socket_batch::BatchHeader header = {socket_batch::kMagic, 123, 4};
+  memcpy(batch.data(), &header, sizeof(header));
+  socket_batch::Frame frame;
+  frame.severity = ROO_LOGGING_ERROR;
+  frame.base_filename = "foo.cpp";
+  frame.base_filename_len = 7;
+  frame.line = 42;
+  frame.uptime = roo_time::Uptime::Start() + roo_time::Micros(5);
+  frame.walltime = roo_time::WallTime(roo_time::Micros(1000000));
+  frame.message = "Hello";
+  frame.message_len = 5;
+  socket_batch::AppendFrame(batch, frame);
+  frame.message = "";
+  frame.message_len = 0;
+  socket_batch::AppendFrame(batch, frame);
+
+  socket_batch::BatchHeader decoded_header;
+  std::vector<socket_batch::Frame> frames;
+  ASSERT_TRUE(socket_batch::DecodeBatch(batch.data(), batch.size(),
+                                        decoded_header, frames));
+  EXPECT_EQ(123u, decoded_header.pid);
+  EXPECT_EQ(4u, decoded_header.dropped);
+  ASSERT_EQ(2u, frames.size());
+  EXPECT_EQ(ROO_LOGGING_ERROR, frames[0].severity);
+  EXPECT_EQ("foo.cpp", std::string(frames[0].base_filename,
+                                    frames[0].base_filename_len));
+  EXPECT_EQ(42, frames[0].line);
+  EXPECT_EQ(5, frames[0].uptime.inMicros());
+  EXPECT_EQ(1000000, frames[0].walltime.sinceEpoch().inMicros());
+  EXPECT_EQ("Hello", std::string(frames[0].message, frames[0].message_len));
+  EXPECT_EQ(0u, frames[1].message_len);
+
+  // Truncated batches are rejected.
+  EXPECT_FALSE(socket_batch::DecodeBatch(batch.data(), batch.size() - 1,
+                                         decoded_header, frames));
+}
+
+TEST(SocketSink, SendsInBatches) {
+  Receiver receiver(SocketPath());
+  SocketSink sink(SocketPath().c_str());
+  ASSERT_TRUE(sink.ok());
+  for (int i = 0; i < 1000; ++i) Send(sink, "Message " + std::to_string(i));
+  sink.WaitTillSent();
+  std::vector<std::string> received = receiver.receive(1000);
+  ASSERT_EQ(1000u, received.size());
+  for (int i = 0; i < 1000; ++i) {
+    EXPECT_EQ("Message " + std::to_string(i), received[i]);
+  }
+  EXPECT_LT(receiver.batches, 100);
+  EXPECT_EQ(0u, sink.dropped());
+}
+
+TEST(SocketSink, FlushesPeriodically) {
+  Receiver receiver(SocketPath());
+  SocketSink sink(SocketPath().c_str(), 64 * 1024, 16 * 1024,
+                  roo_time::Millis(10));
+  Send(sink, "Lonely");
+  EXPECT_EQ(std::vector<std::string>{"Lonely"}, receiver.receive(1));
+}
+
+TEST(SocketSink, ClampsTinyBatch) {
+  Receiver receiver(SocketPath());
+  SocketSink sink(SocketPath().c_str(), 64 * 1024, 16);
+  std::string message(1000, 'x');
+  Send(sink, message);
+  sink.WaitTillSent();
+  std::vector<std::string> received = receiver.receive(1);
+  ASSERT_EQ(1u, received.size());
+  // Cut to fit in a single batch.
+  EXPECT_LT(received[0].size(), SocketSink::kMinBatch);
+  EXPECT_EQ(message.substr(0, received[0].size()), received[0]);
+}
+
+TEST(SocketSink, DropsWhenQueueIsFull) {
+  // No receiver.
+  SocketSink sink(SocketPath().c_str(), 4096);
+  for (int i = 0; i < 1000; ++i) Send(sink, std::string(100, 'x'));
+  EXPECT_GT(sink.dropped(), 0u);
+  sink.WaitTillSent();
+  EXPECT_EQ(1000u, sink.dropped());
+}
+
+TEST(SocketSink, ReportsDrops) {
+  {
+    SocketSink sink(SocketPath().c_str(), 4096);
+    Receiver receiver(SocketPath());
+    for (int i = 0; i < 1000; ++i) Send(sink, std::string(100, 'x'));
+    sink.WaitTillSent();
+    uint64_t dropped = sink.dropped();
+    EXPECT_GT(dropped, 0u);
+    std::vector<std::string> received = receiver.receive(1000 - dropped);
+    EXPECT_EQ(1000u, received.size() + dropped);
+  }
+}
+
+TEST(SocketSink, SendsRemainingOnDestruction) {
+  Receiver receiver(SocketPath());
+  {
+    SocketSink sink(SocketPath().c_str(), 64 * 1024, 16 * 1024,
+                    roo_time::Seconds(100));
+    Send(sink, "Last words");
+  }
+  EXPECT_EQ(std::vector<std::string>{"Last words"}, receiver.receive(1));
+}
+
+}  // namespace
+}  // namespace roo_logging
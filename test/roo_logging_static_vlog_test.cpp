@@ -0,0 +1,44 @@
+// Verbose logging fully determined at compile time (the default; see
+// roo_logging_vlog_test.cpp for the run-time mode).
+#define VLOG_LEVEL 1
+
+#include <sstream>
+#include <string>
+
+#include "gtest/gtest.h"
+#include "roo_logging.h"
+#include "roo_logging/sink.h"
+
+// VLOG(n) is on for n <= VLOG_LEVEL. (Versions before the run-time mode had
+// this reversed.)
+static_assert(VLOG_IS_ON(0), "VLOG(0) must be on");
+static_assert(VLOG_IS_ON(1), "VLOG(VLOG_LEVEL) must be on");
+static_assert(!VLOG_IS_ON(2), "VLOG(VLOG_LEVEL + 1) must be off");
+
+class LogCapture : public roo_logging::LogSink {
+ public:
+  LogCapture() { roo_logging::SetSink(this); }
+  ~LogCapture() { roo_logging::SetSink(nullptr); }
+  std::string str() const { return ss_.str(); }
+
+  void send(roo_logging::LogSeverity severity, const char* full_filename,
+            const char* base_filename, int line, roo_time::Uptime uptime,
+            roo_time::WallTime walltime, const char* message,
+            size_t message_len) override {
+    ss_.write(message, message_len);
+    ss_ << "\n";
+  }
+
+ private:
+  std::stringstream ss_;
+};
+
+TEST(StaticVLog, LogsUpToVlogLevel) {
+  LogCapture capture;
+  VLOG(0) << "v0";
+  VLOG(1) << "v1";
+  VLOG(2) << "v2";
+  VLOG_IF(1, true) << "if v1";
+  VLOG_IF(2, true) << "if v2";
+  EXPECT_EQ("v0\nv1\nif v1\n", capture.str());
+}
@@ -1,11 +1,22 @@
 #include "roo_logging.h"
 
 #include "gtest/gtest.h"
+#include "roo_logging/dedup.h"
+#include "roo_logging/dtoa.h"
+#include "roo_logging/encoders.h"
+#include "roo_logging/itoa.h"
 #include "roo_logging/sink.h"
+#include "roo_logging/timestamp.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
 
 // Helper to capture log output.
 #include <sstream>
 #include <string>
+#include <vector>
 
 struct StaticLogTest {
   StaticLogTest() { LOG(INFO) << "Foo"; }
@@ -185,3 +196,583 @@ TEST(Check, CheckGeFails) {
   SUCCEED();
 #endif
 }
+
+static int CountOccurrences(const std::string& s, const std::string& what) {
+  int count = 0;
+  for (size_t pos = s.find(what); pos != std::string::npos;
+       pos = s.find(what, pos + 1)) {
+    ++count;
+  }
+  return count;
+}
+
+TEST(Logging, RepeatedMessagesAreCollapsed) {
+  SET_ROO_FLAG(roo_logging_dedup, true);
+  LogCapture capture;
+  for (int i = 0; i < 5; ++i) {
+    LOG(WARNING) << "Sensor error";
+  }
+  LOG(INFO) << "Recovered";
+  SET_ROO_FLAG(roo_logging_dedup, false);
+  std::string output = capture.str();
+  EXPECT_EQ(1, CountOccurrences(output, "Sensor error"));
+  size_t summary = output.find("Last message repeated 4 times");
+  ASSERT_NE(summary, std::string::npos);
+  EXPECT_LT(summary, output.find("Recovered"));
+}
+
+TEST(Logging, RepeatSummaryNotLostWhenDedupTurnedOff) {
+  SET_ROO_FLAG(roo_logging_dedup, true);
+  LogCapture capture;
+  for (int i = 0; i < 3; ++i) {
+    LOG(WARNING) << "Sensor error";
+  }
+  SET_ROO_FLAG(roo_logging_dedup, false);
+  LOG(INFO) << "Recovered";
+  std::string output = capture.str();
+  size_t summary = output.find("Last message repeated 2 times");
+  ASSERT_NE(summary, std::string::npos);
+  EXPECT_LT(summary, output.find("Recovered"));
+}
+
+TEST(Logging, FlushesRepeatSummary) {
+  SET_ROO_FLAG(roo_logging_dedup, true);
+  LogCapture capture;
+  for (int i = 0; i < 3; ++i) {
+    LOG(WARNING) << "Sensor error";
+  }
+  // Within the window.
+  roo_logging::FlushRepeatedMessages();
+  EXPECT_EQ(std::string::npos, capture.str().find("Last message repeated"));
+  roo_logging::FlushRepeatedMessages(true);
+  EXPECT_NE(std::string::npos,
+            capture.str().find("Last message repeated 2 times"));
+  SET_ROO_FLAG(roo_logging_dedup, false);
+}
+
+// Messages are compared by content, not by hash.
+TEST(Logging, DifferentMessagesAreNotCollapsed) {
+  SET_ROO_FLAG(roo_logging_dedup, true);
+  LogCapture capture;
+  // A pair of distinct strings with the same 32-bit FNV-1a hash.
+  LOG(INFO) << "costarring";
+  LOG(INFO) << "liquid";
+  std::string long_message(ROO_LOGGING_DEDUP_MAX_LEN + 1, 'x');
+  LOG(INFO) << long_message;
+  LOG(INFO) << long_message;
+  SET_ROO_FLAG(roo_logging_dedup, false);
+  std::string output = capture.str();
+  EXPECT_EQ(1, CountOccurrences(output, "costarring"));
+  EXPECT_EQ(1, CountOccurrences(output, "liquid"));
+  // Too long to compare; never collapsed.
+  EXPECT_EQ(2, CountOccurrences(output, long_message));
+}
+
+TEST(Logging, RepeatsFromOtherSitesOnlyCollapsedWithinWindow) {
+  SET_ROO_FLAG(roo_logging_dedup, true);
+  SET_ROO_FLAG(roo_logging_dedup_window_ms, 0);
+  LogCapture capture;
+  LOG(INFO) << "Same text";
+  LOG(INFO) << "Same text";
+  SET_ROO_FLAG(roo_logging_dedup_window_ms, ROO_LOGGING_DEDUP_WINDOW_MS);
+  SET_ROO_FLAG(roo_logging_dedup, false);
+  EXPECT_EQ(2, CountOccurrences(capture.str(), "Same text"));
+}
+
+static_assert(roo_logging::BasenameOffset("src/foo/bar.cpp", 15) == 8, "");
+static_assert(roo_logging::BasenameOffset("bar.cpp", 7) == 0, "");
+static_assert(roo_logging::BasenameOffset("/foo/", 5) == 5, "");
+
+TEST(Logging, CallSitesAreStatic) {
+  const roo_logging::LogSite* sites[2];
+  for (int i = 0; i < 2; ++i) {
+    sites[i] = ROO_LOGGING_SITE(roo_logging::ROO_LOGGING_WARNING);
+  }
+  const roo_logging::LogSite* other =
+      ROO_LOGGING_SITE(roo_logging::ROO_LOGGING_WARNING);
+  EXPECT_EQ(sites[0], sites[1]);
+  EXPECT_NE(sites[0]->id(), other->id());
+  EXPECT_EQ(sites[0]->line + 3, other->line);
+  EXPECT_STREQ(__FILE__, sites[0]->fullname());
+  EXPECT_STREQ("roo_logging_test.cpp", sites[0]->basename());
+  EXPECT_EQ(roo_logging::ROO_LOGGING_WARNING, sites[0]->severity);
+}
+
+TEST(Logging, MessagesCarryTheirCallSite) {
+  LogCapture capture;
+  int line = __LINE__ + 1;
+  LOG(ERROR) << "From a static site";
+  EXPECT_NE(std::string::npos,
+            capture.str().find(std::string(__FILE__) + ":" +
+                               std::to_string(line) + ": From a static site"));
+
+  roo_logging::LogMessage message("foo/bar.cpp", 42, roo_logging::WARNING);
+  EXPECT_STREQ("foo/bar.cpp", message.site().fullname());
+  EXPECT_STREQ("bar.cpp", message.site().basename());
+  EXPECT_EQ(42, message.site().line);
+  EXPECT_EQ(roo_logging::WARNING, message.site().severity);
+}
+
+class StructuredCapture : public roo_logging::LogSink {
+ public:
+  StructuredCapture() { roo_logging::SetSink(this); }
+  ~StructuredCapture() { roo_logging::SetSink(nullptr); }
+
+  void send(roo_logging::LogSeverity severity, const char* full_filename,
+            const char* base_filename, int line, roo_time::Uptime uptime,
+            roo_time::WallTime walltime, const char* message,
+            size_t message_len) override {
+    text = std::string(message, message_len);
+  }
+
+  void sendRecord(const roo_logging::LogRecord& record) override {
+    roo_logging::OStringStream json;
+    roo_logging::EncodeJson(json, record.message, record.message_len,
+                            record.fields);
+    json_ = std::string(json.buf_, json.pcount());
+    roo_logging::OStringStream logfmt;
+    roo_logging::EncodeLogfmt(logfmt, record.message, record.message_len,
+                              record.fields);
+    logfmt_ = std::string(logfmt.buf_, logfmt.pcount());
+    keys.clear();
+    for (const roo_logging::LogField& field : record.fields) {
+      keys.push_back(std::string(field.key.data(), field.key.size()));
+    }
+    roo_logging::LogSink::sendRecord(record);
+  }
+
+  std::string text;
+  std::vector<std::string> keys;
+  std::string json_;
+  std::string logfmt_;
+};
+
+TEST(Logging, StructuredFields) {
+  StructuredCapture capture;
+  LOG(INFO).kv("temp", 21.5).kv("id", 7).kv("ok", true).kv("name",
+                                                           "living room")
+      << "Reading";
+  EXPECT_EQ("Reading temp=21.5 id=7 ok=true name=\"living room\"",
+            capture.text);
+  EXPECT_EQ(
+      "{\"msg\":\"Reading\",\"temp\":21.5,\"id\":7,\"ok\":true,"
+      "\"name\":\"living room\"}",
+      capture.json_);
+  EXPECT_EQ("msg=\"Reading\" temp=21.5 id=7 ok=true name=\"living room\"",
+            capture.logfmt_);
+}
+
+TEST(Logging, StructuredFieldKeysAreQuotedIfNeeded) {
+  StructuredCapture capture;
+  LOG(INFO).kv("a b", 1).kv("x=y", "z").kv("", 2) << "Keys";
+  EXPECT_EQ("Keys \"a b\"=1 \"x=y\"=z \"\"=2", capture.text);
+  EXPECT_EQ("msg=\"Keys\" \"a b\"=1 \"x=y\"=z \"\"=2", capture.logfmt_);
+}
+
+TEST(Logging, StructuredFieldsOnly) {
+  StructuredCapture capture;
+  LOG(INFO).kv("count", -3).kv("big", 18446744073709551615ull);
+  EXPECT_EQ("count=-3 big=18446744073709551615", capture.text);
+}
+
+TEST(Logging, SampledLogging) {
+  LogCapture capture;
+  for (int i = 0; i < 10000; ++i) {
+    LOG_SAMPLED(INFO, 0.1) << "Sampled";
+  }
+  // Expected 1000, with the standard deviation of 30.
+  int count = CountOccurrences(capture.str(), "Sampled sample_rate=0.1");
+  EXPECT_GT(count, 700);
+  EXPECT_LT(count, 1300);
+}
+
+TEST(Logging, SampledLoggingBounds) {
+  LogCapture capture;
+  for (int i = 0; i < 1000; ++i) {
+    LOG_SAMPLED(INFO, 0) << "Never";
+    LOG_SAMPLED(INFO, 1) << "Always";
+    LOG_IF_SAMPLED(INFO, false, 1) << "Not when false";
+    VLOG_SAMPLED(100, 1) << "Not when verbose";
+  }
+  EXPECT_EQ(0, CountOccurrences(capture.str(), "Never"));
+  EXPECT_EQ(1000, CountOccurrences(capture.str(), "Always"));
+  EXPECT_EQ(0, CountOccurrences(capture.str(), "Not when"));
+  EXPECT_EQ(0u, roo_logging::internal::SamplingThreshold(-1));
+  EXPECT_EQ(0u, roo_logging::internal::SamplingThreshold(0));
+  EXPECT_EQ(0x80000000u, roo_logging::internal::SamplingThreshold(0.5));
+  EXPECT_EQ(UINT32_MAX, roo_logging::internal::SamplingThreshold(1));
+  EXPECT_EQ(UINT32_MAX, roo_logging::internal::SamplingThreshold(2));
+}
+
+TEST(Logging, SampleRateIsAStructuredField) {
+  StructuredCapture capture;
+  LOG_SAMPLED(WARNING, 1.0) << "Packet";
+  EXPECT_EQ("Packet sample_rate=1", capture.text);
+  ASSERT_EQ(1u, capture.keys.size());
+  EXPECT_EQ("sample_rate", capture.keys[0]);
+}
+
+TEST(Logging, StructuredFieldsDoNotOverflow) {
+  StructuredCapture capture;
+  std::string big(2000, 'x');
+  LOG(INFO).kv("a", 1).kv("big", big).kv("b", 2) << big;
+  EXPECT_LE(capture.text.size(), roo_logging::kMaxLogMessageLen);
+  EXPECT_EQ((std::vector<std::string>{"a", "big", "b"}), capture.keys);
+}
+
+template <typename T>
+std::string FormatToString(const T& val) {
+  roo_logging::OStringStream s;
+  s << val;
+  return std::string(s.buf_, s.pcount());
+}
+
+TEST(Logging, FloatingPointFormatting) {
+  EXPECT_EQ("0", FormatToString(0.0));
+  EXPECT_EQ("-0", FormatToString(-0.0));
+  EXPECT_EQ("21.5", FormatToString(21.5));
+  EXPECT_EQ("0.1", FormatToString(0.1));
+  EXPECT_EQ("0.1", FormatToString(0.1f));
+  EXPECT_EQ("0.3333333333333333", FormatToString(1.0 / 3));
+  EXPECT_EQ("0.33333334", FormatToString(1.0f / 3));
+  EXPECT_EQ("1234567", FormatToString(1234567.0));
+  EXPECT_EQ("0.0001", FormatToString(0.0001));
+  EXPECT_EQ("1e-05", FormatToString(0.00001));
+  EXPECT_EQ("1e+20", FormatToString(1e20));
+  EXPECT_EQ("-1.5e+300", FormatToString(-1.5e300));
+  EXPECT_EQ("5e-324", FormatToString(5e-324));
+  EXPECT_EQ("1.7976931348623157e+308", FormatToString(1.7976931348623157e308));
+  EXPECT_EQ("3.4028235e+38", FormatToString(3.4028235e38f));
+  EXPECT_EQ("nan", FormatToString(NAN));
+  EXPECT_EQ("inf", FormatToString(INFINITY));
+  EXPECT_EQ("-inf", FormatToString(-INFINITY));
+}
+
+TEST(Logging, FixedPrecision) {
+  roo_logging::OStringStream s;
+  s << roo_logging::fixed(2) << 21.5 << " " << 3.14159 << " " << 9.996 << " "
+    << -0.001 << " " << 0.0 << " " << roo_logging::fixed(0) << 2.5 << " "
+    << roo_logging::shortest << 3.14159;
+  EXPECT_EQ("21.50 3.14 10.00 -0.00 0.00 3 3.14159",
+            std::string(s.buf_, s.pcount()));
+}
+
+TEST(Logging, FloatingPointRoundTrip) {
+  // Deterministic xorshift, covering the whole range of bit patterns.
+  uint64_t x = 88172645463325252ull;
+  char buf[roo_logging::kMaxFloatChars + 1];
+  for (int i = 0; i < 200000; ++i) {
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    double d;
+    memcpy(&d, &x, sizeof(d));
+    if (isfinite(d)) {
+      buf[roo_logging::FormatDouble(d, buf)] = '\0';
+      ASSERT_EQ(d, strtod(buf, nullptr)) << buf;
+    }
+    uint32_t bits = (uint32_t)x;
+    float f;
+    memcpy(&f, &bits, sizeof(f));
+    if (isfinite(f)) {
+      buf[roo_logging::FormatFloat(f, buf)] = '\0';
+      ASSERT_EQ(f, strtof(buf, nullptr)) << buf;
+    }
+  }
+}
+
+TEST(Logging, IntegerFormatting) {
+  roo_logging::OStringStream s;
+  s << 0 << " " << -7 << " " << 1234567890 << " " << (-2147483647 - 1) << " "
+    << 18446744073709551615ull << " " << (-9223372036854775807ll - 1) << " "
+    << (short)-300 << " " << (unsigned short)65535 << " "
+    << roo_logging::hex << 255 << " " << 0x123456789abcdefull << " "
+    << roo_logging::bin << 5 << " " << 0 << " " << roo_logging::oct << 64;
+  EXPECT_EQ(
+      "0 -7 1234567890 -2147483648 18446744073709551615 "
+      "-9223372036854775808 -300 65535 FF 123456789ABCDEF 101 0 100",
+      std::string(s.buf_, s.pcount()));
+}
+
+TEST(Logging, IntegerFormattingRoundTrip) {
+  uint64_t x = 88172645463325252ull;
+  char buf[roo_logging::kMaxIntegerChars + 1];
+  for (int i = 0; i < 100000; ++i) {
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    // Cover all magnitudes.
+    uint64_t n = x >> (i % 64);
+    for (int base : {2, 3, 8, 10, 16, 36}) {
+      buf[roo_logging::FormatInteger(n, false, base, buf)] = '\0';
+      ASSERT_EQ(n, strtoull(buf, nullptr, base)) << buf;
+      ASSERT_EQ(strlen(buf), (size_t)roo_logging::CountDigits(n, base));
+    }
+  }
+}
+
+#if !defined(ARDUINO)
+
+TEST(Logging, PointerFormatting) {
+  roo_logging::OStringStream s;
+  s << (const void*)0x1234abcd << " " << nullptr << " " << roo_logging::hex
+    << -1 << " " << -1ll;
+  EXPECT_EQ("0x1234abcd 0x0 FFFFFFFF FFFFFFFFFFFFFFFF",
+            std::string(s.buf_, s.pcount()));
+}
+
+#endif
+
+TEST(Logging, LongMessagesAreSilentlyCutByDefault) {
+  StructuredCapture capture;
+  int64_t truncated = roo_logging::LogMessage::num_truncated_messages();
+  LOG(INFO) << std::string(2000, 'x');
+  EXPECT_EQ(std::string::npos, capture.text.find("truncated"));
+  EXPECT_GT(roo_logging::kMaxLogMessageLen, capture.text.size());
+  EXPECT_EQ(truncated + 1, roo_logging::LogMessage::num_truncated_messages());
+}
+
+TEST(Logging, LongMessagesSpill) {
+  SET_ROO_FLAG(roo_logging_overflow_limit, 4096);
+  StructuredCapture capture;
+  int64_t truncated = roo_logging::LogMessage::num_truncated_messages();
+  std::string big(3000, 'x');
+  LOG(INFO).kv("id", 7) << big << " " << 42;
+  EXPECT_EQ(big + " 42 id=7", capture.text);
+
+  LOG(INFO) << "Short";
+  EXPECT_EQ("Short", capture.text);
+  EXPECT_EQ(truncated, roo_logging::LogMessage::num_truncated_messages());
+  SET_ROO_FLAG(roo_logging_overflow_limit, 0);
+}
+
+TEST(Logging, TruncationMarker) {
+  SET_ROO_FLAG(roo_logging_overflow_limit, 2048);
+  StructuredCapture capture;
+  int64_t truncated = roo_logging::LogMessage::num_truncated_messages();
+  LOG(INFO) << std::string(5000, 'x');
+  const std::string marker = "...[truncated ";
+  size_t pos = capture.text.rfind(marker);
+  ASSERT_NE(std::string::npos, pos);
+  // The dropped characters and the marker add up to the original message.
+  size_t dropped = strtoul(capture.text.c_str() + pos + marker.size(), nullptr,
+                           10);
+  EXPECT_EQ(5000u, pos + dropped);
+  EXPECT_EQ(" bytes]", capture.text.substr(capture.text.size() - 7));
+  EXPECT_EQ(truncated + 1, roo_logging::LogMessage::num_truncated_messages());
+  SET_ROO_FLAG(roo_logging_overflow_limit, 0);
+}
+
+// Takes the specified time to send each message.
+class SlowSink : public LogCapture {
+ public:
+  void send(roo_logging::LogSeverity severity, const char* full_filename,
+            const char* base_filename, int line, roo_time::Uptime uptime,
+            roo_time::WallTime walltime, const char* message,
+            size_t message_len) override {
+    roo_time::Uptime start = roo_time::Uptime::Now();
+    while (roo_time::Uptime::Now() - start < delay) {
+    }
+    ++sent;
+    LogCapture::send(severity, full_filename, base_filename, line, uptime,
+                     walltime, message, message_len);
+  }
+
+  roo_time::Duration delay;
+  int sent = 0;
+};
+
+TEST(Logging, StalledSinkIsBypassedAndRetried) {
+  SET_ROO_FLAG(roo_logging_sink_latency_budget_ms, 5);
+  SET_ROO_FLAG(roo_logging_sink_retry_ms, 20);
+  SlowSink sink;
+  sink.delay = roo_time::Millis(10);
+  for (int i = 0; i < 10; ++i) LOG(INFO) << "Slow";
+  // Tripped after the third slow send.
+  EXPECT_EQ(3, sink.sent);
+  roo_logging::SinkHealth health = roo_logging::GetSinkHealth();
+  EXPECT_TRUE(health.tripped);
+  EXPECT_EQ(1u, health.trips);
+  EXPECT_EQ(7u, health.dropped);
+  EXPECT_GE(health.max_latency, roo_time::Millis(10));
+  // Warnings are dropped, but errors still get through to a stalled sink.
+  LOG(WARNING) << "Dropped";
+  EXPECT_EQ(3, sink.sent);
+  LOG(ERROR) << "Error";
+  EXPECT_EQ(4, sink.sent);
+  EXPECT_TRUE(roo_logging::GetSinkHealth().tripped);
+
+  // After the backoff, the next message is a probe.
+  sink.delay = roo_time::Duration();
+  roo_time::Uptime start = roo_time::Uptime::Now();
+  while (roo_time::Uptime::Now() - start < roo_time::Millis(25)) {
+  }
+  LOG(INFO) << "Fast";
+  EXPECT_FALSE(roo_logging::GetSinkHealth().tripped);
+  std::string output = sink.str();
+  EXPECT_NE(std::string::npos, output.find("Fast"));
+  EXPECT_NE(std::string::npos,
+            output.find("Log sink recovered; 8 messages dropped"));
+  SET_ROO_FLAG(roo_logging_sink_latency_budget_ms,
+               ROO_LOGGING_SINK_LATENCY_BUDGET_MS);
+  SET_ROO_FLAG(roo_logging_sink_retry_ms, ROO_LOGGING_SINK_RETRY_MS);
+}
+
+TEST(Logging, FlagChangesArePublished) {
+  LogCapture capture;
+  uint32_t generation = roo_logging::ConfigRef()->generation;
+  SET_ROO_FLAG(roo_logging_minloglevel, 2);
+  EXPECT_EQ(generation + 1, roo_logging::ConfigRef()->generation);
+  LOG(WARNING) << "Suppressed";
+  LOG(ERROR) << "Logged";
+  SET_ROO_FLAG(roo_logging_minloglevel, 0);
+  EXPECT_EQ(std::string::npos, capture.str().find("Suppressed"));
+  EXPECT_NE(std::string::npos, capture.str().find("Logged"));
+}
+
+TEST(Logging, PinnedConfigIsNotReused) {
+  roo_logging::ConfigRef pinned;
+  uint32_t generation = pinned->generation;
+  for (int i = 0; i < 10; ++i) {
+    SET_ROO_FLAG(roo_logging_overflow_limit, 2000 + i);
+    EXPECT_EQ(2000u + i, roo_logging::ConfigRef()->overflow_limit);
+  }
+  SET_ROO_FLAG(roo_logging_overflow_limit, ROO_LOGGING_OVERFLOW_LIMIT);
+  EXPECT_EQ(generation, pinned->generation);
+  EXPECT_EQ((uint32_t)ROO_LOGGING_OVERFLOW_LIMIT, pinned->overflow_limit);
+}
+
+TEST(Logging, MessageKeepsItsConfig) {
+  LogCapture capture;
+  {
+    roo_logging::LogMessage message(__FILE__, __LINE__, roo_logging::WARNING);
+    message.stream() << "Logged";
+    // Changes made while the message is open don't affect it, even after
+    // several publications.
+    for (int i = 0; i < 10; ++i) SET_ROO_FLAG(roo_logging_minloglevel, 2);
+  }
+  LOG(WARNING) << "Suppressed";
+  SET_ROO_FLAG(roo_logging_minloglevel, 0);
+  EXPECT_NE(std::string::npos, capture.str().find("Logged"));
+  EXPECT_EQ(std::string::npos, capture.str().find("Suppressed"));
+}
+
+class SequenceCapture : public LogCapture {
+ public:
+  void sendRecord(const roo_logging::LogRecord& record) override {
+    sequences.push_back(record.sequence);
+    LogCapture::sendRecord(record);
+  }
+
+  std::vector<uint64_t> sequences;
+};
+
+TEST(Logging, SequenceNumbersFollowCreationOrder) {
+  SequenceCapture capture;
+  {
+    roo_logging::LogMessage first(__FILE__, __LINE__, roo_logging::INFO);
+    roo_logging::LogMessage second(__FILE__, __LINE__, roo_logging::INFO);
+    first.stream() << "First";
+    second.stream() << "Second";
+    EXPECT_EQ(first.sequence() + 1, second.sequence());
+    // Sent in the opposite order, by the destructors.
+  }
+  ASSERT_EQ(2u, capture.sequences.size());
+  EXPECT_EQ(capture.sequences[0], capture.sequences[1] + 1);
+}
+
+TEST(Logging, SequenceNumberInPrefix) {
+  SET_ROO_FLAG(roo_logging_log_sequence, true);
+  roo_logging::LogMessage message(__FILE__, __LINE__, roo_logging::INFO);
+  SET_ROO_FLAG(roo_logging_log_sequence, false);
+  std::string prefix(message.stream().buf_, message.stream().pcount());
+  std::string expected = " #" + std::to_string(message.sequence()) + " ";
+  EXPECT_NE(std::string::npos, prefix.find(expected)) << prefix;
+}
+
+// Wall time that runs with the uptime, from a fixed epoch offset.
+class TestClock : public roo_time::WallTimeClock {
+ public:
+  roo_time::WallTime now() const override {
+    return roo_time::WallTime(roo_time::Hours(24 * 365 * 50) +
+                              (roo_time::Uptime::Now() -
+                               roo_time::Uptime::Start()));
+  }
+};
+
+class UptimeCapture : public LogCapture {
+ public:
+  void send(roo_logging::LogSeverity severity, const char* full_filename,
+            const char* base_filename, int line, roo_time::Uptime uptime,
+            roo_time::WallTime walltime, const char* message,
+            size_t message_len) override {
+    uptimes.push_back(uptime);
+    walltimes.push_back(walltime);
+  }
+
+  std::vector<roo_time::Uptime> uptimes;
+  std::vector<roo_time::WallTime> walltimes;
+};
+
+TEST(Logging, TimestampSources) {
+  TestClock clock;
+  SET_ROO_FLAG(roo_logging_wall_time_clock, &clock);
+  for (uint8_t source : {roo_logging::TIMESTAMP_PRECISE,
+                         roo_logging::TIMESTAMP_COARSE,
+                         roo_logging::TIMESTAMP_CYCLES}) {
+    SET_ROO_FLAG(roo_logging_timestamp_source, source);
+    UptimeCapture capture;
+    roo_time::Uptime start = roo_time::Uptime::Now();
+    roo_time::WallTime wall_start = clock.now();
+    // Spans the initial calibration of the cycle counter.
+    for (int i = 0; i < 30; ++i) {
+      LOG(INFO) << "Message";
+      usleep(1000);
+    }
+    roo_time::Uptime end = roo_time::Uptime::Now();
+    ASSERT_EQ(30u, capture.uptimes.size());
+    for (size_t i = 0; i < capture.uptimes.size(); ++i) {
+      // Coarse clocks may lag by a few milliseconds.
+      EXPECT_GE(capture.uptimes[i].inMicros(), start.inMicros() - 20000)
+          << "source " << (int)source;
+      EXPECT_LE(capture.uptimes[i].inMicros(), end.inMicros() + 20000)
+          << "source " << (int)source;
+      // The wall time follows the uptime.
+      EXPECT_NEAR(capture.walltimes[i].sinceEpoch().inMicros() -
+                      wall_start.sinceEpoch().inMicros(),
+                  capture.uptimes[i].inMicros() - start.inMicros(), 1000)
+          << "source " << (int)source;
+    }
+    EXPECT_GT(capture.uptimes.back(), capture.uptimes.front());
+  }
+  SET_ROO_FLAG(roo_logging_timestamp_source,
+                       ROO_LOGGING_TIMESTAMP_SOURCE);
+  SET_ROO_FLAG(roo_logging_wall_time_clock, nullptr);
+}
+
+class CountingClock : public TestClock {
+ public:
+  roo_time::WallTime now() const override {
+    ++calls;
+    return TestClock::now();
+  }
+
+  mutable int calls = 0;
+};
+
+// The prefix and the sink get the same wall time, read once per message.
+TEST(Logging, ReadsWallTimeClockOnce) {
+  CountingClock clock;
+  SET_ROO_FLAG(roo_logging_wall_time_clock, &clock);
+  SET_ROO_FLAG(roo_logging_timestamp_source,
+                       roo_logging::TIMESTAMP_PRECISE);
+  {
+    UptimeCapture capture;
+    LOG(INFO) << "Message";
+    EXPECT_EQ(1, clock.calls);
+    ASSERT_EQ(1u, capture.walltimes.size());
+  }
+  SET_ROO_FLAG(roo_logging_timestamp_source,
+                       ROO_LOGGING_TIMESTAMP_SOURCE);
+  SET_ROO_FLAG(roo_logging_wall_time_clock, nullptr);
+}
@@ -0,0 +1,92 @@
+#define ROO_LOGGING_RUNTIME_VLOG 1
+#define VLOG_LEVEL 1
+#define MLOG_test_module 0
+#define MLOG_test_other 1
+
+#include <sstream>
+#include <string>
+
+#include "gtest/gtest.h"
+#include "roo_logging.h"
+#include "roo_logging/sink.h"
+
+class LogCapture : public roo_logging::LogSink {
+ public:
+  LogCapture() { roo_logging::SetSink(this); }
+  ~LogCapture() { roo_logging::SetSink(nullptr); }
+  std::string str() const { return ss_.str(); }
+
+  void send(roo_logging::LogSeverity severity, const char* full_filename,
+            const char* base_filename, int line, roo_time::Uptime uptime,
+            roo_time::WallTime walltime, const char* message,
+            size_t message_len) override {
+    ss_.write(message, message_len);
+    ss_ << "\n";
+  }
+
+ private:
+  std::stringstream ss_;
+};
+
+class VLogTest : public testing::Test {
+ protected:
+  void TearDown() override { roo_logging::ResetVLOGLevels(); }
+};
+
+TEST_F(VLogTest, CompileTimeDefaults) {
+  LogCapture capture;
+  VLOG(1) << "v1";
+  VLOG(2) << "v2";
+  MLOG(test_module) << "m";
+  MLOG(test_other) << "o";
+  EXPECT_EQ("v1\no\n", capture.str());
+}
+
+TEST_F(VLogTest, SetByFileBaseName) {
+  LogCapture capture;
+  EXPECT_EQ(-1, roo_logging::SetVLOGLevel("roo_logging_vlog_*", 3));
+  VLOG(3) << "v3";
+  VLOG(4) << "v4";
+  EXPECT_EQ(3, roo_logging::SetVLOGLevel("roo_logging_vlog_*", 0));
+  VLOG(1) << "v1";
+  EXPECT_EQ("v3\n", capture.str());
+}
+
+TEST_F(VLogTest, SetByPath) {
+  LogCapture capture;
+  roo_logging::SetVLOGLevel("*/test/*", 2);
+  VLOG(2) << "v2";
+  roo_logging::SetVLOGLevel("*/other/*", 5);
+  VLOG(2) << "still v2";
+  EXPECT_EQ("v2\nstill v2\n", capture.str());
+}
+
+TEST_F(VLogTest, MostRecentPatternWins) {
+  LogCapture capture;
+  roo_logging::SetVLOGLevel("*", 0);
+  roo_logging::SetVLOGLevel("roo_logging_vlog_test", 2);
+  VLOG(2) << "on";
+  roo_logging::SetVLOGLevel("*", 0);
+  VLOG(2) << "off";
+  EXPECT_EQ("on\n", capture.str());
+}
+
+TEST_F(VLogTest, SetModule) {
+  LogCapture capture;
+  roo_logging::SetMLOGLevel("test_mod*", 1);
+  roo_logging::SetMLOGLevel("test_other", 0);
+  MLOG(test_module) << "m";
+  MLOG(test_other) << "o";
+  EXPECT_TRUE(MLOG_IS_ON(test_module));
+  EXPECT_EQ("m\n", capture.str());
+}
+
+TEST_F(VLogTest, Reset) {
+  LogCapture capture;
+  roo_logging::SetVLOGLevel("*", 5);
+  roo_logging::SetMLOGLevel("*", 1);
+  roo_logging::ResetVLOGLevels();
+  VLOG(2) << "v2";
+  MLOG(test_module) << "m";
+  EXPECT_EQ("", capture.str());
+}
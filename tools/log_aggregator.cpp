@@ -0,0 +1,166 @@
+// Receives log batches from many processes (see roo_logging::SocketSink), on a
+// Unix datagram socket, and writes them to a single file (or stdout), merged
+// in timestamp order.
+//
+// Usage: log_aggregator [-o FILE] [-w WINDOW_MS] SOCKET_PATH
+//
+//   -o FILE       Append to FILE instead of writing to stdout.
+//   -w WINDOW_MS  How long records are held back, so that records that arrive
+//                 late (e.g. in a batch of another process) can still be put
+//                 in order. Default: 200.
+//
+// Runs until SIGINT or SIGTERM, then writes out what it holds, and exits.
+
+#include <errno.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "roo_logging.h"
+#include "roo_logging/log_line.h"
+#include "roo_logging/socket_sink.h"
+
+namespace {
+
+volatile sig_atomic_t stop = 0;
+
+void OnSignal(int) { stop = 1; }
+
+void Usage() {
+  fprintf(stderr, "Usage: log_aggregator [-o FILE] [-w WINDOW_MS] SOCKET\n");
+  exit(2);
+}
+
+int64_t RealTimeNowUs() {
+  timespec ts;
+  clock_gettime(CLOCK_REALTIME, &ts);
+  return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+std::string FormatFrame(uint32_t pid,
+                        const roo_logging::socket_batch::Frame& f) {
+  // The process ID goes where the thread name goes in a log line.
+  char prefix[160];
+  size_t prefix_len = roo_logging::FormatLogPrefix(
+      prefix, sizeof(prefix), f.severity, f.uptime, f.walltime, 0,
+      std::to_string(pid).c_str(), f.base_filename, f.base_filename_len,
+      f.line);
+  std::string line(prefix, prefix_len);
+  line.append(f.message, f.message_len);
+  line += "\n";
+  return line;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  const char* output = nullptr;
+  int64_t window_us = 200000;
+  int opt;
+  while ((opt = getopt(argc, argv, "o:w:")) != -1) {
+    switch (opt) {
+      case 'o':
+        output = optarg;
+        break;
+      case 'w':
+        window_us = atoll(optarg) * 1000;
+        break;
+      default:
+        Usage();
+    }
+  }
+  if (optind != argc - 1) Usage();
+  const char* path = argv[optind];
+
+  FILE* out = stdout;
+  if (output != nullptr) {
+    out = fopen(output, "a");
+    if (out == nullptr) {
+      perror(output);
+      return 1;
+    }
+  }
+
+  int fd = socket(AF_UNIX, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+  sockaddr_un addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  if (strlen(path) >= sizeof(addr.sun_path)) {
+    fprintf(stderr, "%s: path too long\n", path);
+    return 1;
+  }
+  strcpy(addr.sun_path, path);
+  unlink(path);
+  if (fd < 0 || bind(fd, (sockaddr*)&addr, sizeof(addr)) != 0) {
+    perror(path);
+    return 1;
+  }
+  int rcvbuf = 4 * 1024 * 1024;
+  setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf));
+
+  signal(SIGINT, OnSignal);
+  signal(SIGTERM, OnSignal);
+
+  // Records held back for ordering, keyed by wall time. Records with equal
+  // timestamps stay in arrival order.
+  std::multimap<int64_t, std::string> pending;
+  std::map<uint32_t, uint64_t> dropped_by_pid;
+  std::vector<uint8_t> buf(256 * 1024);
+  std::vector<roo_logging::socket_batch::Frame> frames;
+  while (!stop) {
+    pollfd pfd = {fd, POLLIN, 0};
+    int ready = poll(&pfd, 1, 50);
+    if (ready > 0) {
+      while (true) {
+        ssize_t len = recv(fd, buf.data(), buf.size(), MSG_DONTWAIT);
+        if (len < 0) break;
+        roo_logging::socket_batch::BatchHeader header;
+        if (!roo_logging::socket_batch::DecodeBatch(buf.data(), len, header,
+                                                     frames)) {
+          fprintf(stderr, "Malformed batch of %zd bytes\n", len);
+          continue;
+        }
+        for (const auto& frame : frames) {
+          pending.emplace(frame.walltime.sinceEpoch().inMicros(),
+                          FormatFrame(header.pid, frame));
+        }
+        uint64_t& dropped = dropped_by_pid[header.pid];
+        if (header.dropped > dropped) {
+          pending.emplace(RealTimeNowUs(),
+                          "[" + std::to_string(header.pid) + ": " +
+                              std::to_string(header.dropped - dropped) +
+                              " records dropped]\n");
+          dropped = header.dropped;
+        }
+      }
+    } else if (ready < 0 && errno != EINTR) {
+      perror("poll");
+      break;
+    }
+    int64_t horizon = RealTimeNowUs() - window_us;
+    auto end = pending.upper_bound(horizon);
+    for (auto it = pending.begin(); it != end; ++it) {
+      fputs(it->second.c_str(), out);
+    }
+    if (pending.begin() != end) {
+      pending.erase(pending.begin(), end);
+      fflush(out);
+    }
+  }
+  for (const auto& entry : pending) fputs(entry.second.c_str(), out);
+  fflush(out);
+  if (out != stdout) fclose(out);
+  close(fd);
+  unlink(path);
+  return 0;
+}
@@ -0,0 +1,60 @@
+// Decompresses log files written by roo_logging::CompressedFileSink, and
+// writes the log text to stdout.
+//
+// Usage: log_cat [FILE...]
+//
+// Reads stdin if no files are given. Damaged blocks, and a truncated last
+// block (as left behind by a crash), are skipped, and reported on stderr.
+// Exits with status 1 if any file could not be opened, or was damaged.
+
+#include <stdio.h>
+#include <string.h>
+
+#include <string>
+
+#include "roo_logging/compressed_file_sink.h"
+
+namespace {
+
+bool Cat(FILE* in, const char* name) {
+  roo_logging::compressed_log::Reader reader(in);
+  std::string text;
+  while (reader.next(text)) {
+    fwrite(text.data(), 1, text.size(), stdout);
+    text.clear();
+  }
+  if (reader.damaged() > 0) {
+    fprintf(stderr, "%s: skipped %llu damaged blocks\n", name,
+            (unsigned long long)reader.damaged());
+  }
+  if (reader.truncated()) {
+    fprintf(stderr, "%s: the last block is incomplete\n", name);
+  }
+  return reader.damaged() == 0;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  if (argc > 1 && argv[1][0] == '-' && argv[1][1] != '\0') {
+    fprintf(stderr, "Usage: log_cat [FILE...]\n");
+    return 2;
+  }
+  if (argc == 1) return Cat(stdin, "stdin") ? 0 : 1;
+  bool ok = true;
+  for (int i = 1; i < argc; ++i) {
+    if (strcmp(argv[i], "-") == 0) {
+      ok &= Cat(stdin, "stdin");
+      continue;
+    }
+    FILE* in = fopen(argv[i], "rb");
+    if (in == nullptr) {
+      perror(argv[i]);
+      ok = false;
+      continue;
+    }
+    ok &= Cat(in, argv[i]);
+    fclose(in);
+  }
+  return ok ? 0 : 1;
+}
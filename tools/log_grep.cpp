@@ -0,0 +1,334 @@
+// Searches roo_logging text logs (as written to stderr, or by FileSink), in
+// parallel, filtering by severity, time range, source file, and message
+// text. Unlike grep, it understands the log line format, so that multi-line
+// messages are matched, and printed, as a whole.
+//
+// Usage: log_grep [OPTIONS] FILE...
+//
+//   -f FROM       Earliest time to include, e.g. 2026-10-18T14:02:00, or
+//                 S+000000.01:30:00 (uptime). Times without a UTC offset are
+//                 in UTC.
+//   -t TO         Latest time to include. Same format as FROM.
+//   -s SEVERITY   Minimum severity: INFO, WARNING, ERROR, FATAL, or the first
+//                 letter.
+//   -F FILE       Only include messages logged from the specified source file
+//                 (base name), and optionally line (FILE:LINE).
+//   -m TEXT       Only include messages containing TEXT.
+//   -e REGEX      Only include messages matching the (POSIX extended) REGEX.
+//   -i            Ignore case in -m and -e.
+//   -c            Print only the number of matching messages.
+//   -j THREADS    Number of threads. Default: the number of cores.
+//
+// Files are memory-mapped, and split into chunks (at message boundaries),
+// which are searched in parallel. The output is in the order of the input.
+
+#include <ctype.h>
+#include <fcntl.h>
+#include <regex.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "roo_logging.h"
+#include "roo_logging/log_line.h"
+
+namespace {
+
+struct Query {
+  // The filters that depend on the first line of a message.
+  roo_logging::LogLineFilter header;
+  std::string text;
+  bool has_regex = false;
+  regex_t regex;
+  bool ignore_case = false;
+  bool count_only = false;
+};
+
+static constexpr size_t kMinChunkSize = 1 << 20;
+
+void Usage() {
+  fprintf(stderr,
+          "Usage: log_grep [-f FROM] [-t TO] [-s SEVERITY] [-F FILE[:LINE]] "
+          "[-m TEXT] [-e REGEX] [-i] [-c] [-j THREADS] FILE...\n");
+  exit(2);
+}
+
+bool IsRecordStart(const char* begin, const char* end) {
+  roo_logging::LogLine line;
+  return roo_logging::ParseLogLine(begin, end - begin, line);
+}
+
+const char* NextLine(const char* p, const char* end) {
+  const char* eol = static_cast<const char*>(memchr(p, '\n', end - p));
+  return eol == nullptr ? end : eol + 1;
+}
+
+// Returns the end of the line starting at p, excluding the newline.
+const char* LineEnd(const char* p, const char* end) {
+  const char* eol = static_cast<const char*>(memchr(p, '\n', end - p));
+  return eol == nullptr ? end : eol;
+}
+
+bool ContainsText(const Query& query, const char* begin, const char* end) {
+  size_t n = query.text.size();
+  if (!query.ignore_case) {
+    return memmem(begin, end - begin, query.text.data(), n) != nullptr;
+  }
+  for (const char* p = begin; p + n <= end; ++p) {
+    size_t i = 0;
+    while (i < n && tolower((unsigned char)p[i]) ==
+                        tolower((unsigned char)query.text[i])) {
+      ++i;
+    }
+    if (i == n) return true;
+  }
+  return false;
+}
+
+// Checks the filters on the message text, which spans from the message on
+// the first line to the end of the last continuation line.
+bool TextMatches(const Query& query, const char* begin, const char* end,
+                 std::string& scratch) {
+  if (!query.text.empty() && !ContainsText(query, begin, end)) return false;
+  if (query.has_regex) {
+    scratch.assign(begin, end);
+    if (regexec(&query.regex, scratch.c_str(), 0, nullptr, 0) != 0) {
+      return false;
+    }
+  }
+  return true;
+}
+
+struct Chunk {
+  const char* begin;
+  const char* end;
+  std::string output;
+  uint64_t matches = 0;
+  bool done = false;
+};
+
+void SearchChunk(const Query& query, Chunk& chunk) {
+  std::string scratch;
+  const char* record = nullptr;  // Start of the current message.
+  const char* message = nullptr;
+  bool header_matches = false;
+  auto finish = [&](const char* record_end) {
+    if (record == nullptr || !header_matches) return;
+    const char* text_end = record_end;
+    if (text_end > message && text_end[-1] == '\n') --text_end;
+    if (!TextMatches(query, message, text_end, scratch)) return;
+    ++chunk.matches;
+    if (!query.count_only) chunk.output.append(record, record_end);
+  };
+  for (const char* p = chunk.begin; p < chunk.end;) {
+    const char* eol = LineEnd(p, chunk.end);
+    roo_logging::LogLine line;
+    if (roo_logging::ParseLogLine(p, eol - p, line)) {
+      finish(p);
+      record = p;
+      message = line.message;
+      header_matches = query.header.matches(line);
+    }
+    // Otherwise, a continuation line (or junk before the first message).
+    p = (eol < chunk.end) ? eol + 1 : eol;
+  }
+  finish(chunk.end);
+}
+
+// Splits the data into chunks of about chunk_size, each starting at the
+// beginning of a message (or of the data).
+std::vector<Chunk> Split(const char* data, size_t size, size_t chunk_size) {
+  std::vector<Chunk> chunks;
+  const char* end = data + size;
+  const char* begin = data;
+  while (begin < end) {
+    const char* p = (size_t)(end - begin) > chunk_size ? begin + chunk_size
+                                                       : end;
+    if (p < end) {
+      // Moves to the start of the next message.
+      p = NextLine(p, end);
+      while (p < end && !IsRecordStart(p, LineEnd(p, end))) {
+        p = NextLine(p, end);
+      }
+    }
+    chunks.emplace_back();
+    chunks.back().begin = begin;
+    chunks.back().end = p;
+    begin = p;
+  }
+  return chunks;
+}
+
+uint64_t Search(const Query& query, const char* data, size_t size,
+                int threads) {
+  size_t chunk_size = size / (threads * 8) + 1;
+  if (chunk_size < kMinChunkSize) chunk_size = kMinChunkSize;
+  std::vector<Chunk> chunks = Split(data, size, chunk_size);
+
+  // Workers take chunks in order, but stay at most max_ahead chunks ahead of
+  // the writer, to bound the memory held by the pending output.
+  const size_t max_ahead = threads * 4;
+  std::mutex mutex;
+  std::condition_variable cv;
+  size_t next_chunk = 0;  // Guarded by mutex.
+  size_t written = 0;     // Guarded by mutex.
+  auto worker = [&] {
+    while (true) {
+      size_t i;
+      {
+        std::unique_lock<std::mutex> lock(mutex);
+        cv.wait(lock, [&] {
+          return next_chunk >= chunks.size() ||
+                 next_chunk < written + max_ahead;
+        });
+        if (next_chunk >= chunks.size()) return;
+        i = next_chunk++;
+      }
+      SearchChunk(query, chunks[i]);
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        chunks[i].done = true;
+      }
+      cv.notify_all();
+    }
+  };
+  std::vector<std::thread> workers;
+  for (int t = 0; t < threads; ++t) workers.emplace_back(worker);
+
+  uint64_t matches = 0;
+  for (size_t i = 0; i < chunks.size(); ++i) {
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      cv.wait(lock, [&] { return chunks[i].done; });
+    }
+    fwrite(chunks[i].output.data(), 1, chunks[i].output.size(), stdout);
+    matches += chunks[i].matches;
+    std::string().swap(chunks[i].output);
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      written = i + 1;
+    }
+    cv.notify_all();
+  }
+  for (std::thread& t : workers) t.join();
+  return matches;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  Query query;
+  bool from_walltime = true;
+  bool to_walltime = true;
+  bool has_from = false;
+  bool has_to = false;
+  const char* regex = nullptr;
+  int threads = std::thread::hardware_concurrency();
+  int opt;
+  while ((opt = getopt(argc, argv, "f:t:s:F:m:e:icj:")) != -1) {
+    switch (opt) {
+      case 'f':
+        if (!roo_logging::ParseTimeArg(optarg, from_walltime,
+                                       query.header.from_us)) {
+          fprintf(stderr, "Invalid time: %s\n", optarg);
+          return 2;
+        }
+        has_from = true;
+        break;
+      case 't':
+        if (!roo_logging::ParseTimeArg(optarg, to_walltime,
+                                       query.header.to_us)) {
+          fprintf(stderr, "Invalid time: %s\n", optarg);
+          return 2;
+        }
+        has_to = true;
+        break;
+      case 's':
+        query.header.min_severity = roo_logging::ParseSeverity(optarg);
+        if (query.header.min_severity < 0) {
+          fprintf(stderr, "Invalid severity: %s\n", optarg);
+          return 2;
+        }
+        break;
+      case 'F':
+        query.header.setFile(optarg);
+        break;
+      case 'm':
+        query.text = optarg;
+        break;
+      case 'e':
+        regex = optarg;
+        break;
+      case 'i':
+        query.ignore_case = true;
+        break;
+      case 'c':
+        query.count_only = true;
+        break;
+      case 'j':
+        threads = atoi(optarg);
+        break;
+      default:
+        Usage();
+    }
+  }
+  if (optind == argc) Usage();
+  if (threads < 1) threads = 1;
+  if (has_from && has_to && from_walltime != to_walltime) {
+    fprintf(stderr, "FROM and TO must both be wall times, or uptimes\n");
+    return 2;
+  }
+  query.header.has_time_range = has_from || has_to;
+  query.header.walltime = has_from ? from_walltime : to_walltime;
+  if (regex != nullptr) {
+    int flags = REG_EXTENDED | REG_NOSUB | (query.ignore_case ? REG_ICASE : 0);
+    int error = regcomp(&query.regex, regex, flags);
+    if (error != 0) {
+      char message[256];
+      regerror(error, &query.regex, message, sizeof(message));
+      fprintf(stderr, "Invalid regex: %s\n", message);
+      return 2;
+    }
+    query.has_regex = true;
+  }
+
+  bool ok = true;
+  uint64_t matches = 0;
+  for (int i = optind; i < argc; ++i) {
+    int fd = open(argv[i], O_RDONLY | O_CLOEXEC);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) != 0) {
+      perror(argv[i]);
+      if (fd >= 0) close(fd);
+      ok = false;
+      continue;
+    }
+    if (st.st_size == 0) {
+      close(fd);
+      continue;
+    }
+    void* data = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+      perror(argv[i]);
+      ok = false;
+      continue;
+    }
+    madvise(data, st.st_size, MADV_SEQUENTIAL);
+    matches +=
+        Search(query, static_cast<const char*>(data), st.st_size, threads);
+    munmap(data, st.st_size);
+  }
+  if (query.count_only) printf("%llu\n", (unsigned long long)matches);
+  if (query.has_regex) regfree(&query.regex);
+  return ok ? 0 : 1;
+}
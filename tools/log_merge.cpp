@@ -0,0 +1,189 @@
+// Merges roo_logging text logs (e.g. from several sinks, or several files)
+// into one, ordered by the global sequence numbers of the messages, i.e. in
+// the order in which the messages were created, rather than written. Requires
+// logs written with the roo_logging_log_sequence flag set.
+//
+// Usage: log_merge [-u] [-w WINDOW] FILE...
+//
+//   -u         Drop messages with a sequence number that was already printed,
+//              e.g. when merging the outputs of sinks that got the same
+//              messages.
+//   -w WINDOW  How far (in messages) each file may be out of sequence order.
+//              Default: 10000.
+//
+// Messages without a sequence number (e.g. summaries of repeated messages)
+// stay after the message that precedes them in their file. Multi-line
+// messages are kept together. Sequence numbers restart when the program
+// does, so the files should come from a single run.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <queue>
+#include <string>
+#include <vector>
+
+#include "roo_logging.h"
+#include "roo_logging/log_line.h"
+
+namespace {
+
+struct Record {
+  // The sequence number of the message, or, if it has none, of the preceding
+  // message in the same file.
+  uint64_t sequence;
+  bool has_sequence;
+  size_t file;
+  // Position in the file.
+  uint64_t order;
+  std::string text;
+};
+
+struct Later {
+  bool operator()(const Record* a, const Record* b) const {
+    if (a->sequence != b->sequence) return a->sequence > b->sequence;
+    if (a->file != b->file) return a->file > b->file;
+    return a->order > b->order;
+  }
+};
+
+// Reads a log file, one message (with its continuation lines) at a time.
+class Input {
+ public:
+  Input(FILE* in, size_t index)
+      : buffered(0), in_(in), index_(index), buf_(nullptr), buf_size_(0),
+        count_(0), sequence_(0) {
+    readLine();
+  }
+
+  ~Input() {
+    free(buf_);
+    fclose(in_);
+  }
+
+  // Returns the next message, or nullptr at the end of the file.
+  Record* next() {
+    if (line_.empty()) return nullptr;
+    Record* record = new Record;
+    roo_logging::LogLine parsed;
+    size_t len = line_.size();
+    if (line_[len - 1] == '\n') --len;
+    if (roo_logging::ParseLogLine(line_.data(), len, parsed) &&
+        parsed.sequence != 0) {
+      sequence_ = parsed.sequence;
+      record->has_sequence = true;
+    } else {
+      record->has_sequence = false;
+    }
+    record->sequence = sequence_;
+    record->file = index_;
+    record->order = count_++;
+    record->text.swap(line_);
+    // Appends the continuation lines.
+    while (readLine() && !isLogLine()) record->text.append(line_);
+    return record;
+  }
+
+  // Number of messages from this file waiting to be printed.
+  size_t buffered;
+
+ private:
+  // Reads the next line into line_. Returns false at the end of the file.
+  bool readLine() {
+    ssize_t len = getline(&buf_, &buf_size_, in_);
+    if (len <= 0) {
+      line_.clear();
+      return false;
+    }
+    line_.assign(buf_, len);
+    return true;
+  }
+
+  bool isLogLine() const {
+    roo_logging::LogLine parsed;
+    size_t len = line_.size();
+    if (len > 0 && line_[len - 1] == '\n') --len;
+    return roo_logging::ParseLogLine(line_.data(), len, parsed);
+  }
+
+  FILE* in_;
+  size_t index_;
+  char* buf_;
+  size_t buf_size_;
+  uint64_t count_;
+  uint64_t sequence_;
+  // The first line of the next message.
+  std::string line_;
+};
+
+void Usage() {
+  fprintf(stderr, "Usage: log_merge [-u] [-w WINDOW] FILE...\n");
+  exit(2);
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  bool unique = false;
+  size_t window = 10000;
+  int opt;
+  while ((opt = getopt(argc, argv, "uw:")) != -1) {
+    switch (opt) {
+      case 'u':
+        unique = true;
+        break;
+      case 'w':
+        window = strtoul(optarg, nullptr, 10);
+        if (window < 1) window = 1;
+        break;
+      default:
+        Usage();
+    }
+  }
+  if (optind == argc) Usage();
+  std::vector<Input*> inputs;
+  for (int i = optind; i < argc; ++i) {
+    FILE* in = fopen(argv[i], "r");
+    if (in == nullptr) {
+      perror(argv[i]);
+      return 1;
+    }
+    inputs.push_back(new Input(in, inputs.size()));
+  }
+
+  std::priority_queue<Record*, std::vector<Record*>, Later> queue;
+  // Keeps up to `window` messages from each file in the queue, so that a
+  // message that is out of order by less than that is printed in order.
+  auto fill = [&](Input* input) {
+    while (input->buffered < window) {
+      Record* record = input->next();
+      if (record == nullptr) break;
+      queue.push(record);
+      ++input->buffered;
+    }
+  };
+  for (Input* input : inputs) fill(input);
+  bool printed_any = false;
+  uint64_t last_printed = 0;
+  while (!queue.empty()) {
+    Record* record = queue.top();
+    queue.pop();
+    if (record->has_sequence) {
+      if (!(unique && printed_any && record->sequence == last_printed)) {
+        fwrite(record->text.data(), 1, record->text.size(), stdout);
+      }
+      printed_any = true;
+      last_printed = record->sequence;
+    } else {
+      fwrite(record->text.data(), 1, record->text.size(), stdout);
+    }
+    Input* input = inputs[record->file];
+    --input->buffered;
+    delete record;
+    fill(input);
+  }
+  for (Input* input : inputs) delete input;
+  return 0;
+}
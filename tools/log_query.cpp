@@ -0,0 +1,185 @@
+// Extracts a time range from log files written by roo_logging::FileSink,
+// using their time indexes (see file_sink.h) to seek directly to the range,
+// and optionally filters by severity, and by source file.
+//
+// Usage: log_query [-f FROM] [-t TO] [-s SEVERITY] [-F FILE[:LINE]] [-v]
+//                  LOGFILE...
+//
+//   -f FROM      Earliest time to include, e.g. 2026-10-18T14:02:00, or
+//                2026-10-18T14:02:00+02:00, or (for logs without wall time)
+//                S+000000.01:30:00. Times without a UTC offset are in UTC.
+//   -t TO        Latest time to include. Same format as FROM.
+//   -s SEVERITY  Minimum severity: INFO, WARNING, ERROR, FATAL, or the first
+//                letter.
+//   -F FILE      Only include messages logged from the specified source file
+//                (base name), and optionally line.
+//   -v           Report how much of each log file was scanned, on stderr.
+//
+// List rotated segments oldest first, e.g. app.log.2 app.log.1 app.log. Files
+// without a valid index are scanned from the start. The index assumes that
+// time does not go back within a segment (uptime does, after a restart; so
+// uptime ranges work reliably only for a single run).
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <limits>
+#include <string>
+#include <vector>
+
+#include "roo_logging.h"
+#include "roo_logging/file_sink.h"
+#include "roo_logging/log_line.h"
+
+namespace {
+
+struct Query {
+  roo_logging::LogLineFilter filter;
+  bool verbose = false;
+};
+
+void Usage() {
+  fprintf(stderr,
+          "Usage: log_query [-f FROM] [-t TO] [-s SEVERITY] [-F FILE[:LINE]] "
+          "[-v] LOGFILE...\n");
+  exit(2);
+}
+
+// Reads the index of the log file, if there is one, and it belongs to the
+// file.
+std::vector<roo_logging::log_index::IndexEntry> ReadIndex(
+    const char* path, const struct stat& st) {
+  std::vector<roo_logging::log_index::IndexEntry> entries;
+  FILE* index = fopen((std::string(path) + ".idx").c_str(), "rb");
+  if (index == nullptr) return entries;
+  roo_logging::log_index::IndexHeader header;
+  if (fread(&header, sizeof(header), 1, index) == 1 &&
+      header.magic == roo_logging::log_index::kMagic &&
+      header.version == roo_logging::log_index::kVersion &&
+      header.device == (uint64_t)st.st_dev &&
+      header.inode == (uint64_t)st.st_ino) {
+    roo_logging::log_index::IndexEntry entry;
+    while (fread(&entry, sizeof(entry), 1, index) == 1) {
+      entries.push_back(entry);
+    }
+  }
+  fclose(index);
+  return entries;
+}
+
+bool Scan(const Query& query, const char* path) {
+  FILE* in = fopen(path, "r");
+  struct stat st;
+  if (in == nullptr || fstat(fileno(in), &st) != 0) {
+    perror(path);
+    if (in != nullptr) fclose(in);
+    return false;
+  }
+  uint64_t start = 0;
+  uint64_t stop = std::numeric_limits<uint64_t>::max();
+  if (query.filter.has_time_range) {
+    for (const auto& entry : ReadIndex(path, st)) {
+      int64_t time_us =
+          query.filter.walltime ? entry.walltime_us : entry.uptime_us;
+      if (query.filter.walltime && time_us == 0) {
+        // No wall time in this part of the log.
+        start = 0;
+        stop = std::numeric_limits<uint64_t>::max();
+        break;
+      }
+      if (time_us < query.filter.from_us) {
+        // Lines before the next entry may still be in range.
+        start = entry.offset;
+      } else if (time_us > query.filter.to_us) {
+        // This line, and all that follow, are past the range.
+        stop = entry.offset;
+        break;
+      }
+    }
+    if (start > (uint64_t)st.st_size) start = st.st_size;
+  }
+  fseeko(in, start, SEEK_SET);
+  char* buf = nullptr;
+  size_t buf_size = 0;
+  uint64_t pos = start;
+  bool printing = false;
+  while (pos < stop) {
+    ssize_t len = getline(&buf, &buf_size, in);
+    if (len <= 0) break;
+    pos += len;
+    size_t text_len = len;
+    if (buf[text_len - 1] == '\n') --text_len;
+    roo_logging::LogLine line;
+    if (roo_logging::ParseLogLine(buf, text_len, line)) {
+      printing = query.filter.matches(line);
+    }
+    // Continuation lines go with the message that they continue.
+    if (printing) fwrite(buf, 1, len, stdout);
+  }
+  free(buf);
+  fclose(in);
+  if (query.verbose) {
+    fprintf(stderr, "%s: scanned %llu of %llu bytes\n", path,
+            (unsigned long long)(pos - start), (unsigned long long)st.st_size);
+  }
+  return true;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  Query query;
+  bool from_walltime = true;
+  bool to_walltime = true;
+  bool has_from = false;
+  bool has_to = false;
+  int opt;
+  while ((opt = getopt(argc, argv, "f:t:s:F:v")) != -1) {
+    switch (opt) {
+      case 'f':
+        if (!roo_logging::ParseTimeArg(optarg, from_walltime,
+                                       query.filter.from_us)) {
+          fprintf(stderr, "Invalid time: %s\n", optarg);
+          return 2;
+        }
+        has_from = true;
+        break;
+      case 't':
+        if (!roo_logging::ParseTimeArg(optarg, to_walltime,
+                                       query.filter.to_us)) {
+          fprintf(stderr, "Invalid time: %s\n", optarg);
+          return 2;
+        }
+        has_to = true;
+        break;
+      case 's':
+        query.filter.min_severity = roo_logging::ParseSeverity(optarg);
+        if (query.filter.min_severity < 0) {
+          fprintf(stderr, "Invalid severity: %s\n", optarg);
+          return 2;
+        }
+        break;
+      case 'F':
+        query.filter.setFile(optarg);
+        break;
+      case 'v':
+        query.verbose = true;
+        break;
+      default:
+        Usage();
+    }
+  }
+  if (optind == argc) Usage();
+  if (has_from && has_to && from_walltime != to_walltime) {
+    fprintf(stderr, "FROM and TO must both be wall times, or uptimes\n");
+    return 2;
+  }
+  query.filter.has_time_range = has_from || has_to;
+  query.filter.walltime = has_from ? from_walltime : to_walltime;
+  bool ok = true;
+  for (int i = optind; i < argc; ++i) ok &= Scan(query, argv[i]);
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,70 @@
+// Recovers the log from a ring log file, written by roo_logging::MmapRingSink
+// (e.g. after the writer crashed), and writes it to stdout, oldest records
+// first.
+//
+// Usage: mmap_ring_reader [-n COUNT] FILE
+//
+//   -n COUNT  Write only the newest COUNT records.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "roo_logging.h"
+#include "roo_logging/log_line.h"
+#include "roo_logging/mmap_ring.h"
+
+namespace {
+
+void Usage() {
+  fprintf(stderr, "Usage: mmap_ring_reader [-n COUNT] FILE\n");
+  exit(2);
+}
+
+void WriteRecord(const roo_logging::MmapRingReader::Record& r) {
+  char prefix[128];
+  size_t prefix_len = roo_logging::FormatLogPrefix(
+      prefix, sizeof(prefix), r.severity, r.uptime, r.walltime, 0, nullptr,
+      r.base_filename, r.base_filename_len, r.line);
+  fwrite(prefix, 1, prefix_len, stdout);
+  fwrite(r.message, 1, r.message_len, stdout);
+  fputc('\n', stdout);
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  size_t count = (size_t)-1;
+  int opt;
+  while ((opt = getopt(argc, argv, "n:")) != -1) {
+    switch (opt) {
+      case 'n':
+        count = strtoull(optarg, nullptr, 10);
+        break;
+      default:
+        Usage();
+    }
+  }
+  if (optind != argc - 1) Usage();
+  const char* path = argv[optind];
+
+  roo_logging::MmapRingReader reader(path);
+  if (!reader.ok()) {
+    fprintf(stderr, "%s: not a ring log file\n", path);
+    return 1;
+  }
+  const auto& records = reader.records();
+  size_t begin = records.size() > count ? records.size() - count : 0;
+  for (size_t i = begin; i < records.size(); ++i) {
+    if (i > begin && records[i].seq != records[i - 1].seq + 1) {
+      printf("[%llu records missing]\n",
+             (unsigned long long)(records[i].seq - records[i - 1].seq - 1));
+    }
+    WriteRecord(records[i]);
+  }
+  if (reader.missing() > 0) {
+    fprintf(stderr, "%s: %llu records missing (damaged)\n", path,
+            (unsigned long long)reader.missing());
+  }
+  return 0;
+}
@@ -0,0 +1,120 @@
+// Drains a shared-memory log ring, written by roo_logging::ShmRingSink, to
+// stdout or to a file.
+//
+// Usage: shm_log_consumer [-f] [-o FILE] NAME
+//
+//   -f       Follow: wait for the ring to appear, and for new records, until
+//            killed. Without it, the consumer exits once the ring is empty.
+//   -o FILE  Append to FILE instead of writing to stdout.
+//   NAME     The shared memory object name, e.g. /myapp_log.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <memory>
+
+#include "roo_logging.h"
+#include "roo_logging/log_line.h"
+#include "roo_logging/shm_ring.h"
+
+namespace {
+
+void Usage() {
+  fprintf(stderr, "Usage: shm_log_consumer [-f] [-o FILE] NAME\n");
+  exit(2);
+}
+
+void WriteRecord(FILE* out, const roo_logging::ShmRingReader::Record& r) {
+  char prefix[128];
+  size_t prefix_len = roo_logging::FormatLogPrefix(
+      prefix, sizeof(prefix), r.severity, r.uptime, r.walltime, 0, nullptr,
+      r.base_filename, r.base_filename_len, r.line);
+  fwrite(prefix, 1, prefix_len, out);
+  fwrite(r.message, 1, r.message_len, out);
+  fputc('\n', out);
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  bool follow = false;
+  const char* output = nullptr;
+  int opt;
+  while ((opt = getopt(argc, argv, "fo:")) != -1) {
+    switch (opt) {
+      case 'f':
+        follow = true;
+        break;
+      case 'o':
+        output = optarg;
+        break;
+      default:
+        Usage();
+    }
+  }
+  if (optind != argc - 1) Usage();
+  const char* name = argv[optind];
+
+  FILE* out = stdout;
+  if (output != nullptr) {
+    out = fopen(output, "a");
+    if (out == nullptr) {
+      perror(output);
+      return 1;
+    }
+  }
+
+  std::unique_ptr<roo_logging::ShmRingReader> reader;
+  uint64_t dropped = 0;
+  while (true) {
+    if (reader == nullptr || !reader->ok()) {
+      reader.reset(new roo_logging::ShmRingReader(name));
+      if (!reader->ok()) {
+        if (!follow) {
+          fprintf(stderr, "%s: no such log ring\n", name);
+          return 1;
+        }
+        usleep(100000);
+        continue;
+      }
+      dropped = reader->dropped();
+    }
+    roo_logging::ShmRingReader::Record record;
+    bool any = false;
+    while (reader->next(record)) {
+      WriteRecord(out, record);
+      any = true;
+    }
+    uint64_t now_dropped = reader->dropped();
+    if (now_dropped != dropped) {
+      fprintf(out, "[%llu records dropped]\n",
+              (unsigned long long)(now_dropped - dropped));
+      dropped = now_dropped;
+      any = true;
+    }
+    if (any) {
+      fflush(out);
+      continue;
+    }
+    if (!reader->producer_alive()) {
+      if (!follow) {
+        if (reader->pending() > 0) {
+          fprintf(stderr,
+                  "%s: producer is gone; %llu bytes of incomplete records\n",
+                  name, (unsigned long long)reader->pending());
+        }
+        break;
+      }
+      if (reader->replaced()) {
+        reader.reset();
+        continue;
+      }
+    } else if (!follow) {
+      break;
+    }
+    usleep(10000);
+  }
+  if (out != stdout) fclose(out);
+  return 0;
+}